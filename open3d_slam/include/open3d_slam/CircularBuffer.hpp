@@ -6,60 +6,149 @@
  */
 
 #pragma once
+#include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <mutex>
 
 namespace o3d_slam {
 
+// Thread safe fifo, pushing beyond the size limit drops the oldest element.
+// Consumers can block until data arrives (waitAndPop) and producers until there is
+// space (waitUntilSizeBelow), so the worker threads do not have to poll.
 template<typename T>
 class CircularBuffer {
 
 public:
 	CircularBuffer() = default;
 	void set_size_limit(size_t size) {
+		std::lock_guard<std::mutex> lck(mutex_);
 		bufferSizeLimit_ = size;
 		removeOldMeasurementsIfNeeded();
 	}
 
 	void push(const T &data) {
+		push(T(data));
+	}
+
+	void push(T &&data) {
 		{
-			std::lock_guard<std::mutex> lck(pushMutex_);
-			data_.push_back(data);
+			std::lock_guard<std::mutex> lck(mutex_);
+			data_.push_back(std::move(data));
+			removeOldMeasurementsIfNeeded();
 		}
-		removeOldMeasurementsIfNeeded();
+		notEmpty_.notify_one();
 	}
 
-	const T& peek_front() const {
+	T peek_front() const {
+		std::lock_guard<std::mutex> lck(mutex_);
 		return data_.front();
 	}
 
-	const T& peek_back() const {
+	T peek_back() const {
+		std::lock_guard<std::mutex> lck(mutex_);
 		return data_.back();
 	}
 
+	// check and read under one lock, other threads may drain the buffer in between separate calls
+	bool tryPeekBack(T *out) const {
+		std::lock_guard<std::mutex> lck(mutex_);
+		if (data_.empty()) {
+			return false;
+		}
+		*out = data_.back();
+		return true;
+	}
+
+	bool tryPop(T *out) {
+		{
+			std::lock_guard<std::mutex> lck(mutex_);
+			if (data_.empty()) {
+				return false;
+			}
+			*out = std::move(data_.front());
+			data_.pop_front();
+		}
+		sizeDecreased_.notify_all();
+		return true;
+	}
+
 	T pop() {
-		std::lock_guard<std::mutex> lck(removeMutex_);
-		T copy = data_.front();
-		data_.pop_front();
-		return copy;
+		T front;
+		{
+			std::lock_guard<std::mutex> lck(mutex_);
+			front = std::move(data_.front());
+			data_.pop_front();
+		}
+		sizeDecreased_.notify_all();
+		return front;
+	}
+
+	// returns false if nothing arrived within the timeout or if wakeUp() was called
+	template<typename Rep, typename Period>
+	bool waitAndPop(T *out, const std::chrono::duration<Rep, Period> &timeout) {
+		{
+			std::unique_lock<std::mutex> lck(mutex_);
+			const size_t wakeUpCount = wakeUpCount_;
+			notEmpty_.wait_for(lck, timeout, [this, wakeUpCount]() {
+				return !data_.empty() || wakeUpCount_ != wakeUpCount;
+			});
+			if (data_.empty()) {
+				return false;
+			}
+			*out = std::move(data_.front());
+			data_.pop_front();
+		}
+		sizeDecreased_.notify_all();
+		return true;
+	}
+
+	template<typename Rep, typename Period>
+	bool waitUntilSizeBelow(size_t size, const std::chrono::duration<Rep, Period> &timeout) const {
+		std::unique_lock<std::mutex> lck(mutex_);
+		return sizeDecreased_.wait_for(lck, timeout, [this, size]() {
+			return data_.size() < size;
+		});
+	}
+
+	template<typename Rep, typename Period>
+	bool waitUntilEmpty(const std::chrono::duration<Rep, Period> &timeout) const {
+		return waitUntilSizeBelow(1, timeout);
+	}
+
+	// makes the threads blocked in waitAndPop return
+	void wakeUp() {
+		{
+			std::lock_guard<std::mutex> lck(mutex_);
+			++wakeUpCount_;
+		}
+		notEmpty_.notify_all();
 	}
 
 	bool empty() const {
+		std::lock_guard<std::mutex> lck(mutex_);
 		return data_.empty();
 	}
 
 	size_t size_limit() const {
+		std::lock_guard<std::mutex> lck(mutex_);
 		return bufferSizeLimit_;
 	}
 
 	size_t size() const {
+		std::lock_guard<std::mutex> lck(mutex_);
 		return data_.size();
 	}
 
 	void clear() {
-		std::lock_guard<std::mutex> lck(removeMutex_);
-		data_.clear();
+		{
+			std::lock_guard<std::mutex> lck(mutex_);
+			data_.clear();
+		}
+		sizeDecreased_.notify_all();
 	}
 
+	// not synchronized, only use when no other thread touches the buffer
 	const std::deque<T>& getImplementation() const {
 		return data_;
 	}
@@ -70,15 +159,18 @@ public:
 
 private:
 
+	// mutex_ has to be held
 	void removeOldMeasurementsIfNeeded() {
-		std::lock_guard<std::mutex> lck(removeMutex_);
 		while (data_.size() > bufferSizeLimit_) {
 			data_.pop_front();
 		}
 	}
 
 	std::deque<T> data_;
-	std::mutex removeMutex_, pushMutex_;
+	mutable std::mutex mutex_;
+	std::condition_variable notEmpty_;
+	mutable std::condition_variable sizeDecreased_;
+	size_t wakeUpCount_ = 0;
 	size_t bufferSizeLimit_ = 10;
 };
 
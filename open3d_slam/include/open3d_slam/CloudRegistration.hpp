@@ -16,6 +16,9 @@
 
 namespace o3d_slam {
 
+class IncrementalKdTree;
+class CroppingVolume;
+
 class CloudRegistration {
 public:
 	using RegistrationResult = open3d::pipelines::registration::RegistrationResult;
@@ -25,7 +28,19 @@ public:
 	virtual RegistrationResult registerClouds(const PointCloud &source, const PointCloud &target,
 			const Transform &init) const = 0;
 	virtual void estimateNormalsOrCovariancesIfNeeded(PointCloud *cloud) const {}
-
+	// false if no normals are estimated
+	virtual bool getNormalEstimationParameters(int *knn, double *maxRadius) const {
+		return false;
+	}
+	// registers the source directly against the point index, no kd tree gets built over the target.
+	// Target indices in the correspondence set refer to the order in which correspondences were found.
+	// Only the target points within targetVolume are matched, same as cropping the target,
+	// targetVolume can be nullptr.
+	virtual RegistrationResult registerCloudToIndex(const PointCloud &source, const IncrementalKdTree &target,
+			const CroppingVolume *targetVolume, const Transform &init) const;
+	virtual bool isIndexedTargetSupported() const {
+		return false;
+	}
 
 };
 
@@ -37,6 +52,16 @@ public:
 	RegistrationResult registerClouds(const PointCloud &source, const PointCloud &target,
 			const Transform &init) const final;
 	void estimateNormalsOrCovariancesIfNeeded(PointCloud *cloud) const final;
+	bool getNormalEstimationParameters(int *knn, double *maxRadius) const final {
+		*knn = knnNormalEstimation_;
+		*maxRadius = maxRadiusNormalEstimation_;
+		return true;
+	}
+	RegistrationResult registerCloudToIndex(const PointCloud &source, const IncrementalKdTree &target,
+			const CroppingVolume *targetVolume, const Transform &init) const final;
+	bool isIndexedTargetSupported() const final {
+		return true;
+	}
 
 	double maxCorrespondenceDistance_ = 1.0;
 	int knnNormalEstimation_ = 10;
@@ -52,6 +77,11 @@ public:
 	~RegistrationIcpPointToPoint() override = default;
 	RegistrationResult registerClouds(const PointCloud &source, const PointCloud &target,
 			const Transform &init) const final;
+	RegistrationResult registerCloudToIndex(const PointCloud &source, const IncrementalKdTree &target,
+			const CroppingVolume *targetVolume, const Transform &init) const final;
+	bool isIndexedTargetSupported() const final {
+		return true;
+	}
 
 	double maxCorrespondenceDistance_ = 1.0;
 	open3d::pipelines::registration::ICPConvergenceCriteria icpConvergenceCriteria_;
@@ -65,6 +95,11 @@ public:
 	RegistrationResult registerClouds(const PointCloud &source, const PointCloud &target,
 			const Transform &init) const final;
 	void estimateNormalsOrCovariancesIfNeeded(PointCloud *cloud) const final;
+	bool getNormalEstimationParameters(int *knn, double *maxRadius) const final {
+		*knn = knnNormalEstimation_;
+		*maxRadius = maxRadiusNormalEstimation_;
+		return true;
+	}
 
 	double maxCorrespondenceDistance_ = 1.0;
 	int knnNormalEstimation_ = 10;
@@ -73,6 +108,30 @@ public:
 	open3d::pipelines::registration::TransformationEstimationForGeneralizedICP tranformationEstimationGICP_;
 };
 
+// Point to plane ICP that looks for correspondences in the neighbouring voxels of a voxel hash map
+// built over the target (KISS-ICP style), no kd tree involved. The normal equations are accumulated in parallel.
+class RegistrationVoxelHashIcpPointToPlane: public CloudRegistration {
+public:
+	using RegistrationResult = open3d::pipelines::registration::RegistrationResult;
+	RegistrationVoxelHashIcpPointToPlane() = default;
+	~RegistrationVoxelHashIcpPointToPlane() override = default;
+	RegistrationResult registerClouds(const PointCloud &source, const PointCloud &target,
+			const Transform &init) const final;
+	void estimateNormalsOrCovariancesIfNeeded(PointCloud *cloud) const final;
+	bool getNormalEstimationParameters(int *knn, double *maxRadius) const final {
+		*knn = knnNormalEstimation_;
+		*maxRadius = maxRadiusNormalEstimation_;
+		return true;
+	}
+
+	double maxCorrespondenceDistance_ = 1.0;
+	int knnNormalEstimation_ = 10;
+	double maxRadiusNormalEstimation_ = 2.0;
+	int maxNumIter_ = 30;
+	double minIncrementNorm_ = 1e-6;
+};
+
+std::unique_ptr<RegistrationVoxelHashIcpPointToPlane> createVoxelHashPointToPlaneIcp(const CloudRegistrationParameters &p);
 std::unique_ptr<RegistrationIcpGeneralized> createGeneralizedIcp(const CloudRegistrationParameters &p);
 std::unique_ptr<RegistrationIcpPointToPoint> createPointToPointIcp(const CloudRegistrationParameters &p);
 std::unique_ptr<RegistrationIcpPointToPlane> createPointToPlaneIcp(const CloudRegistrationParameters &p);
@@ -0,0 +1,85 @@
+/*
+ * IncrementalKdTree.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+#include "open3d_slam/typedefs.hpp"
+
+namespace o3d_slam {
+
+class CroppingVolume;
+
+// Kd tree that supports point insertion and deletion without rebuilding the whole tree (ikd-tree style).
+// Deleted points are only marked and dropped once their subtree gets rebuilt. A subtree is rebuilt
+// when it becomes unbalanced or when too many of its points are deleted, so the cost is amortized
+// over the insertions. Points are stored by value (together with the normal), deletion is by exact position.
+class IncrementalKdTree {
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	struct Neighbor {
+		Eigen::Vector3d point_ = Eigen::Vector3d::Zero();
+		Eigen::Vector3d normal_ = Eigen::Vector3d::Zero();
+		double squaredDistance_ = 0.0;
+	};
+
+	IncrementalKdTree() = default;
+	~IncrementalKdTree() = default;
+
+	void build(const PointCloud &cloud);
+	void insert(const PointCloud &cloud);
+	void insert(const Eigen::Vector3d &p, const Eigen::Vector3d &normal);
+	void remove(const PointCloud &cloud);
+	bool remove(const Eigen::Vector3d &p);
+	bool findNearest(const Eigen::Vector3d &query, double maxDistance, Neighbor *neighbor) const;
+	// nearest among the points within the volume, same as searching a tree built from the cropped points
+	bool findNearest(const Eigen::Vector3d &query, double maxDistance, const CroppingVolume *volume,
+			Neighbor *neighbor) const;
+	void clear();
+	size_t size() const;
+	bool empty() const;
+	bool hasNormals() const;
+
+private:
+	struct Node {
+		Eigen::Vector3d point_;
+		Eigen::Vector3d normal_;
+		Eigen::Vector3d minBound_;
+		Eigen::Vector3d maxBound_;
+		int32 left_ = -1;
+		int32 right_ = -1;
+		uint32 size_ = 1; // including the deleted ones
+		uint32 numDeleted_ = 0;
+		uint8 axis_ = 0;
+		bool isDeleted_ = false;
+	};
+
+	int32 createNode(const Eigen::Vector3d &p, const Eigen::Vector3d &normal);
+	int32 buildSubtree(std::vector<int32>::iterator begin, std::vector<int32>::iterator end);
+	void updateFromChildren(int32 id);
+	void collectSubtree(int32 id, std::vector<int32> *live);
+	void rebuildSubtree(size_t pathIdx);
+	void rebalanceAlongPath();
+	bool isUnbalanced(int32 id) const;
+	bool removeRecursive(int32 id, const Eigen::Vector3d &p);
+	void findNearestRecursive(int32 id, const Eigen::Vector3d &query, const CroppingVolume *volume, int32 *best,
+			double *bestSquaredDistance) const;
+	double squaredDistanceToBounds(const Node &node, const Eigen::Vector3d &p) const;
+
+	std::vector<Node> nodes_;
+	std::vector<int32> freeNodes_;
+	std::vector<int32> path_; // root to leaf, scratch for insertion and deletion
+	std::vector<int32> rebuildScratch_;
+	int32 root_ = -1;
+	size_t numLive_ = 0;
+	bool isHasNormals_ = false;
+};
+
+} // namespace o3d_slam
@@ -0,0 +1,75 @@
+/*
+ * MapFile.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/Transform.hpp"
+#include "open3d_slam/Voxel.hpp"
+
+namespace o3d_slam {
+
+// Versioned binary container for the submap point clouds of a whole map (*.o3dmap). Layout:
+//   header | submap table (fixed size records) | data arrays
+// The records only hold offsets and sizes of the arrays, every array starts at a 64 byte aligned
+// offset and is stored exactly as it is in memory (little endian doubles), so the file can be
+// mapped and read in place without any parsing. It only stores what the initial map needs, the
+// precomputed normals and covariances save the normal estimation at startup. The voxel index is not
+// stored, the initial map is voxelized and indexed again when it is inserted.
+struct MapFileSubmap {
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	int64 id_ = 0;
+	int64 parentId_ = 0;
+	Transform mapToSubmapOrigin_ = Transform::Identity();
+	Eigen::Vector3d mapToSubmapCenter_ = Eigen::Vector3d::Zero();
+	PointCloud map_; // with normals and covariances if they were computed
+};
+
+struct MapFileContent {
+	std::vector<MapFileSubmap> submaps_;
+};
+
+bool writeMapFile(const std::string &filename, const MapFileContent &content);
+
+// Read only memory mapping of a map file, the views stay valid as long as the object lives.
+class MapFileView {
+
+public:
+	struct SubmapView {
+		int64 id_ = 0;
+		int64 parentId_ = 0;
+		Transform mapToSubmapOrigin_ = Transform::Identity();
+		Eigen::Vector3d mapToSubmapCenter_ = Eigen::Vector3d::Zero();
+		ConstSpan<Eigen::Vector3d> points_, normals_, colors_;
+		ConstSpan<Eigen::Matrix3d> covariances_;
+	};
+
+	MapFileView() = default;
+	~MapFileView();
+	MapFileView(const MapFileView&) = delete;
+	MapFileView& operator=(const MapFileView&) = delete;
+
+	// false if the file cannot be mapped, has a different version or is truncated
+	bool open(const std::string &filename);
+	void close();
+	bool isOpen() const;
+	size_t getNumSubmaps() const;
+	const SubmapView& getSubmap(size_t idx) const;
+
+	PointCloud toPointCloud(size_t submapIdx) const;
+	// all the submaps in one cloud, normals and covariances are kept only if every submap has them
+	PointCloud toAssembledPointCloud() const;
+
+private:
+	const uint8 *data_ = nullptr;
+	size_t size_ = 0;
+	std::vector<SubmapView> submaps_;
+};
+
+} // namespace o3d_slam
@@ -19,6 +19,7 @@
 namespace o3d_slam {
 
 class ScanToMapRegistration;
+class ScanFeatureCache;
 
 class Mapper {
 
@@ -33,6 +34,7 @@ public:
 	void setParameters(const MapperParameters &p);
 	void setMapToRangeSensor(const Transform &t);
 	void setMapToRangeSensorInitial(const Transform &t);
+	void setScanFeatureCache(std::shared_ptr<ScanFeatureCache> cache);
 
 	const Submap& getActiveSubmap() const;
 	const SubmapCollection& getSubmaps() const;
@@ -67,6 +69,7 @@ private:
 	bool isNewInitialValueSet_ = false;
 	bool isIgnoreOdometryPrediction_ = false;
 	std::shared_ptr<ScanToMapRegistration> scan2MapReg_;
+	std::shared_ptr<ScanFeatureCache> scanFeatureCache_;
 
 };
 
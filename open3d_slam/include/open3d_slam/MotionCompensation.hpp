@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "open3d_slam/Parameters.hpp"
 #include "open3d_slam/typedefs.hpp"
 #include "open3d_slam/time.hpp"
@@ -21,8 +22,9 @@ public:
 	MotionCompensation() = default;
 	virtual ~MotionCompensation() = default;
 
+	// pointTimeOffsets are in sec relative to the timestamp, one per point. Empty if the sensor does not provide them.
 	virtual std::shared_ptr<PointCloud> undistortInputPointCloud(const PointCloud &input,
-			const Time &timestamp);
+			const Time &timestamp, const std::vector<float> &pointTimeOffsets);
 
 };
 
@@ -33,12 +35,27 @@ public:
 	~ConstantVelocityMotionCompensation() override = default;
 
 	void setParameters(const ConstantVelocityMotionCompensationParameters &p);
-	std::shared_ptr<PointCloud> undistortInputPointCloud(const PointCloud &input, const Time &timestamp) final;
+	// Every point is moved to the sensor pose at the timestamp. Uses the per point times if given, otherwise the time
+	// follows from the azimuth of the point and the scan duration. The poses are looked up once per time bin,
+	// the points only pick their bin.
+	std::shared_ptr<PointCloud> undistortInputPointCloud(const PointCloud &input, const Time &timestamp,
+			const std::vector<float> &pointTimeOffsets) final;
 
 
 private:
-	double computePhase(double x, double y);
-	void estimateLinearAndAngularVelocity(const Time &timestamp, Eigen::Vector3d *linearVelocity, Eigen::Vector3d *angularVelocity) const;
+	struct MotionLookupTable {
+		double beginTime_ = 0.0;
+		double binsPerSec_ = 0.0;
+		std::vector<Eigen::Matrix3d> rotations_;
+		std::vector<Eigen::Vector3d> translations_;
+	};
+
+	double computePhase(double x, double y) const;
+	// motion of the sensor between the timestamp and the time offsets in [beginTime, endTime]
+	void buildMotionLookupTable(const Time &timestamp, double beginTime, double endTime,
+			MotionLookupTable *table) const;
+	// relative motion over the last numPosesVelocityEstimation_ poses and its duration, false if the buffer is too short
+	bool estimateLatestMotion(Transform *motion, double *dt) const;
 
 	const TransformInterpolationBuffer &buffer_;
 	ConstantVelocityMotionCompensationParameters params_;
@@ -0,0 +1,70 @@
+/*
+ * OccupancyVoxelMap.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+#include "open3d_slam/Parameters.hpp"
+#include "open3d_slam/Transform.hpp"
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/Voxel.hpp"
+
+namespace o3d_slam {
+
+// Dense map with a log odds occupancy per voxel. Voxels are grouped into blocks of kBlockSize^3 and every
+// block lives in exactly one of the kNumShards shards, so a whole scan is integrated with one thread per shard
+// and without any locking. Integration runs in two passes:
+//   1. in parallel over the points: the hit voxel and the existing voxels that the ray passes through (misses)
+//      are binned by shard, the map is only read
+//   2. in parallel over the shards: every voxel gets at most one hit or one miss per scan. Voxels with a hit
+//      aggregate the points, voxels that drop below zero are removed.
+class OccupancyVoxelMap {
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	static constexpr int kBlockSize = 8;
+	static constexpr int kNumShards = 64;
+
+	OccupancyVoxelMap();
+	OccupancyVoxelMap(const Eigen::Vector3d &voxelSize);
+
+	// scan is in the map frame, free space between the sensor and the points is cleared if isClearFreeSpace
+	void integrate(const PointCloud &scan, const Eigen::Vector3d &sensorPosition, const SpaceCarvingParameters &params,
+			bool isClearFreeSpace);
+	PointCloud toPointCloud() const;
+	void transform(const Transform &T);
+
+	size_t size() const;
+	bool empty() const;
+	void clear();
+	Eigen::Vector3d getVoxelSize() const;
+	bool hasNormals() const;
+	bool hasColors() const;
+	const std::vector<VoxelizedPointCloud>& getShards() const;
+	// the shards have to be placed by getShardIdx, used by the deserialization
+	void setShards(std::vector<VoxelizedPointCloud> &&shards);
+
+	int getShardIdx(const Eigen::Vector3i &voxelKey) const;
+
+private:
+	struct Hit {
+		Eigen::Vector3i key_;
+		size_t pointIdx_;
+	};
+	void applyUpdates(int shardIdx, const PointCloud &scan, const SpaceCarvingParameters &params,
+			const std::vector<std::vector<std::vector<Hit>>> &hits,
+			const std::vector<std::vector<std::vector<Eigen::Vector3i>>> &misses);
+
+	Eigen::Vector3d voxelSize_;
+	InverseVoxelSize inverseVoxelSize_;
+	std::vector<VoxelizedPointCloud> shards_;
+	bool isHasNormals_ = false;
+	bool isHasColors_ = false;
+};
+
+} // namespace o3d_slam
@@ -16,6 +16,7 @@
 namespace o3d_slam {
 
 class CloudRegistration;
+class ScanFeatureCache;
 
 class LidarOdometry {
 
@@ -32,10 +33,12 @@ public:
 	const TransformInterpolationBuffer &getBuffer() const;
 	bool hasProcessedMeasurements() const;
 	void setInitialTransform(const Eigen::Matrix4d &initialTransform);
+	// the normals of every preprocessed scan get published there
+	void setScanFeatureCache(std::shared_ptr<ScanFeatureCache> cache);
 
 private:
 
-	PointCloudPtr preprocess(const PointCloud &in) const;
+	PointCloudPtr preprocess(const PointCloud &in, const Time &timestamp) const;
 
 	TransformInterpolationBuffer odomToRangeSensorBuffer_;
 	open3d::geometry::PointCloud cloudPrev_;
@@ -46,6 +49,7 @@ private:
 	Eigen::Matrix4d initialTransform_ = Eigen::Matrix4d::Identity();
 	bool isInitialTransformSet_ = false;
 	std::shared_ptr<CloudRegistration> cloudRegistration_;
+	std::shared_ptr<ScanFeatureCache> scanFeatureCache_;
 };
 
 } // namespace o3d_slam
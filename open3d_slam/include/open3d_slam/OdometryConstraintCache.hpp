@@ -0,0 +1,52 @@
+/*
+ * OdometryConstraintCache.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "open3d_slam/Constraint.hpp"
+#include "open3d_slam/typedefs.hpp"
+
+namespace o3d_slam {
+
+// Odometry constraints between parent and child submaps, kept across loop closures.
+// An entry stays valid until scans are merged into one of its two submaps. Thread safe,
+// the feature computation fills it while the loop closure worker reads it.
+class OdometryConstraintCache {
+
+public:
+	// map revisions of the source and the target submap at the time the constraint was built
+	struct Revisions {
+		size_t source_ = 0;
+		size_t target_ = 0;
+	};
+
+	OdometryConstraintCache() = default;
+	bool hasConstraint(size_t sourceIdx, size_t targetIdx) const;
+	bool isUpToDate(size_t sourceIdx, size_t targetIdx, const Revisions &revisions) const;
+	// overwrites the entry for the same source and target
+	void insert(const Constraint &c, const Revisions &revisions);
+	// sorted by the target submap
+	Constraints getConstraints() const;
+	size_t size() const;
+	void clear();
+
+private:
+	struct Entry {
+		Constraint constraint_;
+		Revisions revisions_;
+	};
+	static uint64 toKey(size_t sourceIdx, size_t targetIdx);
+
+	mutable std::mutex mutex_;
+	std::vector<Entry> entries_;
+	std::unordered_map<uint64, size_t> entryIdxs_;
+};
+
+} // namespace o3d_slam
@@ -38,13 +38,15 @@ struct Parameters {
 enum class CloudRegistrationType : int {
 	PointToPlaneIcp,
 	PointToPointIcp,
-	GeneralizedIcp
+	GeneralizedIcp,
+	VoxelHashPointToPlaneIcp
 };
 
 static const std::map<std::string, CloudRegistrationType> CloudRegistrationStringToEnumMap {
 	{"PointToPlaneIcp",CloudRegistrationType::PointToPlaneIcp},
 	{"PointToPointIcp",CloudRegistrationType::PointToPointIcp},
-	{"GeneralizedIcp",CloudRegistrationType::GeneralizedIcp}
+	{"GeneralizedIcp",CloudRegistrationType::GeneralizedIcp},
+	{"VoxelHashPointToPlaneIcp",CloudRegistrationType::VoxelHashPointToPlaneIcp}
 };
 
 enum class ScanToMapRegistrationType : int {
@@ -78,6 +80,8 @@ struct IcpParameters {
 	double maxCorrespondenceDistance_ = 0.2;
 	int knn_ = 5;
 	double maxDistanceKnn_ = 10.0;
+	// the voxel hash icp stops once the norm of the pose update drops below it
+	double minIncrementNorm_ = 1e-6;
 };
 
 struct CloudRegistrationParameters : public Parameters {
@@ -98,6 +102,10 @@ struct SpaceCarvingParameters{
 	int carveSpaceEveryNscans_ = 10;
 	double minDotProductWithNormal_ = 0.5;
 	double neighborhoodRadiusDenseMap_ = 0.1;
+	// occupancy of the dense map
+	double hitLogOdds_ = 0.85;
+	double missLogOdds_ = -0.4;
+	double maxLogOdds_ = 3.5;
 };
 
 struct MapBuilderParameters{
@@ -112,6 +120,10 @@ struct SubmapParameters{
 	double minSecondsBetweenFeatureComputation_=5.0;
 	double adjacencyBasedRevisitingMinFitness_ = 0.4;
 	int numScansOverlap_ = 3;
+	bool isPageOutToDisk_ = false;
+	double pageOutMemoryBudgetMb_ = 4096.0;
+	double pageOutMinDistance_ = 60.0;
+	std::string pageOutFolder_ = "/tmp/open3d_slam_submaps";
 };
 
 struct PlaceRecognitionConsistencyCheckParameters{
@@ -123,6 +135,15 @@ struct PlaceRecognitionConsistencyCheckParameters{
 	double maxDriftX_ = 10.0;
 };
 
+struct GlobalDescriptorParameters{
+	bool isUseGlobalDescriptor_ = false;
+	int numRings_ = 20;
+	int numSectors_ = 60;
+	double maxRadius_ = 40.0;
+	int numCandidates_ = 5;
+	double maxDescriptorDistance_ = 0.4;
+};
+
 struct PlaceRecognitionParameters{
 	double normalEstimationRadius_=1.0;
 	double featureVoxelSize_ = 0.5;
@@ -140,6 +161,7 @@ struct PlaceRecognitionParameters{
 	double minRefinementFitness_ = 0.7;
 	bool isDumpPlaceRecognitionAlignmentsToFile_ = false;
 	PlaceRecognitionConsistencyCheckParameters consistencyCheck_;
+	GlobalDescriptorParameters globalDescriptor_;
 	int minSubmapsBetweenLoopClosures_ = 2;
 	double loopClosureSearchRadius_ = 20;
 };
@@ -149,11 +171,13 @@ struct GlobalOptimizationParameters {
 	double loopClosurePreference_ = 2.0;
 	double edgePruneThreshold_ = 0.2;
 	int referenceNode_ = 0;
+	bool isUseSparseSolver_ = false;
 };
 
 struct ScanToMapRegistrationParameters : public Parameters {
 	ScanToMapRegistrationType scanToMapRegType_ = ScanToMapRegistrationType::PointToPlaneIcp;
 	double minRefinementFitness_ = 0.7;
+	bool isReuseOdometryNormals_ = false;
 	IcpParameters icp_;
 };
 
@@ -195,6 +219,7 @@ struct SavingParameters {
 	bool isSaveMap_ = false;
 	bool isSaveSubmaps_ = false;
 	bool isSaveDenseSubmaps_ = false;
+	bool isSaveBinaryMap_ = false;
 };
 
 struct ConstantVelocityMotionCompensationParameters {
@@ -205,12 +230,31 @@ struct ConstantVelocityMotionCompensationParameters {
 };
 
 
+struct RangeImageFeatureParameters {
+	int curvatureHalfWindow_ = 5; // columns on each side
+	double edgeMinCurvature_ = 0.1;
+	double planarMaxCurvature_ = 0.01;
+	double groundMaxSlope_ = 0.17; // rad, between vertically neighbouring points
+	double groundMaxZ_ = -0.3; // sensor frame
+};
+
+struct RangeImageParameters {
+	bool isUseRangeImage_ = false;
+	int numColumns_ = 1024; // for the clouds which are not organized already
+	int normalEstimationHalfWindowRows_ = 1;
+	int normalEstimationHalfWindowColumns_ = 2;
+	double normalEstimationMaxNeighbourDistance_ = 1.0;
+	bool isKeepOnlyFeaturePoints_ = false; // edge, planar and ground points
+	RangeImageFeatureParameters features_;
+};
+
 struct SlamParameters {
 	MapperParameters mapper_;
 	OdometryParameters odometry_;
 	VisualizationParameters visualization_;
 	SavingParameters saving_;
 	ConstantVelocityMotionCompensationParameters motionCompensation_;
+	RangeImageParameters rangeImage_;
 };
 
 } // namespace o3d_slam
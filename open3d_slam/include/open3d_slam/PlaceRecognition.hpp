@@ -10,6 +10,7 @@
 #include "open3d_slam/Constraint.hpp"
 #include "open3d_slam/Parameters.hpp"
 #include <open3d/geometry/PointCloud.h>
+#include <ostream>
 
 namespace o3d_slam {
 
@@ -17,6 +18,15 @@ class SubmapCollection;
 class AdjacencyMatrix;
 class Submap;
 
+// pair of submaps to be matched for a loop closure
+struct LoopClosureCandidate {
+	size_t sourceSubmapIdx_ = 0;
+	size_t targetSubmapIdx_ = 0;
+	Time timestamp_;
+};
+
+using LoopClosureCandidates = std::vector<LoopClosureCandidate>;
+
 class PlaceRecognition {
 
 public:
@@ -25,12 +35,27 @@ public:
 	void setParameters(const MapperParameters &p);
 	Constraints buildLoopClosureConstraints(const Transform &mapToRangeSensor, const SubmapCollection &submapCollection,
 			const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx, size_t activeSubmapIdx, const Time &timestamp) const;
+	// the candidates are matched in parallel, accepted constraints are returned in the order of the candidates
+	Constraints buildLoopClosureConstraints(const LoopClosureCandidates &candidates,
+			const SubmapCollection &submapCollection) const;
+	LoopClosureCandidates getLoopClosureCandidates(const Transform &mapToRangeSensor,
+			const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
+			size_t activeSubmapIdx, const Time &timestamp) const;
 	std::vector<size_t> getLoopClosureCandidatesIdxs(const Transform &mapToRangeSensor,
 			const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
 			size_t activeSubmapIdx) const;
 	void setFolderPath(const std::string &folderPath);
 private:
-	bool isRegistrationConsistent(const Eigen::Matrix4d &T) const;
+	struct SourceSubmapData;
+	bool buildLoopClosureConstraint(const LoopClosureCandidate &candidate, const SourceSubmapData &source,
+			const SubmapCollection &submapCollection, Constraint *constraint, std::ostream *log) const;
+	bool isRegistrationConsistent(const Eigen::Matrix4d &T, std::ostream *log) const;
+	bool isLoopClosureCandidate(size_t submapIdx, const SubmapCollection &submapCollection,
+			const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx, size_t activeSubmapIdx,
+			bool isCheckDistance) const;
+	std::vector<size_t> rankByGlobalDescriptor(const std::vector<size_t> &closeSubmapsIdxs,
+			const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
+			size_t activeSubmapIdx) const;
 	void updateRegistrationAlgorithm(const MapperParameters &p);
 
 	std::string folderPath_ = "";
@@ -0,0 +1,78 @@
+/*
+ * RangeImage.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/Parameters.hpp"
+
+namespace o3d_slam {
+
+// Scan of a spinning lidar kept on its rings x columns grid. Neighbours of a point are the
+// neighbouring cells, so no kd tree is needed for normals or features. Row 0 does not have
+// to be the lowest ring, nothing below depends on the ordering of the rows.
+class RangeImage {
+
+public:
+	RangeImage() = default;
+	RangeImage(int numRows, int numCols);
+
+	// clears all the cells
+	void resize(int numRows, int numCols);
+	// if the cell is taken already the closer point stays, timeOffset is in sec relative to the scan timestamp
+	void setPoint(int row, int col, const Eigen::Vector3d &p, double timeOffset = 0.0);
+	// column from the azimuth of the point, the first column starts at -pi
+	int getColumnFromAzimuth(const Eigen::Vector3d &p) const;
+
+	int getNumRows() const;
+	int getNumCols() const;
+	size_t getNumPoints() const;
+	bool isValid(int row, int col) const;
+	const Eigen::Vector3d& getPoint(int row, int col) const;
+	double getRange(int row, int col) const;
+	// mean time offset of the points in each column, NaN for empty columns
+	std::vector<double> getColumnTimeOffsets() const;
+	// for scans without point times, the columns are fired one after the other starting at the timestamp.
+	// Holds for organized clouds, which keep the firing order of the columns.
+	std::vector<double> getColumnTimeOffsetsFromFiringOrder(double scanDuration) const;
+
+	// normal of every valid cell from the cells within the window that are closer than maxNeighbourDistance,
+	// oriented towards the sensor. Cells with less than 3 such neighbours get no normal and are dropped by toPointCloud.
+	void estimateNormals(int halfWindowRows, int halfWindowCols, double maxNeighbourDistance);
+	bool hasNormals() const;
+
+	// edge and planar points from the smoothness along the ring (as in LOAM), ground points from the
+	// slope between neighbouring rings in the same column. The outputs may be nullptr.
+	void extractFeatures(const RangeImageFeatureParameters &p, PointCloud *edges, PointCloud *planar,
+			PointCloud *ground) const;
+	// clears the cells that are neither edge, planar nor ground points, the normals are kept as they are
+	void keepOnlyFeaturePoints(const RangeImageFeatureParameters &p);
+
+	// valid cells in row major order, with normals if they were estimated
+	PointCloud toPointCloud() const;
+	// time offsets of the points in toPointCloud() order, every point takes the time of its column
+	std::vector<float> getPointTimeOffsets(const std::vector<double> &columnTimeOffsets) const;
+
+private:
+	size_t cellIdx(int row, int col) const;
+	bool isPointKept(size_t idx) const;
+	std::vector<uint8> computeFeatureLabels(const RangeImageFeatureParameters &p) const;
+
+	int numRows_ = 0;
+	int numCols_ = 0;
+	size_t numPoints_ = 0;
+	std::vector<uint8> isValid_;
+	std::vector<float> ranges_;
+	std::vector<Eigen::Vector3d> points_;
+	std::vector<double> timeOffsets_;
+	std::vector<Eigen::Vector3d> normals_;
+	std::vector<uint8> hasNormal_;
+};
+
+} // namespace o3d_slam
@@ -0,0 +1,328 @@
+/*
+ * RobinHoodHashMap.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace o3d_slam {
+
+// Open addressing hash map with robin hood insertion and backward shift deletion.
+// All the entries live in one contiguous array, so there is no allocation per element
+// and lookups are a linear walk over neighbouring slots.
+// Differences to std::unordered_map:
+//   - value_type is std::pair<Key,Value> (key is not const), do not modify the key through an iterator
+//   - insert, operator[], reserve and erase invalidate all iterators, pointers and references
+//   - Key and Value have to be default constructible and move assignable
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class RobinHoodHashMap {
+
+	using Distance = uint8_t;
+	static constexpr Distance kEmpty = 0;
+	static constexpr Distance kMaxProbeDistance = 250;
+	static constexpr size_t kMinCapacity = 16;
+
+	template<bool IsConst>
+	class IteratorImpl {
+		friend class RobinHoodHashMap;
+		using Map = typename std::conditional<IsConst, const RobinHoodHashMap, RobinHoodHashMap>::type;
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = typename RobinHoodHashMap::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = typename std::conditional<IsConst, const value_type*, value_type*>::type;
+		using reference = typename std::conditional<IsConst, const value_type&, value_type&>::type;
+
+		IteratorImpl() = default;
+		IteratorImpl(Map *map, size_t idx) :
+				map_(map), idx_(idx) {
+		}
+		// allow iterator -> const_iterator conversion
+		template<bool WasConst, typename = typename std::enable_if<IsConst && !WasConst>::type>
+		IteratorImpl(const IteratorImpl<WasConst> &other) :
+				map_(other.map_), idx_(other.idx_) {
+		}
+
+		reference operator*() const {
+			return map_->slots_[idx_];
+		}
+		pointer operator->() const {
+			return &(map_->slots_[idx_]);
+		}
+		IteratorImpl& operator++() {
+			idx_ = map_->nextOccupied(idx_ + 1);
+			return *this;
+		}
+		IteratorImpl operator++(int) {
+			IteratorImpl copy = *this;
+			++(*this);
+			return copy;
+		}
+		template<bool OtherConst>
+		bool operator==(const IteratorImpl<OtherConst> &other) const {
+			return idx_ == other.idx_;
+		}
+		template<bool OtherConst>
+		bool operator!=(const IteratorImpl<OtherConst> &other) const {
+			return idx_ != other.idx_;
+		}
+
+	private:
+		template<bool> friend class IteratorImpl;
+		Map *map_ = nullptr;
+		size_t idx_ = 0;
+	};
+
+public:
+	using key_type = Key;
+	using mapped_type = Value;
+	using value_type = std::pair<Key, Value>;
+	using size_type = size_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+	using iterator = IteratorImpl<false>;
+	using const_iterator = IteratorImpl<true>;
+
+	RobinHoodHashMap() = default;
+	explicit RobinHoodHashMap(size_t expectedNumElements) {
+		reserve(expectedNumElements);
+	}
+
+	iterator begin() {
+		return iterator(this, nextOccupied(0));
+	}
+	const_iterator begin() const {
+		return const_iterator(this, nextOccupied(0));
+	}
+	const_iterator cbegin() const {
+		return begin();
+	}
+	iterator end() {
+		return iterator(this, capacity());
+	}
+	const_iterator end() const {
+		return const_iterator(this, capacity());
+	}
+	const_iterator cend() const {
+		return end();
+	}
+
+	size_t size() const {
+		return size_;
+	}
+	bool empty() const {
+		return size_ == 0;
+	}
+	size_t capacity() const {
+		return distances_.size();
+	}
+	double load_factor() const {
+		return capacity() == 0 ? 0.0 : static_cast<double>(size_) / capacity();
+	}
+
+	void clear() {
+		for (size_t i = 0; i < capacity(); ++i) {
+			if (distances_[i] != kEmpty) {
+				distances_[i] = kEmpty;
+				slots_[i] = value_type();
+			}
+		}
+		size_ = 0;
+	}
+
+	void reserve(size_t numElements) {
+		const size_t requiredCapacity = capacityFor(numElements);
+		if (requiredCapacity > capacity()) {
+			rehash(requiredCapacity);
+		}
+	}
+
+	iterator find(const Key &key) {
+		return iterator(this, findIdx(key));
+	}
+	const_iterator find(const Key &key) const {
+		return const_iterator(this, findIdx(key));
+	}
+	size_t count(const Key &key) const {
+		return findIdx(key) != capacity() ? 1 : 0;
+	}
+
+	std::pair<iterator, bool> insert(const value_type &value) {
+		return insert(value_type(value));
+	}
+
+	std::pair<iterator, bool> insert(value_type &&value) {
+		const size_t existingIdx = findIdx(value.first);
+		if (existingIdx != capacity()) {
+			return {iterator(this, existingIdx), false};
+		}
+		return {iterator(this, insertNew(std::move(value))), true};
+	}
+
+	template<typename ... Args>
+	std::pair<iterator, bool> emplace(Args &&... args) {
+		return insert(value_type(std::forward<Args>(args)...));
+	}
+
+	Value& operator[](const Key &key) {
+		const size_t existingIdx = findIdx(key);
+		if (existingIdx != capacity()) {
+			return slots_[existingIdx].second;
+		}
+		return slots_[insertNew(value_type(key, Value()))].second;
+	}
+
+	Value& at(const Key &key) {
+		const size_t idx = findIdx(key);
+		if (idx == capacity()) {
+			throw std::out_of_range("RobinHoodHashMap::at key not found");
+		}
+		return slots_[idx].second;
+	}
+	const Value& at(const Key &key) const {
+		const size_t idx = findIdx(key);
+		if (idx == capacity()) {
+			throw std::out_of_range("RobinHoodHashMap::at key not found");
+		}
+		return slots_[idx].second;
+	}
+
+	size_t erase(const Key &key) {
+		size_t idx = findIdx(key);
+		if (idx == capacity()) {
+			return 0;
+		}
+		// backward shift deletion, no tombstones
+		size_t next = (idx + 1) & mask_;
+		while (distances_[next] > 1) {
+			slots_[idx] = std::move(slots_[next]);
+			distances_[idx] = distances_[next] - 1;
+			idx = next;
+			next = (next + 1) & mask_;
+		}
+		distances_[idx] = kEmpty;
+		slots_[idx] = value_type();
+		--size_;
+		return 1;
+	}
+
+private:
+
+	static size_t capacityFor(size_t numElements) {
+		// keep the load factor below 0.8
+		const size_t minCapacity = numElements + numElements / 4 + 1;
+		size_t capacity = kMinCapacity;
+		while (capacity < minCapacity) {
+			capacity <<= 1;
+		}
+		return capacity;
+	}
+
+	size_t homeIdx(const Key &key) const {
+		return hasher_(key) & mask_;
+	}
+
+	size_t nextOccupied(size_t idx) const {
+		while (idx < capacity() && distances_[idx] == kEmpty) {
+			++idx;
+		}
+		return idx;
+	}
+
+	size_t findIdx(const Key &key) const {
+		if (size_ == 0) {
+			return capacity();
+		}
+		size_t idx = homeIdx(key);
+		for (Distance dist = 1;; ++dist) {
+			const Distance stored = distances_[idx];
+			// empty slot or an element closer to its home than we are, key is not here
+			if (stored < dist) {
+				return capacity();
+			}
+			if (stored == dist && keyEqual_(slots_[idx].first, key)) {
+				return idx;
+			}
+			idx = (idx + 1) & mask_;
+		}
+	}
+
+	// key must not be present, returns the slot in which the value ended up
+	size_t insertNew(value_type &&value) {
+		if (capacity() == 0 || (size_ + 1) * 5 > capacity() * 4) {
+			rehash(capacityFor(size_ + 1));
+		}
+		const Key key = value.first;
+		bool isKeyCarried = true;
+		bool isLookupNeeded = false;
+		size_t insertedIdx = 0;
+		size_t idx = homeIdx(value.first);
+		Distance dist = 1;
+		while (true) {
+			if (distances_[idx] == kEmpty) {
+				distances_[idx] = dist;
+				slots_[idx] = std::move(value);
+				++size_;
+				if (isKeyCarried) {
+					insertedIdx = idx;
+				}
+				break;
+			}
+			if (distances_[idx] < dist) {
+				// robin hood, take the slot from the richer element and carry that one further
+				std::swap(distances_[idx], dist);
+				std::swap(slots_[idx], value);
+				if (isKeyCarried) {
+					insertedIdx = idx;
+					isKeyCarried = false;
+				}
+			}
+			idx = (idx + 1) & mask_;
+			++dist;
+			if (dist > kMaxProbeDistance) {
+				// pathologically long probe sequence, grow and continue with the carried element
+				rehash(capacity() * 2);
+				isLookupNeeded = !isKeyCarried;
+				idx = homeIdx(value.first);
+				dist = 1;
+			}
+		}
+		return isLookupNeeded ? findIdx(key) : insertedIdx;
+	}
+
+	void rehash(size_t newCapacity) {
+		std::vector<Distance> oldDistances(newCapacity, Distance(kEmpty));
+		SlotContainer oldSlots(newCapacity);
+		oldDistances.swap(distances_);
+		oldSlots.swap(slots_);
+		mask_ = newCapacity - 1;
+		size_ = 0;
+		for (size_t i = 0; i < oldDistances.size(); ++i) {
+			if (oldDistances[i] != kEmpty) {
+				insertNew(std::move(oldSlots[i]));
+			}
+		}
+	}
+
+	using SlotContainer = std::vector<value_type, Eigen::aligned_allocator<value_type>>;
+	std::vector<Distance> distances_;
+	SlotContainer slots_;
+	size_t size_ = 0;
+	size_t mask_ = 0;
+	Hash hasher_;
+	KeyEqual keyEqual_;
+};
+
+} // namespace o3d_slam
@@ -0,0 +1,82 @@
+/*
+ * ScanContext.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <open3d/geometry/KDTreeFlann.h>
+#include "open3d_slam/Parameters.hpp"
+#include "open3d_slam/typedefs.hpp"
+
+namespace o3d_slam {
+
+// Scan context global descriptor (Kim and Kim, IROS 2018) of a submap. The points around the
+// center are binned into rings x sectors in the xy plane, each bin holds the max height above the lowest point.
+// The distance is minimized over circular shifts of the sectors, hence it does not depend on the yaw.
+class ScanContext {
+
+public:
+	ScanContext() = default;
+	explicit ScanContext(const GlobalDescriptorParameters &p);
+
+	void compute(const PointCloud &cloud, const Eigen::Vector3d &center);
+	// 0 for identical descriptors, 1 for completely different ones
+	double distance(const ScanContext &other) const;
+	// rotation invariant summary used for the kd tree search
+	const Eigen::VectorXd& getRingKey() const;
+	bool isEmpty() const;
+
+private:
+	Eigen::MatrixXd descriptor_; // rings x sectors
+	Eigen::VectorXd ringKey_; // fraction of occupied sectors in every ring
+	int numRings_ = 20;
+	int numSectors_ = 60;
+	double maxRadius_ = 40.0;
+};
+
+// Kd tree over the ring keys of the submap descriptors. Thread safe, the descriptors
+// are inserted by the feature computation while the loop closure worker queries.
+// The tree is rebuilt only once the descriptors it does not cover (new ones and the replaced ones)
+// outnumber the ones it does, those are searched linearly in the meantime. Inserting n submaps
+// therefore costs O(n log n) in total.
+class ScanContextIndex {
+
+public:
+	struct Match {
+		size_t submapId_;
+		double distance_;
+	};
+
+	ScanContextIndex() = default;
+	void insert(size_t submapId, const ScanContext &descriptor);
+	void clear();
+	size_t size() const;
+	bool getDescriptor(size_t submapId, ScanContext *descriptor) const;
+	// numNearest closest submaps by the ring key, sorted by the full descriptor distance
+	std::vector<Match> query(const ScanContext &descriptor, size_t numNearest) const;
+
+private:
+	// have to be called with the mutex locked
+	void rebuildTree();
+	size_t getNumNotInTree() const;
+
+	mutable std::mutex mutex_;
+	std::vector<size_t> submapIds_;
+	std::vector<ScanContext> descriptors_;
+	std::unordered_map<size_t, size_t> submapIdToIdx_;
+	// the tree covers the first numInTree_ descriptors, except for the ones replaced after the build
+	std::unique_ptr<open3d::geometry::KDTreeFlann> ringKeyTree_;
+	size_t numInTree_ = 0;
+	std::vector<uint8> isReplaced_;
+	size_t numReplaced_ = 0;
+};
+
+} // namespace o3d_slam
@@ -0,0 +1,51 @@
+/*
+ * ScanFeatureCache.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/time.hpp"
+
+namespace o3d_slam {
+
+// Normals of the scans preprocessed by the odometry, keyed by the scan timestamp. The mapping preprocesses
+// the same scans a bit later (with its own cropping and voxel size) and takes the normals from here
+// instead of building another kd tree. Thread safe, only the latest scans are kept.
+class ScanFeatureCache {
+
+public:
+	struct Entry {
+		std::shared_ptr<const PointCloud> cloud_; // points and normals in the range sensor frame
+		double voxelSize_ = 0.0;
+		int knn_ = 0;
+		double maxRadius_ = 0.0;
+	};
+
+	explicit ScanFeatureCache(size_t capacity = 30);
+	void insert(const Time &timestamp, const Entry &entry);
+	// removes the entry together with all the older ones, the consumer goes forward in time
+	bool take(const Time &timestamp, Entry *entry);
+	size_t size() const;
+	void clear();
+
+private:
+	mutable std::mutex mutex_;
+	std::deque<std::pair<Time, Entry>> entries_; // ascending in time
+	size_t capacity_;
+};
+
+// Every point of the cloud gets the normal of the nearest cached point within one cached voxel, the rest
+// is estimated from the cloud itself. Normals end up normalized and oriented towards the sensor.
+// Returns false and leaves the cloud as it was if the cached normals were estimated with different
+// parameters or if they cover too little of the cloud.
+bool transferNormals(const ScanFeatureCache::Entry &entry, int knn, double maxRadius, PointCloud *cloud);
+
+} // namespace o3d_slam
@@ -18,6 +18,7 @@ namespace o3d_slam {
 
 class Submap;
 class CroppingVolume;
+class ScanFeatureCache;
 
 using RegistrationResult = open3d::pipelines::registration::RegistrationResult;
 
@@ -32,11 +33,16 @@ public:
 	ScanToMapRegistration() = default;
 	virtual ~ScanToMapRegistration() = default;
 	virtual ProcessedScans processForScanMatchingAndMerging(const PointCloud &in,
-			const Transform &mapToRangeSensor) const =0;
+			const Transform &mapToRangeSensor, const Time &timestamp) const =0;
 	virtual RegistrationResult scanToMapRegistration(const PointCloud &scan, const Submap &activeSubmap,
 			const Transform &mapToRangeSensor, const Transform &initialGuess) const = 0;
 	virtual bool isMergeScanValid(const PointCloud &in) const =0;
 	virtual void prepareInitialMap(PointCloud *map) const =0;
+	// normals already estimated by the odometry are looked up there
+	void setScanFeatureCache(std::shared_ptr<ScanFeatureCache> cache);
+
+protected:
+	std::shared_ptr<ScanFeatureCache> scanFeatureCache_;
 };
 
 class ScanToMapIcp : public ScanToMapRegistration {
@@ -45,12 +51,13 @@ public:
 	ScanToMapIcp();
 	virtual ~ScanToMapIcp() = default;
 	void setParameters(const MapperParameters &p);
-	ProcessedScans processForScanMatchingAndMerging(const PointCloud &in, const Transform &mapToRangeSensor) const final;
+	ProcessedScans processForScanMatchingAndMerging(const PointCloud &in, const Transform &mapToRangeSensor,
+			const Time &timestamp) const final;
 	RegistrationResult scanToMapRegistration(const PointCloud &scan, const Submap &activeSubmap, const Transform &mapToRangeSensor,const Transform &initialGuess) const final;
 	bool isMergeScanValid(const PointCloud &in) const final;
 	void prepareInitialMap(PointCloud *map) const final;
 private:
-	PointCloudPtr preprocess(const PointCloud &in) const;
+	PointCloudPtr preprocess(const PointCloud &in, const Time &timestamp) const;
 	void update(const MapperParameters &p);
 
 	MapperParameters params_;
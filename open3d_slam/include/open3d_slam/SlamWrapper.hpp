@@ -9,6 +9,8 @@
 
 #include <thread>
 #include <future>
+#include <atomic>
+#include <condition_variable>
 #include <Eigen/Dense>
 #include "open3d_slam/Parameters.hpp"
 #include "open3d_slam/Submap.hpp"
@@ -29,13 +31,17 @@ class OptimizationProblem;
 class MotionCompensation;
 
 class SlamWrapper {
+	// scans are immutable once they are in a buffer, the stages read the shared cloud in place,
+	// only the motion compensation produces a new cloud
 	struct TimestampedPointCloud {
 		Time time_;
-		PointCloud cloud_;
+		std::shared_ptr<const PointCloud> cloud_;
+		std::shared_ptr<const std::vector<float>> pointTimeOffsets_; // empty if the sensor does not provide them
 	};
 
 	struct RegisteredPointCloud{
 		TimestampedPointCloud raw_;
+		std::shared_ptr<const PointCloud> undistorted_; // the raw cloud if the motion compensation is off
 		Transform transform_;
 		std::string sourceFrame_, targetFrame_;
 		size_t submapId_;
@@ -47,13 +53,18 @@ public:
 
 	virtual ~SlamWrapper();
 
-	virtual void addRangeScan(const open3d::geometry::PointCloud cloud, const Time timestamp);
+	virtual void addRangeScan(const open3d::geometry::PointCloud &cloud, const Time timestamp);
+	// pointTimeOffsets in sec relative to the timestamp, one per point, used by the motion compensation
+	void addRangeScan(const open3d::geometry::PointCloud &cloud, const Time timestamp,
+			std::vector<float> pointTimeOffsets);
 	virtual void loadParametersAndInitialize();
 	virtual void startWorkers();
 	virtual void stopWorkers();
 	virtual void finishProcessing();
 
 	const MapperParameters &getMapperParameters() const;
+	const RangeImageParameters &getRangeImageParameters() const;
+	const ConstantVelocityMotionCompensationParameters &getMotionCompensationParameters() const;
 	MapperParameters *getMapperParametersPtr();
 	size_t getOdometryBufferSize() const;
 	size_t getMappingBufferSize() const;
@@ -61,14 +72,19 @@ public:
 	size_t getMappingBufferSizeLimit() const;
 	std::string getParameterFilePath() const;
 	std::pair<PointCloud,Time> getLatestRegisteredCloudTimestampPair() const;
+	// blocks until the next scan can be added without overflowing the buffers, false on timeout
+	bool waitUntilBuffersHaveSpace(std::chrono::milliseconds timeout) const;
 
 	void setDirectoryPath(const std::string &path);
 	void setMapSavingDirectoryPath(const std::string &path);
 	void setParameterFilePath(const std::string &path);
 	void setInitialMap(const PointCloud &initialMap);
+	// *.o3dmap files come with the saved normals and covariances, anything else is read with open3d and gets normals estimated
+	bool loadInitialMap(const std::string &filename);
 	void setInitialTransform(const Eigen::Matrix4d initialTransform);
 
 	bool saveMap(const std::string &directory);
+	bool saveBinaryMap(const std::string &directory);
 	bool saveDenseSubmaps(const std::string &directory);
 	bool saveSubmaps(const std::string &directory, const bool& isDenseMap=false);
 private:
@@ -80,6 +96,8 @@ private:
 	void attemptLoopClosuresIfReady();
 	void updateSubmapsAndTrajectory();
 	void denseMapWorker();
+	void wakeUpLoopClosureWorker();
+	void insertInitialMap(const PointCloud &initialMap);
 
 
 protected:
@@ -107,6 +125,8 @@ protected:
 	// multithreading
 	std::thread odometryWorker_, mappingWorker_, loopClosureWorker_, denseMapWorker_;
 	std::future<void> computeFeaturesResult_;
+	std::mutex loopClosureWorkerMutex_;
+	std::condition_variable loopClosureWorkerCondition_;
 
 	// timing
 	Timer mappingStatisticsTimer_,odometryStatisticsTimer_, visualizationUpdateTimer_, denseMapVisualizationUpdateTimer_, denseMapStatiscticsTimer_;
@@ -115,8 +135,8 @@ protected:
 	Time latestScanToScanRegistrationTimestamp_;
 
 	// bookkeeping
-	bool isOptimizedGraphAvailable_ = false;
-	bool isRunWorkers_ = true;
+	std::atomic<bool> isOptimizedGraphAvailable_{false};
+	std::atomic<bool> isRunWorkers_{true};
 	int numLatesLoopClosureConstraints_ = -1;
 	PointCloud rawCloudPrev_;
 	Constraints lastLoopClosureConstraints_;
@@ -0,0 +1,67 @@
+/*
+ * StreamingPointCloudWriter.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "open3d_slam/typedefs.hpp"
+
+namespace o3d_slam {
+
+// Appends clouds to a single binary pcd or ply file (picked from the extension) without holding
+// the whole map in memory. The number of points does not have to be known upfront, it is patched
+// into the header on close. The fields (normals, colors) are fixed on open, clouds missing one get
+// zeros and extra ones are dropped. write() can be called from many threads, the conversion
+// runs in parallel and only the disk writes are serialized.
+class StreamingPointCloudWriter {
+
+public:
+	struct Statistics {
+		size_t numPoints_ = 0;
+		size_t numBytes_ = 0;
+		double elapsedSec_ = 0.0;
+		double getMegabytes() const;
+		double getMegabytesPerSecond() const;
+	};
+
+	StreamingPointCloudWriter() = default;
+	~StreamingPointCloudWriter();
+	StreamingPointCloudWriter(const StreamingPointCloudWriter&) = delete;
+	StreamingPointCloudWriter& operator=(const StreamingPointCloudWriter&) = delete;
+
+	bool open(const std::string &filename, bool hasNormals, bool hasColors);
+	bool write(const PointCloud &cloud);
+	bool close();
+	bool isOpen() const;
+	Statistics getStatistics() const;
+
+private:
+	enum class Format {
+		Pcd, Ply
+	};
+	void writeHeader();
+	void serializeChunk(const PointCloud &cloud, size_t begin, size_t end, std::string *bytes) const;
+	size_t getPointSizeInBytes() const;
+
+	mutable std::mutex mutex_;
+	std::ofstream file_;
+	std::string filename_;
+	Format format_ = Format::Pcd;
+	bool hasNormals_ = false;
+	bool hasColors_ = false;
+	bool isGood_ = true;
+	std::vector<std::streampos> pointCountPositions_;
+	size_t numPoints_ = 0;
+	size_t numBytes_ = 0;
+	std::chrono::steady_clock::time_point startTime_;
+};
+
+} // namespace o3d_slam
@@ -9,13 +9,19 @@
 
 #include <open3d/geometry/PointCloud.h>
 #include <Eigen/Dense>
+#include <atomic>
 #include <mutex>
+#include <string>
 #include "open3d_slam/Parameters.hpp"
 #include "open3d_slam/croppers.hpp"
 #include "open3d_slam/time.hpp"
 #include "open3d_slam/Transform.hpp"
 #include <open3d/pipelines/registration/Feature.h>
 #include "open3d_slam/Voxel.hpp"
+#include "open3d_slam/OccupancyVoxelMap.hpp"
+#include "open3d_slam/VoxelizedMapCloud.hpp"
+#include "open3d_slam/IncrementalKdTree.hpp"
+#include "open3d_slam/ScanContext.hpp"
 
 namespace o3d_slam {
 
@@ -42,37 +48,87 @@ public:
 	bool insertScanDenseMap(const PointCloud &rawScan, const Transform &transform, const Time &time,
 			bool isPerformCarving);
 
-	const Transform& getMapToSubmapOrigin() const;
+	// the map cloud, its index, the sparse cloud and the voxel map are kept in this frame
+	Transform getMapToSubmapOrigin() const;
 	Eigen::Vector3d getMapToSubmapCenter() const;
+	// only before the first scan is inserted
 	void setMapToSubmapOrigin(const Transform &T);
+
+	// The getters returning references page the submap in, the clouds and the index are in the submap
+	// frame (getMapToSubmapOrigin). Only the mapping thread may call them.
 	const PointCloud& getMapPointCloud() const;
-	PointCloud getMapPointCloudCopy() const;
-	const VoxelizedPointCloud& getDenseMap() const;
-	VoxelizedPointCloud getDenseMapCopy() const;
-	bool isEmpty() const;
+	const OccupancyVoxelMap& getDenseMap() const;
 	const Feature& getFeatures() const;
 	const PointCloud& getSparseMapPointCloud() const;
+	// mirrors the map point cloud, kept up to date on insertion and carving
+	const IncrementalKdTree& getMapIndex() const;
+
+	// number of points falling into an occupied voxel of the voxel map once transformed by mapToCloud, the
+	// voxel map is swapped by the feature computation, hence it is only read under the lock
+	size_t getNumPointsInVoxelMap(const PointCloud &cloud, const Transform &mapToCloud) const;
+
+	// The copies are safe to take from any thread, they leave the submap as it is. They are in the map
+	// frame and paged out submaps are read from their pages.
+	PointCloud getMapPointCloudCopy() const;
+	OccupancyVoxelMap getDenseMapCopy() const;
+	// false if the features were not computed yet
+	bool getSparseMapAndFeaturesCopy(PointCloud *sparse, Feature *feature) const;
+	// fields of the map point cloud (or of the dense map) copy, paged out submaps stay on disk
+	void getMapFields(bool isDenseMap, bool *hasNormals, bool *hasColors) const;
+
+	bool isEmpty() const;
+	bool hasFeatures() const;
+	// only computed if the global descriptor is enabled, empty until the features are computed
+	ScanContext getScanContext() const;
 	void computeSubmapCenter();
 	void computeFeatures();
 	size_t getId() const;
 	size_t getParentId() const;
+	// O(1) for the map cloud, only the submap origin moves. The dense map is moved lazily the next time
+	// somebody reads or extends it.
 	void transform(const Transform &T);
-	const VoxelMap& getVoxelMap() const;
+	// incremented whenever scans are merged into the map point cloud, rigid transforms do not count
+	size_t getMapRevision() const;
+	size_t getNumMapPoints() const;
+
+	// Writes the map clouds, the features and the dense map to files starting with filePrefix and
+	// frees them. They are read back transparently the next time somebody needs them.
+	// Returns false without doing anything while the features are being computed.
+	// Nobody may hold a reference obtained from the getters while the submap is paged out.
+	bool pageOut(const std::string &filePrefix);
+	bool isPagedOut() const;
+	// approximate number of bytes held by the resident clouds, features and voxel maps
+	size_t getMemoryFootprint() const;
+	// steady clock nanoseconds of the last read or insertion which needed the points in RAM
+	int64 getLastAccessTime() const;
 	mutable PointCloud toRemove_;
 	mutable PointCloud scanRef_;
 
 	Submap(const Submap &other);
 
 private:
-	void carve(const PointCloud &scan, const Eigen::Vector3d &sensorPosition,
-			const SpaceCarvingParameters &param, VoxelizedPointCloud *cloud);
 	void update(const MapperParameters &mapperParams);
-	void carve(const PointCloud &rawScan, const Transform &mapToRangeSensor, const CroppingVolume &cropper,
-			const SpaceCarvingParameters &params, PointCloud *map);
-	void voxelizeInsideCroppingVolume(const CroppingVolume &cropper, const MapBuilderParameters &param,
-			PointCloud *map) const;
+	// have to be called with mapPointCloudMutex_ locked
+	void carve(const PointCloud &rawScan, const Transform &submapToRangeSensor, const CroppingVolume &cropper,
+			const SpaceCarvingParameters &params);
+	void insertIntoMapCloud(const PointCloud &transformedScan, const CroppingVolume &cropper);
+	void rebuildMapIndex() const;
+	// has to be called with denseMapMutex_ locked
+	void applyPendingDenseMapTransform() const;
+	void pageInMap() const;
+	void pageInDenseMap() const;
+	// sparse and feature can be nullptr, then only the map cloud is read
+	bool readMapPage(PointCloud *map, PointCloud *sparse, Feature *feature) const;
+	bool readDenseMapPage(OccupancyVoxelMap *denseMap) const;
+	void touch() const;
 
-	PointCloud sparseMapCloud_, mapCloud_;
+	mutable PointCloud sparseMapCloud_;
+	// voxelized incrementally, inserting a scan and carving do not touch the rest of the submap
+	mutable VoxelizedMapCloud mapCloud_;
+	// loop closure corrections that have not been applied to the dense map yet
+	mutable Transform pendingDenseMapTransform_ = Transform::Identity();
+	mutable bool isDenseMapTransformPending_ = false;
+	// guarded by mapPointCloudMutex_, the map cloud is stored relative to it
 	Transform mapToSubmap_ = Transform::Identity();
 	Transform mapToRangeSensor_ = Transform::Identity();
 	Eigen::Vector3d submapCenter_ = Eigen::Vector3d::Zero();
@@ -81,17 +137,33 @@ private:
 	Timer featureTimer_;
 	size_t nScansInsertedMap_ = 0;
 	size_t nScansInsertedDenseMap_ = 0;
-	std::shared_ptr<Feature> feature_;
+	size_t mapRevision_ = 0;
+	mutable std::shared_ptr<Feature> feature_;
+	ScanContext scanContext_;
 	size_t id_ = 0;
 	bool isCenterComputed_ = false;
 	size_t parentId_ = 0;
 	Timer carvingStatisticsTimer_;
 	int scanCounter_ = 0;
-	VoxelMap voxelMap_;
-	VoxelizedPointCloud denseMap_;
+	mutable VoxelMap voxelMap_;
+	mutable IncrementalKdTree mapIndex_;
+	bool isMaintainMapIndex_ = false;
+	mutable OccupancyVoxelMap denseMap_;
 	ColorRangeCropper colorCropper_;
 	mutable std::mutex denseMapMutex_;
 	mutable std::mutex mapPointCloudMutex_;
+	std::string pageFilePrefix_;
+	mutable bool isMapPagedOut_ = false;
+	mutable bool isDenseMapPagedOut_ = false;
+	size_t numMapPointsPagedOut_ = 0;
+	// pageOut leaves the submap alone while its features are being computed
+	std::atomic_bool isComputingFeatures_ { false };
+	// fields of the paged out clouds
+	bool isPagedOutMapHasNormals_ = false;
+	bool isPagedOutMapHasColors_ = false;
+	bool isPagedOutDenseMapHasNormals_ = false;
+	bool isPagedOutDenseMapHasColors_ = false;
+	mutable std::atomic<int64> lastAccessTime_ { 0 };
 };
 
 } // namespace o3d_slam
@@ -0,0 +1,62 @@
+/*
+ * SubmapCenterIndex.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <mutex>
+#include <vector>
+#include "open3d_slam/RobinHoodHashMap.hpp"
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/VoxelHashMap.hpp"
+
+namespace o3d_slam {
+
+// Grid hash over the submap centers, the cell size is best set to the submap radius. Nearest neighbour
+// search walks the cells in shells around the query and stops as soon as no closer center can exist,
+// hence the cost depends on the local submap density and not on the number of submaps. If the search
+// would visit more cells than there are submaps it falls back to checking every center.
+// All methods are thread safe, queries run concurrently with updates from the mapping thread.
+class SubmapCenterIndex {
+
+public:
+	explicit SubmapCenterIndex(double cellSize = 20.0);
+
+	// rebins all the centers
+	void setCellSize(double cellSize);
+	// inserts the submap or moves it if it is in the index already
+	void update(size_t submapIdx, const Eigen::Vector3d &center);
+	void clear();
+	size_t size() const;
+
+	// ties are broken by the lower submap index, returns false if the index is empty
+	bool findNearest(const Eigen::Vector3d &query, size_t *submapIdx, double *distance) const;
+	// sorted by submap index
+	std::vector<size_t> findWithinRadius(const Eigen::Vector3d &query, double radius) const;
+
+private:
+	Eigen::Vector3i getCellKey(const Eigen::Vector3d &p) const;
+	// have to be called with the mutex locked
+	void insertIntoCell(size_t submapIdx);
+	void removeFromCell(size_t submapIdx);
+	void findNearestInCell(const Eigen::Vector3i &key, const Eigen::Vector3d &query, size_t *best,
+			double *bestSquaredDistance) const;
+	void findNearestLinear(const Eigen::Vector3d &query, size_t *best, double *bestSquaredDistance) const;
+
+	mutable std::mutex mutex_;
+	double cellSize_ = 20.0;
+	InverseVoxelSize inverseCellSize_;
+	std::vector<Eigen::Vector3d> centers_;
+	std::vector<uint8> isIndexed_;
+	size_t numIndexed_ = 0;
+	RobinHoodHashMap<Eigen::Vector3i, std::vector<size_t>, EigenVec3iHash> cells_;
+	// bounds of the cells that were ever occupied, the shell search stops once it covers them
+	Eigen::Vector3i minKey_ = Eigen::Vector3i::Zero();
+	Eigen::Vector3i maxKey_ = Eigen::Vector3i::Zero();
+};
+
+} // namespace o3d_slam
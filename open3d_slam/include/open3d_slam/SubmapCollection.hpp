@@ -14,7 +14,9 @@
 #include "open3d_slam/Parameters.hpp"
 #include "open3d_slam/croppers.hpp"
 #include "open3d_slam/Submap.hpp"
+#include "open3d_slam/SubmapCenterIndex.hpp"
 #include "open3d_slam/Constraint.hpp"
+#include "open3d_slam/OdometryConstraintCache.hpp"
 #include "open3d_slam/AdjacencyMatrix.hpp"
 #include "open3d_slam/PlaceRecognition.hpp"
 #include "open3d_slam/OptimizationProblem.hpp"
@@ -37,7 +39,7 @@ public:
 	using TimestampedSubmapIds = std::vector<TimestampedSubmapId>;
 	EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
 	SubmapCollection();
-	~SubmapCollection() = default;
+	~SubmapCollection();
 
 	void setMapToRangeSensor(const Transform &T);
 	const Submap& getActiveSubmap() const;
@@ -49,6 +51,7 @@ public:
 	const Submap &getSubmap(SubmapId idx) const;
 	size_t getNumSubmaps() const;
 	size_t getTotalNumPoints() const;
+	size_t getMemoryFootprint() const;
 
 	void computeFeatures(const TimestampedSubmapIds &ids);
 	bool isComputingFeatures() const;
@@ -62,9 +65,18 @@ public:
 
 
 	bool dumpToFile(const std::string &folderPath, const std::string &filename, const bool& isDenseMap) const;
+	// streams all the submaps into one binary .pcd or .ply without assembling the map in memory
+	bool exportToFile(const std::string &filename, const bool& isDenseMap) const;
+	// all the submaps with their poses, normals, features and the adjacency in one binary file, see MapFile.hpp
+	bool saveToMapFile(const std::string &filename) const;
 	void transform(const OptimizedTransforms &transformIncrements);
 	void updateAdjacencyMatrix(const Constraints &loopClosureConstraints);
-	const Constraints &getOdometryConstraints() const;
+	Constraints getOdometryConstraints() const;
+	// fills in the odometry constraints that are missing or out of date and returns all of them
+	Constraints buildOdometryConstraints();
+	const ScanContextIndex &getScanContextIndex() const;
+	// kept up to date when submaps are created, finished or moved
+	const SubmapCenterIndex &getSubmapCenterIndex() const;
 
 	const MapperParameters &getParameters() const;
 	void setFolderPath(const std::string &folderPath);
@@ -79,6 +91,9 @@ private:
 	void createNewSubmap(const Transform &mapToSubmap);
 	size_t findClosestSubmap(const Transform &mapToRangesensor) const;
 	std::vector<size_t> getAllSubmapIdxs() const;
+	// evicts the least recently used submaps far from the robot until the memory budget is met
+	void pageOutSubmaps();
+	std::string getPageFilePrefix(size_t submapIdx) const;
 
 	Transform mapToRangeSensor_ = Transform::Identity();
 	Time timestamp_;
@@ -90,11 +105,15 @@ private:
 	std::mutex featureComputationMutex_;
 	bool isComputingFeatures_ = false;
 	std::mutex constraintBuildMutex_;
+	// held while somebody keeps references into the submaps, paging out is skipped meanwhile
+	mutable std::mutex pagingMutex_;
 	AdjacencyMatrix adjacencyMatrix_;
 	size_t submapId_=0;
 	PlaceRecognition placeRecognition_;
+	ScanContextIndex scanContextIndex_;
+	SubmapCenterIndex submapCenterIndex_;
 	ThreadSafeBuffer<TimestampedSubmapId> loopClosureCandidatesIdxs_, finishedSubmapsIdxs_;
-	Constraints odometryConstraints_;
+	OdometryConstraintCache odometryConstraints_;
 	CircularBuffer<ScanTimeTransform> overlapScansBuffer_;
 	std::string savingDataFolderPath_;
 	bool isForceNewSubmapCreation_ = false;
@@ -29,6 +29,7 @@ public:
 		data_.insert(data_.end(),first, last);
 	}
 
+	// not synchronized
 	const std::vector<T> &peek () const {
 		return data_;
 	}
@@ -46,17 +47,19 @@ public:
 	}
 
 	bool empty() const {
+		std::lock_guard<std::mutex> lck(modifierMutex_);
 		return data_.empty();
 	}
 
 	size_t size() const {
+		std::lock_guard<std::mutex> lck(modifierMutex_);
 		return data_.size();
 	}
 
 
 private:
 	std::vector<T> data_;
-	std::mutex modifierMutex_;
+	mutable std::mutex modifierMutex_;
 };
 
 
@@ -6,17 +6,23 @@
  */
 
 #pragma once
-#include <deque>
-#include <limits>
+#include <atomic>
 #include <mutex>
+#include <vector>
+#include <Eigen/StdVector>
 
 #include "open3d_slam/time.hpp"
 #include "open3d_slam/Transform.hpp"
+#include "open3d_slam/typedefs.hpp"
 
 namespace o3d_slam {
 
 // A time-ordered buffer of transforms that supports interpolated lookups.
-// Unless explicitly set, the buffer size is unlimited.
+// Transforms live in a ring buffer of fixed capacity (the size limit), lookups are a binary search.
+// Readers never lock: they copy what they need under a sequence counter and retry if a writer was
+// active meanwhile (seqlock). Writers (push, clear, applyToAllElementsInTimeInterval) are serialized
+// with a mutex. Every reading method sees one consistent state of the buffer, but two consecutive
+// calls (e.g. has() followed by lookup()) can see different states.
 class TransformInterpolationBuffer {
 public:
 	TransformInterpolationBuffer(size_t bufferSize);
@@ -24,7 +30,7 @@ public:
 	virtual ~TransformInterpolationBuffer() = default;
 
 	// Sets the transform buffer size limit and removes old transforms
-	// if it is exceeded.
+	// if it is exceeded. Reallocates, hence not safe while other threads read the buffer.
 	void setSizeLimit(size_t bufferSizeLimit);
 
 	// Adds a new transform to the buffer and removes the oldest transform if the
@@ -37,10 +43,13 @@ public:
 	// Returns true if an interpolated transform can be computed at 'time'.
 	bool has(const Time &time) const;
 
-	// Returns an interpolated transform at 'time'. CHECK()s that a transform at
-	// 'time' is available.
+	// Returns an interpolated transform at 'time'. Throws if a transform at
+	// 'time' is not available.
 	Transform lookup(const Time &time) const;
 
+	// Same as lookup, but 'time' is clamped to the time range of the buffer. Throws if the buffer is empty.
+	Transform lookupClamped(const Time &time) const;
+
 	// Returns the timestamp of the earliest transform in the buffer or 0 if the
 	// buffer is empty. Earliest time is the one that is the closest to Jan 1,1,00
 	Time earliest_time() const;
@@ -58,19 +67,36 @@ public:
 	// Returns the current size of the transform buffer.
 	size_t size() const;
 
-	const TimestampedTransform& latest_measurement(int offsetFromLastElement = 0) const;
-	TimestampedTransform& latest_measurement(int offsetFromLastElement = 0);
+	// returned by value, the slot can be overwritten right after the call
+	TimestampedTransform latest_measurement(int offsetFromLastElement = 0) const;
 
 	void printTimesCurrentlyInBuffer() const;
 
 	void applyToAllElementsInTimeInterval(const Transform &t, const Time &begin, const Time &end );
 
 private:
-	void removeOldMeasurementsIfNeeded();
-	static constexpr size_t kUnlimitedBufferSize = std::numeric_limits<size_t>::max();
-
-	std::deque<TimestampedTransform> transforms_;
-	size_t bufferSizeLimit_ = kUnlimitedBufferSize;
+	// transforms that bracket the query time, copied out of the ring
+	struct Bracket {
+		size_t size_ = 0;
+		bool isInRange_ = false;
+		bool isExact_ = false;
+		Time time_; // query time, after clamping
+		TimestampedTransform start_, end_;
+	};
+	template<typename Read>
+	void readConsistent(Read &&read) const;
+	// has to be called within readConsistent
+	void findBracket(const Time &time, bool isClamp, Bracket *bracket) const;
+	const TimestampedTransform& at(size_t idx) const;
+	// both have to be called with modifierMutex_ locked
+	void beginWrite();
+	void endWrite();
+
+	std::vector<TimestampedTransform, Eigen::aligned_allocator<TimestampedTransform>> transforms_;
+	std::atomic<size_t> begin_ { 0 };
+	std::atomic<size_t> size_ { 0 };
+	// odd while a writer modifies the buffer
+	std::atomic<uint64> sequence_ { 0 };
 	mutable std::mutex modifierMutex_;
 };
 
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <mutex>
@@ -17,28 +18,80 @@
 namespace o3d_slam {
 
 
-struct VoxelWithIdxs {
-	std::map<std::string,std::vector<size_t>> idxs_;
+// read only view of a contiguous range, stays valid until the owner is modified
+template<typename T>
+class ConstSpan {
+public:
+	ConstSpan() = default;
+	ConstSpan(const T *begin, const T *end) :
+			begin_(begin), end_(end) {
+	}
+	const T* begin() const {
+		return begin_;
+	}
+	const T* end() const {
+		return end_;
+	}
+	size_t size() const {
+		return static_cast<size_t>(end_ - begin_);
+	}
+	bool empty() const {
+		return begin_ == end_;
+	}
+	const T& operator[](size_t i) const {
+		return begin_[i];
+	}
+private:
+	const T *begin_ = nullptr;
+	const T *end_ = nullptr;
 };
 
+struct VoxelWithIdxs {
+	size_t seqNumber_ = 0; // order in which the voxel was created, used to address the index arena
+};
 
+// Built once, each layer is filled by a single insertCloud call between two clear() calls. Every layer keeps
+// the point indices of all its voxels in one arena sorted by voxel (CSR layout), the range for voxel v is
+// [offsets_[v], offsets_[v + 1]). Voxels created by a later layer are past the end of the offsets and have
+// no indices in it, hence inserting a layer never touches the other layers. All the buffers are reused
+// after clear(), repeated builds do not allocate once the map has seen a cloud of similar size.
 class VoxelMap : public VoxelHashMap<VoxelWithIdxs>{
 	using BASE = VoxelHashMap<VoxelWithIdxs>;
 public:
+	using LayerId = uint8_t;
+	using IdxsView = ConstSpan<size_t>;
 	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 	VoxelMap();
 	VoxelMap(const Eigen::Vector3d &voxelSize);
-	void insertCloud(const std::string &layer, const open3d::geometry::PointCloud &cloud);
-	void insertCloud(const std::string &layer, const open3d::geometry::PointCloud &cloud, const std::vector<size_t> &idxs);
-	std::vector<size_t> getIndicesInVoxel(const std::string &layer, const Eigen::Vector3d &p) const;
-	std::vector<size_t> getIndicesInVoxel(const std::string &layer, const Eigen::Vector3i &voxelKey) const;
-	bool isVoxelHasLayer(const Eigen::Vector3i &key, const std::string &layer ) const;
+	// throws if the layer has been filled already
+	void insertCloud(LayerId layer, const open3d::geometry::PointCloud &cloud);
+	void insertCloud(LayerId layer, const open3d::geometry::PointCloud &cloud, const std::vector<size_t> &idxs);
+	IdxsView getIndicesInVoxel(LayerId layer, const Eigen::Vector3d &p) const;
+	IdxsView getIndicesInVoxel(LayerId layer, const Eigen::Vector3i &voxelKey) const;
+	IdxsView getIndicesInVoxel(LayerId layer, const VoxelWithIdxs &voxel) const;
+	bool isVoxelHasLayer(const Eigen::Vector3i &key, LayerId layer) const;
+	void clear();
+	// clears the map and changes the voxel size, keeps the allocated memory
+	void reset(const Eigen::Vector3d &voxelSize);
+
+private:
+	// removing a voxel would leave its indices behind in the arenas
+	using BASE::removeKey;
 
+	struct Layer {
+		std::vector<size_t> offsets_;
+		std::vector<size_t> arena_;
+	};
+	std::vector<Layer> layers_;
+	std::vector<size_t> seqNumberScratch_;
+	std::vector<size_t> cursorScratch_;
 };
 
 class VoxelizedPointCloud;
+class OccupancyVoxelMap;
 class AggregatedVoxel {
 	friend class VoxelizedPointCloud;
+	friend class OccupancyVoxelMap;
 public:
 	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 	Eigen::Vector3d getAggregatedPosition() const;
@@ -49,6 +102,7 @@ public:
 	Eigen::Vector3d aggregatedPosition_ = Eigen::Vector3d::Zero();
 	Eigen::Vector3d aggregatedNormal_ = Eigen::Vector3d::Zero();
 	Eigen::Vector3d aggregatedColor_ = Eigen::Vector3d::Zero();
+	float logOdds_ = 0.0f; // occupancy, only used by the OccupancyVoxelMap
 
 private:
 	// aggregate point has to be called before aggregate normal and aggregate color!!!!
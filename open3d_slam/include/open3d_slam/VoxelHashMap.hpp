@@ -15,23 +15,33 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <cmath>
+#include <limits>
 #include <vector>
 #include <unordered_map>
 #include <map>
 #include <open3d_slam/typedefs.hpp>
+#include <open3d_slam/RobinHoodHashMap.hpp>
 
 namespace o3d_slam {
 
 struct EigenVec3iHash {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-  static constexpr size_t sl = 17191;
-  static constexpr size_t sl2 = sl * sl;
 
   std::size_t operator()(const Eigen::Vector3i& index) const {
-    // same a OpenVDB
-//    return ((1 << 20) - 1) & (index.x() * 73856093 ^ index.y() * 19349663 ^ index.z() * 83492791);
-    return static_cast<unsigned int>(index.x() + index.y() * sl +
-                                     index.z() * sl2);
+    // pack 21 bits of each coordinate into one word and scramble it with the
+    // murmur3 finalizer. Linear combinations like x + y*sl + z*sl^2 collide
+    // a lot for negative indices and leave the low bits (which pick the bucket
+    // in a power of two table) poorly mixed.
+    constexpr uint64 kMask21 = (uint64(1) << 21) - 1;
+    uint64 h = (uint64(uint32(index.x())) & kMask21) | ((uint64(uint32(index.y())) & kMask21) << 21)
+        | ((uint64(uint32(index.z())) & kMask21) << 42);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb53fe1a85ec3ULL;
+    h ^= h >> 33;
+    return static_cast<std::size_t>(h);
   }
 };
 
@@ -96,6 +106,39 @@ inline bool isFirstVoxelWithinSecondVoxel(const Eigen::Vector3i &key1, const Eig
     return isWithinBounds<double>(firstVoxelCenter, secondVoxelLowerBound, secondVoxelUpperBound);
 }
 
+// Visits the voxels along the segment from begin to end (both included), Amanatides & Woo traversal.
+template<typename Visitor>
+void traverseVoxelsAlongRay(const Eigen::Vector3d &begin, const Eigen::Vector3d &end, const Eigen::Vector3d &voxelSize,
+		const InverseVoxelSize &inverseVoxelSize, Visitor visit) {
+	Eigen::Vector3i key = getVoxelIdx(begin, inverseVoxelSize);
+	const Eigen::Vector3i endKey = getVoxelIdx(end, inverseVoxelSize);
+	const Eigen::Vector3d direction = end - begin;
+	Eigen::Vector3i step;
+	Eigen::Vector3d tMax, tDelta;
+	for (int i = 0; i < 3; ++i) {
+		step(i) = direction(i) > 0.0 ? 1 : (direction(i) < 0.0 ? -1 : 0);
+		if (step(i) == 0) {
+			tMax(i) = tDelta(i) = std::numeric_limits<double>::max();
+			continue;
+		}
+		const double boundary = (key(i) + (step(i) > 0 ? 1 : 0)) * voxelSize(i);
+		tMax(i) = (boundary - begin(i)) / direction(i);
+		tDelta(i) = voxelSize(i) / std::abs(direction(i));
+	}
+	const int maxNumSteps = (endKey - key).cwiseAbs().sum();
+	visit(key);
+	for (int n = 0; n < maxNumSteps; ++n) {
+		int axis = 0;
+		tMax.minCoeff(&axis);
+		if (tMax(axis) > 1.0) {
+			break;
+		}
+		key(axis) += step(axis);
+		tMax(axis) += tDelta(axis);
+		visit(key);
+	}
+}
+
 std::vector<Eigen::Vector3i> getSmallerVoxelsWithinBigVoxel(const Eigen::Vector3i &bigVoxelKey, const Eigen::Vector3d &bigVoxelSize, const Eigen::Vector3d &smallVoxelSize);
 std::vector<Eigen::Vector3i> getVoxelsWithinPointNeighborhood(const Eigen::Vector3d &p,
     double neighborhoodRadius, const Eigen::Vector3d &smallVoxelSize);
@@ -105,7 +148,7 @@ public:
 EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   using Voxel_t = Voxel;
-  using ContainerImpl_t = std::unordered_map<Eigen::Vector3i, Voxel_t, EigenVec3iHash>;
+  using ContainerImpl_t = RobinHoodHashMap<Eigen::Vector3i, Voxel_t, EigenVec3iHash>;
 	VoxelHashMap() :
 			VoxelHashMap(Eigen::Vector3d::Constant(0.25)) {
 	}
@@ -139,6 +182,9 @@ EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 	void removeKey(const Eigen::Vector3i &k) {
 		voxels_.erase(k);
 	}
+	void reserve(size_t numVoxels) {
+		voxels_.reserve(numVoxels);
+	}
 
 	Voxel *getVoxelPtr(const Eigen::Vector3i &key) {
 		auto search = voxels_.find(key);
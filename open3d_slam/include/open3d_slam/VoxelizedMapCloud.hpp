@@ -0,0 +1,92 @@
+/*
+ * VoxelizedMapCloud.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+#include "open3d_slam/RobinHoodHashMap.hpp"
+#include "open3d_slam/Transform.hpp"
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/VoxelHashMap.hpp"
+
+namespace o3d_slam {
+
+class CroppingVolume;
+
+// Map point cloud together with a persistent voxel grid over it. Every voxel owns one point of the cloud,
+// which is the mean (position, normal, covariance) of all the points merged into that voxel so far, and
+// the number of those points. Inserting a scan only touches the voxels the scan falls into and removal
+// swaps the removed points with the last ones, hence both are O(scan size) and not O(map size).
+// Voxel keys live in the grid frame, which moves along with the cloud, so transform() does not re-key anything.
+class VoxelizedMapCloud {
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	VoxelizedMapCloud() = default;
+	// voxelSize <= 0 disables the voxelization, points are only appended then
+	explicit VoxelizedMapCloud(double voxelSize);
+
+	// takes the cloud as it is, points sharing a voxel are not merged, only the first one gets the voxel.
+	// The number of points merged into each voxel is lost, every point starts from one.
+	void setCloud(PointCloud &&cloud);
+	// new points within the cropping volume are merged into their voxels, the others are appended as they are.
+	// removedPoints gets the old voxel points that changed, addedPoints the new points and the updated voxel
+	// points. Both can be nullptr.
+	void insert(const PointCloud &scan, const CroppingVolume &croppingVolume, PointCloud *removedPoints,
+			PointCloud *addedPoints);
+	// idxs are sorted, the order of the remaining points changes
+	void remove(const std::vector<size_t> &idxs);
+	void transform(const Transform &T);
+	// re-indexes the cloud, the merged point counts are lost
+	void setVoxelSize(double voxelSize);
+
+	const PointCloud& getCloud() const;
+	double getVoxelSize() const;
+	size_t size() const;
+	bool empty() const;
+	size_t getNumVoxels() const;
+	// cloud and grid bookkeeping
+	size_t getMemoryFootprint() const;
+
+private:
+	struct ScanVoxel {
+		int numPoints_ = 0;
+		Eigen::Vector3d position_ = Eigen::Vector3d::Zero();
+		Eigen::Vector3d normal_ = Eigen::Vector3d::Zero();
+		Eigen::Matrix3d covariance_ = Eigen::Matrix3d::Zero();
+		Eigen::Vector3d color_ = Eigen::Vector3d::Zero();
+		bool isHasColor_ = false;
+	};
+	static constexpr uint32 kNotInGrid = 0;
+
+	Eigen::Vector3i getKey(const Eigen::Vector3d &p) const;
+	void indexCloud();
+	// drops the fields the scan does not have
+	void matchFieldsTo(const PointCloud &scan);
+	void appendPoint(const Eigen::Vector3d &p, const Eigen::Vector3d &normal, const Eigen::Vector3d &color,
+			const Eigen::Matrix3d &covariance, const Eigen::Vector3i &key, uint32 numPoints);
+
+	PointCloud cloud_;
+	double voxelSize_ = 0.0;
+	InverseVoxelSize inverseVoxelSize_;
+	Transform mapToGrid_ = Transform::Identity();
+	RobinHoodHashMap<Eigen::Vector3i, size_t, EigenVec3iHash> keyToPointIdx_;
+	// per point of the cloud, numMergedPoints_ is kNotInGrid for the points that do not own a voxel
+	std::vector<Eigen::Vector3i> keys_;
+	std::vector<uint32> numMergedPoints_;
+	// fields of the cloud during insert
+	bool isHasNormals_ = false;
+	bool isHasColors_ = false;
+	bool isHasCovariances_ = false;
+	// scratch for insert, reused to avoid allocations in the steady state
+	RobinHoodHashMap<Eigen::Vector3i, size_t, EigenVec3iHash> scanKeyToVoxelIdx_;
+	std::vector<ScanVoxel> scanVoxels_;
+	std::vector<Eigen::Vector3i> scanKeys_;
+};
+
+} // namespace o3d_slam
@@ -11,15 +11,17 @@
 #include <Eigen/Dense>
 #include "open3d_slam/SubmapCollection.hpp"
 #include "open3d_slam/Constraint.hpp"
+#include "open3d_slam/OdometryConstraintCache.hpp"
 
 
 
 namespace o3d_slam {
 
+// only the missing constraints and the ones whose submaps changed are (re)built, concurrently
 void computeOdometryConstraints(const SubmapCollection &submaps,
-		Constraints *constraints);
+		OdometryConstraintCache *constraints);
 void computeOdometryConstraints(const SubmapCollection &submaps, const SubmapCollection::TimestampedSubmapIds &candidates,
-		Constraints *constraints);
+		OdometryConstraintCache *constraints);
 
 Constraint buildOdometryConstraint(size_t sourceIdx, size_t targetIdx,
 		const SubmapCollection &submaps);
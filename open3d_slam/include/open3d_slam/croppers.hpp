@@ -11,6 +11,7 @@
 #include <vector>
 #include <open3d/geometry/PointCloud.h>
 #include <map>
+#include "open3d_slam/typedefs.hpp"
 
 
 namespace o3d_slam {
@@ -46,6 +47,8 @@ public:
   void setIsInvertVolume(bool val);
 	void setPose(const Eigen::Isometry3d &pose);
 	bool isWithinVolume(const Eigen::Vector3d &p) const;
+	// mask[i] = isWithinVolume(cloud.points_[i]), evaluated for the whole cloud at once
+	void computeMask(const PointCloud &cloud, std::vector<uint8> *mask) const;
 
 	Indices getIndicesWithinVolume(const PointCloud &cloud) const;
 	std::shared_ptr<PointCloud> crop(const PointCloud &cloud) const;
@@ -54,6 +57,8 @@ public:
 
 protected:
   virtual bool isWithinVolumeImpl(const Eigen::Vector3d &p) const;
+  // has to agree with isWithinVolumeImpl, default just calls it for every point
+  virtual void computeMaskImpl(const std::vector<Eigen::Vector3d> &points, std::vector<uint8> *mask) const;
 	Eigen::Isometry3d pose_=Eigen::Isometry3d::Identity();
 	bool isInvertVolume_ = false;
 };
@@ -66,6 +71,7 @@ public:
 	void setParameters(double radiusMin, double radiusMax);
 private:
   bool isWithinVolumeImpl(const Eigen::Vector3d &p) const final;
+  void computeMaskImpl(const std::vector<Eigen::Vector3d> &points, std::vector<uint8> *mask) const final;
 	double radiusMin_=0.0;
 	double radiusMax_=1e4;
 };
@@ -78,6 +84,7 @@ public:
 	void setParameters(double radius);
 private:
   bool isWithinVolumeImpl(const Eigen::Vector3d &p) const final;
+  void computeMaskImpl(const std::vector<Eigen::Vector3d> &points, std::vector<uint8> *mask) const final;
 	double radius_=1e6;
 
 };
@@ -92,6 +99,7 @@ public:
 
 private:
   bool isWithinVolumeImpl(const Eigen::Vector3d &p) const final;
+  void computeMaskImpl(const std::vector<Eigen::Vector3d> &points, std::vector<uint8> *mask) const final;
 	double radius_=0.0;
 
 };
@@ -106,6 +114,7 @@ public:
 
 private:
   bool isWithinVolumeImpl(const Eigen::Vector3d &p) const final;
+  void computeMaskImpl(const std::vector<Eigen::Vector3d> &points, std::vector<uint8> *mask) const final;
 
 
 	double radius_=1e6;
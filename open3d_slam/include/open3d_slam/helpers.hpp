@@ -24,6 +24,11 @@ std::shared_ptr<open3d::geometry::PointCloud> voxelizeWithinCroppingVolume(doubl
 		const CroppingVolume &croppingVolume, const open3d::geometry::PointCloud &cloud);
 void randomDownSample(double downSamplingRatio, open3d::geometry::PointCloud *pcl);
 void voxelize(double voxelSize, open3d::geometry::PointCloud *pcl);
+// crop followed by voxelize in a single pass over the input, no intermediate cloud is built.
+// The voxel grid is aligned with the origin (getVoxelIdx), whereas VoxelDownSample anchors it at the
+// min bound of the cloud, hence the voxels and their averages are not the same as with VoxelDownSample.
+std::shared_ptr<open3d::geometry::PointCloud> cropAndVoxelize(const CroppingVolume &croppingVolume, double voxelSize,
+		const open3d::geometry::PointCloud &cloud);
 
 void estimateNormals(int numNearestNeighbours, open3d::geometry::PointCloud *pcl);
 
@@ -50,9 +55,9 @@ double getMapVoxelSize(const MapBuilderParameters &p, double valueIfZero);
 bool isValidColor(const Eigen::Vector3d &c);
 
 Eigen::Vector3d computeCenter(const VoxelizedPointCloud &voxels);
-std::vector<Eigen::Vector3i> getKeysOfCarvedPoints(const PointCloud &scan,
-		const VoxelizedPointCloud &cloud, const Eigen::Vector3d &sensorPosition, const SpaceCarvingParameters &param);
 
 std::shared_ptr<PointCloud> removePointsWithNonFiniteValues(const PointCloud& in);
+// also drops the time offsets of the removed points, pointTimeOffsets has one entry per point
+std::shared_ptr<PointCloud> removePointsWithNonFiniteValues(const PointCloud& in, std::vector<float> *pointTimeOffsets);
 
 } /* namespace o3d_slam */
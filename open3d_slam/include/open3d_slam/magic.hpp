@@ -15,5 +15,7 @@ static const double voxelExpansionFactorOverlapComputation = 20.0;
 static const double voxelExpansionFactorIcpCorrespondenceDistance = 1.5;
 static const double voxelExpansionFactorAdjacencyBasedRevisiting = 2.5;
 static const size_t skipFirstNPointClouds = 5;
+static const size_t globalDescriptorNumNearestRingKeysPerCandidate = 5;
+static const int motionCompensationNumTimeBins = 1024;
 } // namespace magic
 } // namespace o3d_slam
@@ -28,6 +28,12 @@ Transform fromXYZandRPY(double x, double y, double z, double roll, double pitch,
 Transform fromXYZandQuaternion(double x, double y, double z, const Eigen::Quaterniond &q);
 Transform fromXYZandQuaternion(const Eigen::Vector3d &xyz, const Eigen::Quaterniond &q);
 
+// eigenvector of the smallest eigenvalue, i.e. the normal of the plane fitted through the points
+Eigen::Vector3d normalFromCovariance(const Eigen::Matrix3d &covariance);
+// unit normal pointing towards the viewpoint, same as open3d's OrientNormalsTowardsCameraLocation
+Eigen::Vector3d orientNormalTowardsViewpoint(const Eigen::Vector3d &normal, const Eigen::Vector3d &point,
+		const Eigen::Vector3d &viewpoint);
+
 template<typename T>
 inline T getRollFromQuat(T w, T x, T y, T z)
 {
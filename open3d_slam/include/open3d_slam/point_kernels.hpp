@@ -0,0 +1,37 @@
+/*
+ * point_kernels.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+#include "open3d_slam/typedefs.hpp"
+
+namespace o3d_slam {
+namespace kernels {
+
+// Batched kernels over the point buffers of open3d::geometry::PointCloud.
+// On x86-64 CPUs with AVX the points are deinterleaved four at a time into x, y, z registers,
+// everywhere else a scalar loop is used. Both paths do the same operations in the same order,
+// so they give bit identical results. The cpu is checked once at runtime, no special compile flags are needed.
+
+// out[i] = A * in[i] + t, out is resized to in.size(), in place (out == &in) is allowed
+void affineTransform(const Eigen::Matrix3d &A, const Eigen::Vector3d &t, const std::vector<Eigen::Vector3d> &in,
+		std::vector<Eigen::Vector3d> *out);
+
+// mask[i] = 1 if minRadius <= |points[i] - center| <= maxRadius, 0 otherwise
+void computeSphericalShellMask(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center,
+		double minRadius, double maxRadius, std::vector<uint8> *mask);
+
+// mask[i] = 1 if minZ <= points[i].z() <= maxZ and the xy distance to the center is <= radius, 0 otherwise
+void computeCylinderMask(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center, double radius,
+		double minZ, double maxZ, std::vector<uint8> *mask);
+
+bool isAvxEnabled();
+
+} // namespace kernels
+} // namespace o3d_slam
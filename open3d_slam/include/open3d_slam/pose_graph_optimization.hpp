@@ -0,0 +1,24 @@
+/*
+ * pose_graph_optimization.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <open3d/pipelines/registration/GlobalOptimization.h>
+#include <open3d/pipelines/registration/PoseGraph.h>
+
+namespace o3d_slam {
+
+// Levenberg-Marquardt on the pose graph with a sparse Cholesky solver. It is a drop in for
+// open3d's GlobalOptimization (same options, line process for the uncertain edges and edge pruning),
+// but the linear system is sparse, so the cost grows with the number of edges and not cubically
+// with the number of nodes. The node poses in the graph are used as the initial guess, hence when the
+// graph is optimized repeatedly with only a few new edges and nodes it converges in a couple of iterations.
+void sparseGlobalOptimization(const open3d::pipelines::registration::GlobalOptimizationConvergenceCriteria &criteria,
+		const open3d::pipelines::registration::GlobalOptimizationOption &option,
+		open3d::pipelines::registration::PoseGraph *graph);
+
+} // namespace o3d_slam
@@ -0,0 +1,33 @@
+/*
+ * serialization.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <open3d/pipelines/registration/Feature.h>
+#include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/Voxel.hpp"
+#include "open3d_slam/OccupancyVoxelMap.hpp"
+
+namespace o3d_slam {
+
+// Raw little endian dumps, meant for files read back by the same build on the same machine.
+// Every array is prefixed by its length, the readers return false on a truncated stream.
+void serialize(const PointCloud &cloud, std::ostream *out);
+bool deserialize(std::istream &in, PointCloud *cloud);
+
+void serialize(const open3d::pipelines::registration::Feature &feature, std::ostream *out);
+bool deserialize(std::istream &in, open3d::pipelines::registration::Feature *feature);
+
+void serialize(const VoxelizedPointCloud &voxels, std::ostream *out);
+bool deserialize(std::istream &in, VoxelizedPointCloud *voxels);
+
+void serialize(const OccupancyVoxelMap &voxels, std::ostream *out);
+bool deserialize(std::istream &in, OccupancyVoxelMap *voxels);
+
+} // namespace o3d_slam
@@ -5,11 +5,95 @@
  *      Author: jelavice
  */
 #include "open3d_slam/CloudRegistration.hpp"
+#include "open3d_slam/IncrementalKdTree.hpp"
+#include "open3d_slam/Voxel.hpp"
 #include "open3d_slam/helpers.hpp"
+#include "open3d_slam/croppers.hpp"
 #include "open3d_slam/assert.hpp"
 
+#include <cmath>
+
+#ifdef open3d_slam_OPENMP_FOUND
+#include <omp.h>
+#endif
+
 namespace o3d_slam {
 using namespace open3d::pipelines::registration;
+
+namespace {
+
+// matched target points are gathered into targetMatched, the correspondence set indexes into it
+RegistrationResult computeCorrespondences(const PointCloud &source, const IncrementalKdTree &target,
+		const CroppingVolume *targetVolume, double maxCorrespondenceDistance, const Eigen::Matrix4d &transformation,
+		PointCloud *targetMatched) {
+	const size_t nPoints = source.points_.size();
+	std::vector<IncrementalKdTree::Neighbor> neighbors(nPoints);
+	std::vector<char> isFound(nPoints, 0);
+#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < nPoints; ++i) {
+		isFound[i] = target.findNearest(source.points_[i], maxCorrespondenceDistance, targetVolume, &neighbors[i]);
+	}
+	RegistrationResult result(transformation);
+	targetMatched->Clear();
+	targetMatched->points_.reserve(nPoints);
+	if (target.hasNormals()) {
+		targetMatched->normals_.reserve(nPoints);
+	}
+	result.correspondence_set_.reserve(nPoints);
+	double error2 = 0.0;
+	for (size_t i = 0; i < nPoints; ++i) {
+		if (!isFound[i]) {
+			continue;
+		}
+		result.correspondence_set_.emplace_back(int(i), int(targetMatched->points_.size()));
+		targetMatched->points_.push_back(neighbors[i].point_);
+		if (target.hasNormals()) {
+			targetMatched->normals_.push_back(neighbors[i].normal_);
+		}
+		error2 += neighbors[i].squaredDistance_;
+	}
+	if (!result.correspondence_set_.empty()) {
+		const double nCorrespondences = result.correspondence_set_.size();
+		result.fitness_ = nCorrespondences / nPoints;
+		result.inlier_rmse_ = std::sqrt(error2 / nCorrespondences);
+	}
+	return result;
+}
+
+// same iteration scheme as open3d's RegistrationICP
+RegistrationResult registerCloudToIndexImpl(const PointCloud &source, const IncrementalKdTree &target,
+		const CroppingVolume *targetVolume, double maxCorrespondenceDistance, const Transform &init, const TransformationEstimation &estimation,
+		const ICPConvergenceCriteria &criteria) {
+	assert_gt(maxCorrespondenceDistance, 0.0, "maxCorrespondenceDistance");
+	Eigen::Matrix4d transformation = init.matrix();
+	PointCloud sourceTransformed = source;
+	sourceTransformed.Transform(transformation);
+	PointCloud targetMatched;
+	RegistrationResult result = computeCorrespondences(sourceTransformed, target, targetVolume,
+			maxCorrespondenceDistance, transformation, &targetMatched);
+	for (int i = 0; i < criteria.max_iteration_; ++i) {
+		const Eigen::Matrix4d update = estimation.ComputeTransformation(sourceTransformed, targetMatched,
+				result.correspondence_set_);
+		transformation = update * transformation;
+		sourceTransformed.Transform(update);
+		const RegistrationResult prevResult = result;
+		result = computeCorrespondences(sourceTransformed, target, targetVolume, maxCorrespondenceDistance,
+				transformation, &targetMatched);
+		if (std::abs(prevResult.fitness_ - result.fitness_) < criteria.relative_fitness_
+				&& std::abs(prevResult.inlier_rmse_ - result.inlier_rmse_) < criteria.relative_rmse_) {
+			break;
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+CloudRegistration::RegistrationResult CloudRegistration::registerCloudToIndex(const PointCloud &source,
+		const IncrementalKdTree &target, const CroppingVolume *targetVolume, const Transform &init) const {
+	throw std::runtime_error("CloudRegistration::registerCloudToIndex not supported for this registration type");
+}
+
 ////////////////////////////////
 /////// generalized
 ////////////////////////////////
@@ -47,6 +131,12 @@ RegistrationIcpPointToPlane::RegistrationResult RegistrationIcpPointToPlane::reg
 		source, target, maxCorrespondenceDistance_,
 		init.matrix(),pointToPlane_ , icpConvergenceCriteria_);
 }
+RegistrationIcpPointToPlane::RegistrationResult RegistrationIcpPointToPlane::registerCloudToIndex(
+		const PointCloud &source, const IncrementalKdTree &target, const CroppingVolume *targetVolume,
+		const Transform &init) const {
+	return registerCloudToIndexImpl(source, target, targetVolume, maxCorrespondenceDistance_, init, pointToPlane_,
+			icpConvergenceCriteria_);
+}
 void RegistrationIcpPointToPlane::estimateNormalsOrCovariancesIfNeeded(PointCloud *cloud) const {
 	assert_gt(maxRadiusNormalEstimation_,0.0,"maxRadiusNormalEstimation_");
 	assert_gt(knnNormalEstimation_,0,"knnNormalEstimation_");
@@ -74,12 +164,181 @@ RegistrationIcpPointToPoint::RegistrationResult RegistrationIcpPointToPoint::reg
 		init.matrix(),TransformationEstimationPointToPoint() , icpConvergenceCriteria_);
 }
 
+RegistrationIcpPointToPoint::RegistrationResult RegistrationIcpPointToPoint::registerCloudToIndex(
+		const PointCloud &source, const IncrementalKdTree &target, const CroppingVolume *targetVolume,
+		const Transform &init) const {
+	return registerCloudToIndexImpl(source, target, targetVolume, maxCorrespondenceDistance_, init,
+			TransformationEstimationPointToPoint(), icpConvergenceCriteria_);
+}
+
 std::unique_ptr<RegistrationIcpPointToPoint> createPointToPointIcp(const CloudRegistrationParameters &p){
 	auto ret  = std::make_unique<RegistrationIcpPointToPoint>();
 	ret->maxCorrespondenceDistance_ = p.icp_.maxCorrespondenceDistance_;
 	ret->icpConvergenceCriteria_.max_iteration_ = p.icp_.maxNumIter_;
 	return std::move(ret);
 }
+////////////////////////////////
+/////// voxel hash point to plane
+////////////////////////////////
+namespace {
+const VoxelMap::LayerId targetLayer = 0;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+struct NormalEquations {
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	Matrix6d JTJ_ = Matrix6d::Zero();
+	Vector6d JTr_ = Vector6d::Zero();
+	size_t numCorrespondences_ = 0;
+};
+
+int findClosestInNeighboringVoxels(const VoxelMap &voxelMap, const PointCloud &target, const Eigen::Vector3d &p,
+		double maxSquaredDistance, double *squaredDistance) {
+	const Eigen::Vector3i key = voxelMap.getKey(p);
+	int closest = -1;
+	*squaredDistance = maxSquaredDistance;
+	for (int dx = -1; dx <= 1; ++dx) {
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dz = -1; dz <= 1; ++dz) {
+				for (const size_t idx : voxelMap.getIndicesInVoxel(targetLayer, Eigen::Vector3i(key + Eigen::Vector3i(dx, dy, dz)))) {
+					const double d2 = (target.points_[idx] - p).squaredNorm();
+					if (d2 < *squaredDistance) {
+						*squaredDistance = d2;
+						closest = static_cast<int>(idx);
+					}
+				}
+			}
+		}
+	}
+	return closest;
+}
+
+// finds the correspondences for source transformed with T and accumulates the point to plane normal equations.
+// Every thread has its own accumulator, they are summed up in a fixed order so the result does not depend on timing.
+NormalEquations accumulateNormalEquations(const PointCloud &source, const PointCloud &target,
+		const VoxelMap &voxelMap, const Transform &T, double maxCorrespondenceDistance,
+		std::vector<int> *correspondences, std::vector<double> *squaredDistances) {
+	const size_t nPoints = source.points_.size();
+	const double maxSquaredDistance = maxCorrespondenceDistance * maxCorrespondenceDistance;
+#ifdef open3d_slam_OPENMP_FOUND
+	const int nThreads = omp_get_max_threads();
+#else
+	const int nThreads = 1;
+#endif
+	std::vector<NormalEquations, Eigen::aligned_allocator<NormalEquations>> perThread(nThreads);
+#pragma omp parallel num_threads(nThreads)
+	{
+#ifdef open3d_slam_OPENMP_FOUND
+		NormalEquations &eq = perThread[omp_get_thread_num()];
+#else
+		NormalEquations &eq = perThread[0];
+#endif
+#pragma omp for schedule(static)
+		for (size_t i = 0; i < nPoints; ++i) {
+			const Eigen::Vector3d p = T * source.points_[i];
+			const int idx = findClosestInNeighboringVoxels(voxelMap, target, p, maxSquaredDistance,
+					&(*squaredDistances)[i]);
+			(*correspondences)[i] = idx;
+			if (idx < 0) {
+				continue;
+			}
+			const Eigen::Vector3d &n = target.normals_[idx];
+			const double residual = n.dot(p - target.points_[idx]);
+			Vector6d J;
+			J << p.cross(n), n;
+			eq.JTJ_.noalias() += J * J.transpose();
+			eq.JTr_.noalias() += J * residual;
+			++eq.numCorrespondences_;
+		}
+	}
+	NormalEquations sum;
+	for (const auto &eq : perThread) {
+		sum.JTJ_ += eq.JTJ_;
+		sum.JTr_ += eq.JTr_;
+		sum.numCorrespondences_ += eq.numCorrespondences_;
+	}
+	return sum;
+}
+
+Transform toTransform(const Vector6d &rotationTranslation) {
+	const Eigen::Vector3d omega = rotationTranslation.head<3>();
+	const double angle = omega.norm();
+	Transform T = Transform::Identity();
+	if (angle > 1e-12) {
+		T.linear() = Eigen::AngleAxisd(angle, omega / angle).toRotationMatrix();
+	}
+	T.translation() = rotationTranslation.tail<3>();
+	return T;
+}
+
+} // namespace
+
+RegistrationVoxelHashIcpPointToPlane::RegistrationResult RegistrationVoxelHashIcpPointToPlane::registerClouds(
+		const PointCloud &source, const PointCloud &target, const Transform &init) const {
+	assert_gt(maxCorrespondenceDistance_, 0.0, "maxCorrespondenceDistance_");
+	if (!target.HasNormals()) {
+		throw std::runtime_error("RegistrationVoxelHashIcpPointToPlane: target cloud has no normals");
+	}
+	// voxel edge equals the correspondence distance, so the 27 neighbouring voxels cover the search radius
+	thread_local VoxelMap voxelMap;
+	voxelMap.reset(Eigen::Vector3d::Constant(maxCorrespondenceDistance_));
+	voxelMap.insertCloud(targetLayer, target);
+
+	const size_t nPoints = source.points_.size();
+	std::vector<int> correspondences(nPoints, -1);
+	std::vector<double> squaredDistances(nPoints, 0.0);
+	Transform T = init;
+	for (int i = 0; i < maxNumIter_; ++i) {
+		const NormalEquations eq = accumulateNormalEquations(source, target, voxelMap, T,
+				maxCorrespondenceDistance_, &correspondences, &squaredDistances);
+		if (eq.numCorrespondences_ < 6) {
+			break;
+		}
+		const Vector6d dx = eq.JTJ_.ldlt().solve(-eq.JTr_);
+		T = toTransform(dx) * T;
+		if (dx.norm() < minIncrementNorm_) {
+			break;
+		}
+	}
+
+	// evaluate at the final estimate
+	accumulateNormalEquations(source, target, voxelMap, T, maxCorrespondenceDistance_, &correspondences,
+			&squaredDistances);
+	RegistrationResult result(T.matrix());
+	result.correspondence_set_.reserve(nPoints);
+	double error2 = 0.0;
+	for (size_t i = 0; i < nPoints; ++i) {
+		if (correspondences[i] >= 0) {
+			result.correspondence_set_.emplace_back(int(i), correspondences[i]);
+			error2 += squaredDistances[i];
+		}
+	}
+	if (!result.correspondence_set_.empty()) {
+		const double nCorrespondences = result.correspondence_set_.size();
+		result.fitness_ = nCorrespondences / nPoints;
+		result.inlier_rmse_ = std::sqrt(error2 / nCorrespondences);
+	}
+	return result;
+}
+
+void RegistrationVoxelHashIcpPointToPlane::estimateNormalsOrCovariancesIfNeeded(PointCloud *cloud) const {
+	assert_gt(maxRadiusNormalEstimation_,0.0,"maxRadiusNormalEstimation_");
+	assert_gt(knnNormalEstimation_,0,"knnNormalEstimation_");
+	open3d::geometry::KDTreeSearchParamHybrid param(maxRadiusNormalEstimation_, knnNormalEstimation_);
+	cloud->EstimateNormals(param);
+	cloud->NormalizeNormals();
+	cloud->OrientNormalsTowardsCameraLocation();
+}
+
+std::unique_ptr<RegistrationVoxelHashIcpPointToPlane> createVoxelHashPointToPlaneIcp(const CloudRegistrationParameters &p) {
+	auto ret  = std::make_unique<RegistrationVoxelHashIcpPointToPlane>();
+	ret->maxCorrespondenceDistance_ = p.icp_.maxCorrespondenceDistance_;
+	ret->knnNormalEstimation_ = p.icp_.knn_;
+	ret->maxRadiusNormalEstimation_ = p.icp_.maxDistanceKnn_;
+	ret->maxNumIter_ = p.icp_.maxNumIter_;
+	ret->minIncrementNorm_ = p.icp_.minIncrementNorm_;
+	return std::move(ret);
+}
+
 ////////////////////////////////
 /////// factory
 ////////////////////////////////
@@ -95,6 +354,9 @@ std::unique_ptr<CloudRegistration> cloudRegistrationFactory(const CloudRegistrat
 	case 	CloudRegistrationType::GeneralizedIcp:{
 		return createGeneralizedIcp(p);
 	}
+	case 	CloudRegistrationType::VoxelHashPointToPlaneIcp:{
+		return createVoxelHashPointToPlaneIcp(p);
+	}
 
 	default:
 		throw std::runtime_error("cloud: unknown type of cloud registration");
@@ -0,0 +1,296 @@
+/*
+ * IncrementalKdTree.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/IncrementalKdTree.hpp"
+#include "open3d_slam/croppers.hpp"
+
+#include <algorithm>
+
+namespace o3d_slam {
+
+namespace {
+const uint32 kMinSubtreeSizeForRebuild = 16;
+const double kMaxChildSizeRatio = 0.7; // subtree is unbalanced if one child holds more than this fraction of nodes
+const double kMaxDeletedRatio = 0.5; // subtree is rebuilt if more than this fraction of nodes is deleted
+const Eigen::Vector3d kZeroNormal = Eigen::Vector3d::Zero();
+} // namespace
+
+void IncrementalKdTree::build(const PointCloud &cloud) {
+	clear();
+	const size_t n = cloud.points_.size();
+	isHasNormals_ = cloud.HasNormals();
+	if (n == 0) {
+		return;
+	}
+	nodes_.reserve(n);
+	rebuildScratch_.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		rebuildScratch_[i] = createNode(cloud.points_[i], isHasNormals_ ? cloud.normals_[i] : kZeroNormal);
+	}
+	root_ = buildSubtree(rebuildScratch_.begin(), rebuildScratch_.end());
+	numLive_ = n;
+}
+
+void IncrementalKdTree::insert(const PointCloud &cloud) {
+	isHasNormals_ = empty() ? cloud.HasNormals() : isHasNormals_ && cloud.HasNormals();
+	for (size_t i = 0; i < cloud.points_.size(); ++i) {
+		insert(cloud.points_[i], cloud.HasNormals() ? cloud.normals_[i] : kZeroNormal);
+	}
+}
+
+void IncrementalKdTree::insert(const Eigen::Vector3d &p, const Eigen::Vector3d &normal) {
+	const int32 newId = createNode(p, normal);
+	++numLive_;
+	if (root_ < 0) {
+		root_ = newId;
+		return;
+	}
+	path_.clear();
+	int32 current = root_;
+	while (true) {
+		path_.push_back(current);
+		Node &node = nodes_[current];
+		++node.size_;
+		node.minBound_ = node.minBound_.cwiseMin(p);
+		node.maxBound_ = node.maxBound_.cwiseMax(p);
+		int32 &child = p(node.axis_) < node.point_(node.axis_) ? node.left_ : node.right_;
+		if (child < 0) {
+			child = newId;
+			nodes_[newId].axis_ = (node.axis_ + 1) % 3;
+			break;
+		}
+		current = child;
+	}
+	rebalanceAlongPath();
+}
+
+void IncrementalKdTree::remove(const PointCloud &cloud) {
+	for (const auto &p : cloud.points_) {
+		remove(p);
+	}
+}
+
+bool IncrementalKdTree::remove(const Eigen::Vector3d &p) {
+	path_.clear();
+	if (!removeRecursive(root_, p)) {
+		return false;
+	}
+	--numLive_;
+	if (numLive_ == 0) {
+		clear();
+		return true;
+	}
+	std::reverse(path_.begin(), path_.end());
+	rebalanceAlongPath();
+	return true;
+}
+
+bool IncrementalKdTree::findNearest(const Eigen::Vector3d &query, double maxDistance, Neighbor *neighbor) const {
+	return findNearest(query, maxDistance, nullptr, neighbor);
+}
+
+bool IncrementalKdTree::findNearest(const Eigen::Vector3d &query, double maxDistance, const CroppingVolume *volume,
+		Neighbor *neighbor) const {
+	int32 best = -1;
+	double bestSquaredDistance = maxDistance * maxDistance;
+	findNearestRecursive(root_, query, volume, &best, &bestSquaredDistance);
+	if (best < 0) {
+		return false;
+	}
+	neighbor->point_ = nodes_[best].point_;
+	neighbor->normal_ = nodes_[best].normal_;
+	neighbor->squaredDistance_ = bestSquaredDistance;
+	return true;
+}
+
+void IncrementalKdTree::clear() {
+	nodes_.clear();
+	freeNodes_.clear();
+	root_ = -1;
+	numLive_ = 0;
+}
+
+size_t IncrementalKdTree::size() const {
+	return numLive_;
+}
+
+bool IncrementalKdTree::empty() const {
+	return numLive_ == 0;
+}
+
+bool IncrementalKdTree::hasNormals() const {
+	return isHasNormals_;
+}
+
+int32 IncrementalKdTree::createNode(const Eigen::Vector3d &p, const Eigen::Vector3d &normal) {
+	int32 id;
+	if (freeNodes_.empty()) {
+		id = static_cast<int32>(nodes_.size());
+		nodes_.emplace_back();
+	} else {
+		id = freeNodes_.back();
+		freeNodes_.pop_back();
+		nodes_[id] = Node();
+	}
+	Node &node = nodes_[id];
+	node.point_ = p;
+	node.normal_ = normal;
+	node.minBound_ = p;
+	node.maxBound_ = p;
+	return id;
+}
+
+int32 IncrementalKdTree::buildSubtree(std::vector<int32>::iterator begin, std::vector<int32>::iterator end) {
+	if (begin == end) {
+		return -1;
+	}
+	Eigen::Vector3d minBound = nodes_[*begin].point_;
+	Eigen::Vector3d maxBound = minBound;
+	for (auto it = begin; it != end; ++it) {
+		minBound = minBound.cwiseMin(nodes_[*it].point_);
+		maxBound = maxBound.cwiseMax(nodes_[*it].point_);
+	}
+	Eigen::Vector3d::Index axis;
+	(maxBound - minBound).maxCoeff(&axis);
+	const auto mid = begin + (end - begin) / 2;
+	std::nth_element(begin, mid, end, [this, axis](int32 a, int32 b) {
+		return nodes_[a].point_(axis) < nodes_[b].point_(axis);
+	});
+	const int32 id = *mid;
+	nodes_[id].axis_ = static_cast<uint8>(axis);
+	nodes_[id].isDeleted_ = false;
+	nodes_[id].left_ = buildSubtree(begin, mid);
+	nodes_[id].right_ = buildSubtree(mid + 1, end);
+	updateFromChildren(id);
+	return id;
+}
+
+void IncrementalKdTree::updateFromChildren(int32 id) {
+	Node &node = nodes_[id];
+	node.size_ = 1;
+	node.numDeleted_ = node.isDeleted_ ? 1 : 0;
+	node.minBound_ = node.point_;
+	node.maxBound_ = node.point_;
+	for (const int32 child : { node.left_, node.right_ }) {
+		if (child < 0) {
+			continue;
+		}
+		const Node &c = nodes_[child];
+		node.size_ += c.size_;
+		node.numDeleted_ += c.numDeleted_;
+		node.minBound_ = node.minBound_.cwiseMin(c.minBound_);
+		node.maxBound_ = node.maxBound_.cwiseMax(c.maxBound_);
+	}
+}
+
+void IncrementalKdTree::collectSubtree(int32 id, std::vector<int32> *live) {
+	if (id < 0) {
+		return;
+	}
+	const Node &node = nodes_[id];
+	collectSubtree(node.left_, live);
+	collectSubtree(node.right_, live);
+	if (node.isDeleted_) {
+		freeNodes_.push_back(id);
+	} else {
+		live->push_back(id);
+	}
+}
+
+void IncrementalKdTree::rebuildSubtree(size_t pathIdx) {
+	const int32 id = path_[pathIdx];
+	const uint32 numDropped = nodes_[id].numDeleted_;
+	rebuildScratch_.clear();
+	collectSubtree(id, &rebuildScratch_);
+	const int32 newId = buildSubtree(rebuildScratch_.begin(), rebuildScratch_.end());
+	if (pathIdx == 0) {
+		root_ = newId;
+	} else {
+		Node &parent = nodes_[path_[pathIdx - 1]];
+		(parent.left_ == id ? parent.left_ : parent.right_) = newId;
+	}
+	for (size_t i = 0; i < pathIdx; ++i) {
+		nodes_[path_[i]].size_ -= numDropped;
+		nodes_[path_[i]].numDeleted_ -= numDropped;
+	}
+}
+
+void IncrementalKdTree::rebalanceAlongPath() {
+	// rebuild the topmost subtree that went out of balance, everything below it is rebuilt as well
+	for (size_t i = 0; i < path_.size(); ++i) {
+		if (isUnbalanced(path_[i])) {
+			rebuildSubtree(i);
+			return;
+		}
+	}
+}
+
+bool IncrementalKdTree::isUnbalanced(int32 id) const {
+	const Node &node = nodes_[id];
+	if (node.size_ < kMinSubtreeSizeForRebuild) {
+		return false;
+	}
+	const uint32 leftSize = node.left_ < 0 ? 0 : nodes_[node.left_].size_;
+	const uint32 rightSize = node.right_ < 0 ? 0 : nodes_[node.right_].size_;
+	return std::max(leftSize, rightSize) > kMaxChildSizeRatio * node.size_
+			|| node.numDeleted_ > kMaxDeletedRatio * node.size_;
+}
+
+bool IncrementalKdTree::removeRecursive(int32 id, const Eigen::Vector3d &p) {
+	if (id < 0) {
+		return false;
+	}
+	Node &node = nodes_[id];
+	if (node.numDeleted_ == node.size_ || (p.array() < node.minBound_.array()).any()
+			|| (p.array() > node.maxBound_.array()).any()) {
+		return false;
+	}
+	bool isRemoved = false;
+	if (!node.isDeleted_ && node.point_ == p) {
+		node.isDeleted_ = true;
+		isRemoved = true;
+	} else {
+		// points equal to the splitting value can end up on both sides
+		const double diff = p(node.axis_) - node.point_(node.axis_);
+		isRemoved = (diff <= 0.0 && removeRecursive(node.left_, p)) || (diff >= 0.0 && removeRecursive(node.right_, p));
+	}
+	if (isRemoved) {
+		++node.numDeleted_;
+		path_.push_back(id);
+	}
+	return isRemoved;
+}
+
+void IncrementalKdTree::findNearestRecursive(int32 id, const Eigen::Vector3d &query, const CroppingVolume *volume,
+		int32 *best, double *bestSquaredDistance) const {
+	if (id < 0) {
+		return;
+	}
+	const Node &node = nodes_[id];
+	if (node.numDeleted_ == node.size_ || squaredDistanceToBounds(node, query) >= *bestSquaredDistance) {
+		return;
+	}
+	if (!node.isDeleted_) {
+		const double squaredDistance = (node.point_ - query).squaredNorm();
+		// the volume is only checked for points that would win, the pruning by distance stays valid
+		if (squaredDistance < *bestSquaredDistance && (volume == nullptr || volume->isWithinVolume(node.point_))) {
+			*bestSquaredDistance = squaredDistance;
+			*best = id;
+		}
+	}
+	const bool isLeftFirst = query(node.axis_) < node.point_(node.axis_);
+	findNearestRecursive(isLeftFirst ? node.left_ : node.right_, query, volume, best, bestSquaredDistance);
+	findNearestRecursive(isLeftFirst ? node.right_ : node.left_, query, volume, best, bestSquaredDistance);
+}
+
+double IncrementalKdTree::squaredDistanceToBounds(const Node &node, const Eigen::Vector3d &p) const {
+	const Eigen::Vector3d below = (node.minBound_ - p).cwiseMax(0.0);
+	const Eigen::Vector3d above = (p - node.maxBound_).cwiseMax(0.0);
+	return (below + above).squaredNorm();
+}
+
+} // namespace o3d_slam
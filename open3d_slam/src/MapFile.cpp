@@ -0,0 +1,284 @@
+/*
+ * MapFile.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/MapFile.hpp"
+#include "open3d_slam/assert.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace o3d_slam {
+
+namespace {
+
+const char kMagic[8] = { 'O', '3', 'D', 'S', 'L', 'A', 'M', '\0' };
+const uint32 kVersion = 2;
+const uint64 kAlignment = 64;
+
+struct ArrayRecord {
+	uint64 offset_ = 0;
+	uint64 count_ = 0; // number of elements
+};
+
+struct Header {
+	char magic_[8];
+	uint32 version_ = kVersion;
+	uint32 submapRecordSize_ = 0;
+	uint64 fileSize_ = 0;
+	uint64 numSubmaps_ = 0;
+	uint64 submapTableOffset_ = 0;
+};
+
+struct SubmapRecord {
+	int64 id_ = 0;
+	int64 parentId_ = 0;
+	double mapToSubmapOrigin_[16];
+	double mapToSubmapCenter_[3];
+	ArrayRecord points_, normals_, colors_, covariances_;
+};
+
+static_assert(std::is_trivially_copyable<Header>::value, "map file header has to be a POD");
+static_assert(std::is_trivially_copyable<SubmapRecord>::value, "map file submap record has to be a POD");
+static_assert(sizeof(Eigen::Vector3d) == 3 * sizeof(double), "Vector3d has to be tightly packed");
+static_assert(sizeof(Eigen::Matrix3d) == 9 * sizeof(double), "Matrix3d has to be tightly packed");
+
+uint64 align(uint64 offset) {
+	return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+template<typename T>
+ArrayRecord reserveArray(size_t count, uint64 *offset) {
+	ArrayRecord record;
+	record.offset_ = *offset;
+	record.count_ = count;
+	*offset = align(*offset + count * sizeof(T));
+	return record;
+}
+
+class AlignedWriter {
+public:
+	explicit AlignedWriter(std::ofstream *out) :
+			out_(out) {
+	}
+	void write(uint64 offset, const void *data, size_t numBytes) {
+		assert_ge<uint64>(offset, position_, "map file writer, offsets have to increase");
+		static const char zeros[kAlignment] = { 0 };
+		while (position_ < offset) {
+			const uint64 padding = std::min<uint64>(offset - position_, kAlignment);
+			out_->write(zeros, padding);
+			position_ += padding;
+		}
+		out_->write(reinterpret_cast<const char*>(data), numBytes);
+		position_ += numBytes;
+	}
+	template<typename T>
+	void writeArray(const ArrayRecord &record, const std::vector<T> &v) {
+		write(record.offset_, v.data(), v.size() * sizeof(T));
+	}
+private:
+	std::ofstream *out_;
+	uint64 position_ = 0;
+};
+
+template<typename T>
+bool makeSpan(const uint8 *data, size_t size, const ArrayRecord &record, ConstSpan<T> *span) {
+	const bool isInside = record.offset_ <= size && record.count_ <= (size - record.offset_) / sizeof(T);
+	if (!isInside || record.offset_ % alignof(T) != 0) {
+		return false;
+	}
+	const T *begin = reinterpret_cast<const T*>(data + record.offset_);
+	*span = ConstSpan<T>(begin, begin + record.count_);
+	return true;
+}
+
+template<typename T>
+void appendSpan(const ConstSpan<T> &span, std::vector<T> *v) {
+	v->insert(v->end(), span.begin(), span.end());
+}
+
+} // namespace
+
+bool writeMapFile(const std::string &filename, const MapFileContent &content) {
+	const size_t numSubmaps = content.submaps_.size();
+	Header header;
+	std::memcpy(header.magic_, kMagic, sizeof(kMagic));
+	header.submapRecordSize_ = sizeof(SubmapRecord);
+	header.numSubmaps_ = numSubmaps;
+
+	// lay out everything first, then write front to back
+	uint64 offset = align(sizeof(Header));
+	header.submapTableOffset_ = offset;
+	offset = align(offset + numSubmaps * sizeof(SubmapRecord));
+
+	std::vector<SubmapRecord> records(numSubmaps);
+	for (size_t i = 0; i < numSubmaps; ++i) {
+		const MapFileSubmap &submap = content.submaps_[i];
+		SubmapRecord &r = records[i];
+		r.id_ = submap.id_;
+		r.parentId_ = submap.parentId_;
+		Eigen::Map<Eigen::Matrix4d>(r.mapToSubmapOrigin_) = submap.mapToSubmapOrigin_.matrix();
+		Eigen::Map<Eigen::Vector3d>(r.mapToSubmapCenter_) = submap.mapToSubmapCenter_;
+		r.points_ = reserveArray<Eigen::Vector3d>(submap.map_.points_.size(), &offset);
+		r.normals_ = reserveArray<Eigen::Vector3d>(submap.map_.normals_.size(), &offset);
+		r.colors_ = reserveArray<Eigen::Vector3d>(submap.map_.colors_.size(), &offset);
+		r.covariances_ = reserveArray<Eigen::Matrix3d>(submap.map_.covariances_.size(), &offset);
+	}
+	header.fileSize_ = offset;
+
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "Cannot open " << filename << " for writing \n";
+		return false;
+	}
+	AlignedWriter writer(&out);
+	writer.write(0, &header, sizeof(Header));
+	writer.writeArray(ArrayRecord { header.submapTableOffset_, numSubmaps }, records);
+	for (size_t i = 0; i < numSubmaps; ++i) {
+		const MapFileSubmap &submap = content.submaps_[i];
+		const SubmapRecord &r = records[i];
+		writer.writeArray(r.points_, submap.map_.points_);
+		writer.writeArray(r.normals_, submap.map_.normals_);
+		writer.writeArray(r.colors_, submap.map_.colors_);
+		writer.writeArray(r.covariances_, submap.map_.covariances_);
+	}
+	// pad the last array so that the size matches the header
+	writer.write(header.fileSize_, nullptr, 0);
+	return static_cast<bool>(out);
+}
+
+MapFileView::~MapFileView() {
+	close();
+}
+
+bool MapFileView::open(const std::string &filename) {
+	close();
+	const int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Cannot open map file " << filename << "\n";
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+		::close(fd);
+		std::cerr << "Map file " << filename << " is too small \n";
+		return false;
+	}
+	void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Cannot map " << filename << " to memory \n";
+		return false;
+	}
+	data_ = static_cast<const uint8*>(mapped);
+	size_ = st.st_size;
+
+	Header header;
+	std::memcpy(&header, data_, sizeof(Header));
+	if (std::memcmp(header.magic_, kMagic, sizeof(kMagic)) != 0 || header.version_ != kVersion
+			|| header.submapRecordSize_ != sizeof(SubmapRecord) || header.fileSize_ != size_) {
+		std::cerr << "Map file " << filename << " is not a version " << kVersion << " map or it is truncated \n";
+		close();
+		return false;
+	}
+
+	ConstSpan<SubmapRecord> records;
+	bool isValid = makeSpan(data_, size_, ArrayRecord { header.submapTableOffset_, header.numSubmaps_ }, &records);
+	submaps_.resize(records.size());
+	for (size_t i = 0; i < records.size() && isValid; ++i) {
+		const SubmapRecord &r = records[i];
+		SubmapView &s = submaps_[i];
+		s.id_ = r.id_;
+		s.parentId_ = r.parentId_;
+		s.mapToSubmapOrigin_.matrix() = Eigen::Map<const Eigen::Matrix4d>(r.mapToSubmapOrigin_);
+		s.mapToSubmapCenter_ = Eigen::Map<const Eigen::Vector3d>(r.mapToSubmapCenter_);
+		isValid = makeSpan(data_, size_, r.points_, &s.points_) && makeSpan(data_, size_, r.normals_, &s.normals_)
+				&& makeSpan(data_, size_, r.colors_, &s.colors_)
+				&& makeSpan(data_, size_, r.covariances_, &s.covariances_);
+	}
+	if (!isValid) {
+		std::cerr << "Map file " << filename << " is corrupted \n";
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MapFileView::close() {
+	if (data_ != nullptr) {
+		munmap(const_cast<uint8*>(data_), size_);
+	}
+	data_ = nullptr;
+	size_ = 0;
+	submaps_.clear();
+}
+
+bool MapFileView::isOpen() const {
+	return data_ != nullptr;
+}
+
+size_t MapFileView::getNumSubmaps() const {
+	return submaps_.size();
+}
+
+const MapFileView::SubmapView& MapFileView::getSubmap(size_t idx) const {
+	return submaps_.at(idx);
+}
+
+PointCloud MapFileView::toPointCloud(size_t submapIdx) const {
+	const SubmapView &s = submaps_.at(submapIdx);
+	PointCloud cloud;
+	appendSpan(s.points_, &cloud.points_);
+	appendSpan(s.normals_, &cloud.normals_);
+	appendSpan(s.colors_, &cloud.colors_);
+	appendSpan(s.covariances_, &cloud.covariances_);
+	return cloud;
+}
+
+PointCloud MapFileView::toAssembledPointCloud() const {
+	size_t numPoints = 0;
+	bool isHasNormals = true, isHasColors = true, isHasCovariances = true;
+	for (const auto &s : submaps_) {
+		numPoints += s.points_.size();
+		isHasNormals = isHasNormals && s.normals_.size() == s.points_.size();
+		isHasColors = isHasColors && s.colors_.size() == s.points_.size();
+		isHasCovariances = isHasCovariances && s.covariances_.size() == s.points_.size();
+	}
+	PointCloud cloud;
+	cloud.points_.reserve(numPoints);
+	if (isHasNormals) {
+		cloud.normals_.reserve(numPoints);
+	}
+	if (isHasColors) {
+		cloud.colors_.reserve(numPoints);
+	}
+	if (isHasCovariances) {
+		cloud.covariances_.reserve(numPoints);
+	}
+	for (const auto &s : submaps_) {
+		appendSpan(s.points_, &cloud.points_);
+		if (isHasNormals) {
+			appendSpan(s.normals_, &cloud.normals_);
+		}
+		if (isHasColors) {
+			appendSpan(s.colors_, &cloud.colors_);
+		}
+		if (isHasCovariances) {
+			appendSpan(s.covariances_, &cloud.covariances_);
+		}
+	}
+	return cloud;
+}
+
+} // namespace o3d_slam
@@ -51,8 +51,14 @@ bool Mapper::hasProcessedMeasurements() const {
 	return !mapToRangeSensorBuffer_.empty();
 }
 
+void Mapper::setScanFeatureCache(std::shared_ptr<ScanFeatureCache> cache) {
+	scanFeatureCache_ = cache;
+	scan2MapReg_->setScanFeatureCache(cache);
+}
+
 void Mapper::update(const MapperParameters &p) {
 	scan2MapReg_ = scanToMapRegistrationFactory(p);
+	scan2MapReg_->setScanFeatureCache(scanFeatureCache_);
 	submaps_->setParameters(p);
 }
 
@@ -108,7 +114,7 @@ bool Mapper::addRangeMeasurement(const Mapper::PointCloud &rawScan, const Time &
 			assert_true(scan2MapReg_->isMergeScanValid(rawScan),"Init map invalid!!!!");
 			submaps_->insertScan(rawScan, rawScan, Transform::Identity(), timestamp);
 		} else {
-			const ProcessedScans processed = scan2MapReg_->processForScanMatchingAndMerging(rawScan, mapToRangeSensor_);
+			const ProcessedScans processed = scan2MapReg_->processForScanMatchingAndMerging(rawScan, mapToRangeSensor_, timestamp);
 			submaps_->insertScan(rawScan, *processed.merge_, Transform::Identity(), timestamp);
 			mapToRangeSensorBuffer_.push(timestamp, mapToRangeSensor_);
 		}
@@ -137,7 +143,7 @@ bool Mapper::addRangeMeasurement(const Mapper::PointCloud &rawScan, const Time &
 		mapToRangeSensorEstimate = mapToRangeSensorPrev_*odometryMotion ;
 	}
 	isIgnoreOdometryPrediction_ = false;
-	const ProcessedScans processed = scan2MapReg_->processForScanMatchingAndMerging(rawScan, mapToRangeSensor_);
+	const ProcessedScans processed = scan2MapReg_->processForScanMatchingAndMerging(rawScan, mapToRangeSensor_, timestamp);
 	const RegistrationResult result = scan2MapReg_->scanToMapRegistration(*processed.match_, submaps_->getActiveSubmap(),
 			mapToRangeSensor_, mapToRangeSensorEstimate);
 	preProcessedScan_ = *processed.match_;
@@ -182,27 +188,20 @@ bool Mapper::addRangeMeasurement(const Mapper::PointCloud &rawScan, const Time &
 }
 
 Mapper::PointCloud Mapper::getAssembledMapPointCloud() const {
+	// called from the visualization, hence only copies of the submaps are used
 	PointCloud cloud;
 	const int nPoints = submaps_->getTotalNumPoints();
-	const Submap &activeSubmap = getActiveSubmap();
 	cloud.points_.reserve(nPoints);
-	if (activeSubmap.getMapPointCloud().HasColors()) {
-		cloud.colors_.reserve(nPoints);
-	}
-	if (activeSubmap.getMapPointCloud().HasNormals()) {
-		cloud.normals_.reserve(nPoints);
-	}
-
 	for (size_t j = 0; j < submaps_->getNumSubmaps(); ++j) {
 		const PointCloud submap = submaps_->getSubmap(j).getMapPointCloudCopy();
-		for (size_t i = 0; i < submap.points_.size(); ++i) {
-			cloud.points_.push_back(submap.points_.at(i));
-			if (submap.HasColors()) {
-				cloud.colors_.push_back(submap.colors_.at(i));
-			}
-			if (submap.HasNormals()) {
-				cloud.normals_.push_back(submap.normals_.at(i));
-			}
+		cloud.points_.insert(cloud.points_.end(), submap.points_.begin(), submap.points_.end());
+		if (submap.HasColors()) {
+			cloud.colors_.reserve(nPoints);
+			cloud.colors_.insert(cloud.colors_.end(), submap.colors_.begin(), submap.colors_.end());
+		}
+		if (submap.HasNormals()) {
+			cloud.normals_.reserve(nPoints);
+			cloud.normals_.insert(cloud.normals_.end(), submap.normals_.begin(), submap.normals_.end());
 		}
 	}
 	return cloud;
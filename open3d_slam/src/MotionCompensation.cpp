@@ -9,7 +9,9 @@
 
 #include <open3d/geometry/PointCloud.h>
 #include <Eigen/Dense>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <memory>
 #include <iostream>
 #include "open3d_slam/Parameters.hpp"
@@ -17,12 +19,13 @@
 #include "open3d_slam/math.hpp"
 #include "open3d_slam/output.hpp"
 #include "open3d_slam/assert.hpp"
+#include "open3d_slam/magic.hpp"
 #include "open3d_slam/TransformInterpolationBuffer.hpp"
 
 namespace o3d_slam {
 
 std::shared_ptr<PointCloud> MotionCompensation::undistortInputPointCloud(
-		const PointCloud &input, const Time &timestamp) {
+		const PointCloud &input, const Time &timestamp, const std::vector<float> &pointTimeOffsets) {
 	std::shared_ptr<PointCloud> ret = std::make_shared<PointCloud>();
 	*ret = input;
 	return ret;
@@ -33,37 +36,54 @@ ConstantVelocityMotionCompensation::ConstantVelocityMotionCompensation(
 		buffer_(buffer){
 }
 
-void ConstantVelocityMotionCompensation::estimateLinearAndAngularVelocity(
-		const Time &timestamp, Eigen::Vector3d *linearVelocity,
-		Eigen::Vector3d *angularVelocity) const {
-
+bool ConstantVelocityMotionCompensation::estimateLatestMotion(Transform *motion, double *dt) const {
 	const int offset = params_.numPosesVelocityEstimation_;
 	if (buffer_.size() <= offset) {
-		linearVelocity->setZero();
-		angularVelocity->setZero();
-		return;
+		return false;
 	}
+	const auto finish = buffer_.latest_measurement();
+	const auto start = buffer_.latest_measurement(offset);
+	*motion = start.transform_.inverse() * finish.transform_;
+	*dt = toSeconds(finish.time_ - start.time_);
+	assert_gt(*dt, 0.0, "dt should be > 0!!!!");
+	return true;
+}
 
-	if (buffer_.latest_time() < timestamp) {
-
-		const auto finish = buffer_.latest_measurement();
-		const auto start = buffer_.latest_measurement(offset);
-
-		const Transform dT = start.transform_.inverse() * finish.transform_;
-		const double dt = toSeconds(finish.time_ - start.time_);
-		assert_gt(dt, 0.0, "dt should be > 0!!!!");
-//			std::cout << "dt " << dt << std::endl;
-		const Eigen::Vector3d linearVelocitySensor = dT.translation()
-				/ (dt + 1e-6);
-		const Eigen::Vector3d angularVelocitySensor = toRPY(
-				Eigen::Quaterniond(dT.rotation()).normalized()) / (dt + 1e-6);
-		*linearVelocity = linearVelocitySensor;
-		*angularVelocity = angularVelocitySensor;
-	} else {
-		// todo handle this case!!!!!
-		std::cout << "Warning buffer has this already!!!! \n";
+void ConstantVelocityMotionCompensation::buildMotionLookupTable(const Time &timestamp, double beginTime,
+		double endTime, MotionLookupTable *table) const {
+	const int numBins = endTime > beginTime ? magic::motionCompensationNumTimeBins : 1;
+	table->beginTime_ = beginTime;
+	table->binsPerSec_ = numBins > 1 ? (numBins - 1) / (endTime - beginTime) : 0.0;
+	table->rotations_.assign(numBins, Eigen::Matrix3d::Identity());
+	table->translations_.assign(numBins, Eigen::Vector3d::Zero());
+	const auto binTime = [&](int bin) {
+		return numBins > 1 ? beginTime + bin / table->binsPerSec_ : beginTime;
+	};
+
+	// interpolate if the buffer has the poses for the whole scan (e.g. odometry running ahead of the mapping)
+	if (buffer_.has(timestamp + fromSeconds(beginTime)) && buffer_.has(timestamp + fromSeconds(endTime))
+			&& buffer_.has(timestamp)) {
+		const Transform sensorAtTimestampInv = buffer_.lookup(timestamp).inverse();
+		for (int bin = 0; bin < numBins; ++bin) {
+			const Transform motion = sensorAtTimestampInv * buffer_.lookup(timestamp + fromSeconds(binTime(bin)));
+			table->rotations_[bin] = motion.rotation();
+			table->translations_[bin] = motion.translation();
+		}
+		return;
 	}
 
+	// otherwise extrapolate the latest motion with constant velocity
+	Transform latestMotion;
+	double dt = 0.0;
+	if (!estimateLatestMotion(&latestMotion, &dt)) {
+		return;
+	}
+	const Eigen::AngleAxisd rotation(latestMotion.rotation());
+	for (int bin = 0; bin < numBins; ++bin) {
+		const double scale = binTime(bin) / (dt + 1e-6);
+		table->rotations_[bin] = Eigen::AngleAxisd(scale * rotation.angle(), rotation.axis()).toRotationMatrix();
+		table->translations_[bin] = scale * latestMotion.translation();
+	}
 }
 
 void ConstantVelocityMotionCompensation::setParameters(const ConstantVelocityMotionCompensationParameters &p){
@@ -73,67 +93,69 @@ void ConstantVelocityMotionCompensation::setParameters(const ConstantVelocityMot
 
 
 std::shared_ptr<PointCloud> ConstantVelocityMotionCompensation::undistortInputPointCloud(
-		const PointCloud &input, const Time &timestamp) {
+		const PointCloud &input, const Time &timestamp, const std::vector<float> &pointTimeOffsets) {
 	auto output = std::make_shared<PointCloud>(input);
-	Eigen::Vector3d linearVelocity(0.0,0.0,0.0), angularVelocityRpy(0.0,0.0,0.0);
-	estimateLinearAndAngularVelocity(timestamp, &linearVelocity,
-			&angularVelocityRpy);
-//	std::cout << "lin vel: " << linearVelocity.transpose() << std::endl;
-//	std::cout << "ang vel: " << angularVelocityRpy.transpose() * 180.0 / M_PI
-//			<< "\n";
-
-//		std::cout << "dt (-0.0002,1): " << computePhase(-0.0002,1) << "\n";
-//		std::cout << "dt (0.0002,1): " << computePhase(0.0002,1) << "\n";
-//		std::cout << "dt (0,1): " << computePhase(0.0,1.0) << "\n";
-//		std::cout << "dt (1,0): " << computePhase(1,0) << "\n";
-//		std::cout << "dt (0,-1): " << computePhase(0,-1) << "\n";
-//		std::cout << "dt (-1,0): " << computePhase(-1,0) << "\n\n";
-//	double minPhase = 2.0;
-//	double maxPhase = -1.0;
-//	Transform minT, maxT;
-//	Eigen::Vector3d pMin, pMax;
-	for (int i = 0; i < input.points_.size(); ++i) {
-		const Eigen::Vector3d p = output->points_.at(i);
-		const double phase = computePhase(p.x(), p.y());
-		const Eigen::Vector3d xyz = phase * params_.scanDuration_ * linearVelocity;
-		const Eigen::Vector3d rpy = phase * params_.scanDuration_ * angularVelocityRpy;
-		const Transform motion = makeTransform(xyz, fromRPY(rpy).normalized());
-		const Transform point = makeTransform(p,
-				Eigen::Quaterniond::Identity());
-//		if (phase < minPhase) {
-//			minT = motion;
-//			minPhase = phase;
-//			pMin = p;
-//		}
-//		if (phase > maxPhase) {
-//			maxT = motion;
-//			maxPhase = phase;
-//			pMax = p;
-//		}
-		output->points_.at(i) = motion * p;
+	const int nPoints = input.points_.size();
+	if (nPoints == 0) {
+		return output;
 	}
 
-//	if (std::fabs(angularVelocityRpy.z()) > 160 * M_PI / 180.0) {
-//		const std::string folder =
-//				"/home/jelavice/catkin_workspaces/open3d_ws/src/open3d_slam/open3d_slam_ros/data";
-//		saveToFile(folder + "/input.pcd", input);
-//		saveToFile(folder + "/output.pcd", *output);
-//		std::cout << "saved \n";
-//	}
-
-//	std::cout << "min motion: \n" << asString(minT) << "\n";
-//	std::cout << "p min: " << pMin.transpose() << ", "
-//			<< (minT * pMin).transpose() << std::endl;
-//	std::cout << "max motion: \n" << asString(maxT) << "\n";
-//	std::cout << "p max: " << pMax.transpose() << ", "
-//			<< (maxT * pMax).transpose() << std::endl;
-//	std::cout << "\n\n";
-	return output;
+	const bool isHasPointTimes = pointTimeOffsets.size() == input.points_.size();
+	if (!isHasPointTimes && !pointTimeOffsets.empty()) {
+		std::cerr << "Number of point times does not match the number of points, using the azimuth instead! \n";
+	}
+	std::vector<float> azimuthTimes;
+	if (!isHasPointTimes) {
+		azimuthTimes.resize(nPoints);
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < nPoints; ++i) {
+			const Eigen::Vector3d &p = input.points_[i];
+			azimuthTimes[i] = computePhase(p.x(), p.y()) * params_.scanDuration_;
+		}
+	}
+	const std::vector<float> &times = isHasPointTimes ? pointTimeOffsets : azimuthTimes;
+
+	float beginTime = std::numeric_limits<float>::max();
+	float endTime = std::numeric_limits<float>::lowest();
+#pragma omp parallel for schedule(static) reduction(min:beginTime) reduction(max:endTime)
+	for (int i = 0; i < nPoints; ++i) {
+		if (std::isfinite(times[i])) {
+			beginTime = std::min(beginTime, times[i]);
+			endTime = std::max(endTime, times[i]);
+		}
+	}
+	if (beginTime > endTime) {
+		// none of the times is finite, nothing to compensate
+		return output;
+	}
 
+	MotionLookupTable table;
+	buildMotionLookupTable(timestamp, beginTime, endTime, &table);
+
+	const int lastBin = table.rotations_.size() - 1;
+	const bool isHasNormals = input.HasNormals();
+	const bool isHasCovariances = input.HasCovariances();
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < nPoints; ++i) {
+		if (!std::isfinite(times[i])) {
+			// the output is a copy of the input, such a point stays where it is
+			continue;
+		}
+		const int bin = std::min(lastBin, static_cast<int>((times[i] - table.beginTime_) * table.binsPerSec_ + 0.5));
+		const Eigen::Matrix3d &R = table.rotations_[bin];
+		output->points_[i] = R * input.points_[i] + table.translations_[bin];
+		if (isHasNormals) {
+			output->normals_[i] = R * input.normals_[i];
+		}
+		if (isHasCovariances) {
+			output->covariances_[i] = R * input.covariances_[i] * R.transpose();
+		}
+	}
+	return output;
 }
 
-double ConstantVelocityMotionCompensation::computePhase(double x, double y) {
-	//this is now robosense specific
+double ConstantVelocityMotionCompensation::computePhase(double x, double y) const {
+	// only used if the sensor does not give point times, assumes that the scan starts at azimuth 0
 	const double angle = std::atan2(y, x);
 	const double angleWrapped = angle < 0.0 ? (angle + 2.0 * M_PI) : angle;
 	if (angleWrapped == 0.0) {
@@ -0,0 +1,288 @@
+/*
+ * OccupancyVoxelMap.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/OccupancyVoxelMap.hpp"
+
+#include <open3d/geometry/PointCloud.h>
+#include <algorithm>
+
+#ifdef open3d_slam_OPENMP_FOUND
+#include <omp.h>
+#endif
+
+namespace o3d_slam {
+
+namespace {
+bool isKeyLess(const Eigen::Vector3i &a, const Eigen::Vector3i &b) {
+	if (a.x() != b.x()) {
+		return a.x() < b.x();
+	}
+	if (a.y() != b.y()) {
+		return a.y() < b.y();
+	}
+	return a.z() < b.z();
+}
+
+int floorDiv(int a, int b) {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+void mergeInto(const AggregatedVoxel &voxel, AggregatedVoxel *target) {
+	target->numAggregatedPoints_ += voxel.numAggregatedPoints_;
+	target->aggregatedPosition_ += voxel.aggregatedPosition_;
+	target->aggregatedNormal_ += voxel.aggregatedNormal_;
+	target->aggregatedColor_ += voxel.aggregatedColor_;
+	target->logOdds_ = std::max(target->logOdds_, voxel.logOdds_);
+}
+} // namespace
+
+OccupancyVoxelMap::OccupancyVoxelMap() :
+		OccupancyVoxelMap(Eigen::Vector3d::Constant(0.25)) {
+}
+
+OccupancyVoxelMap::OccupancyVoxelMap(const Eigen::Vector3d &voxelSize) :
+		voxelSize_(voxelSize), inverseVoxelSize_(fromVoxelSize(voxelSize)), shards_(kNumShards,
+				VoxelizedPointCloud(voxelSize)) {
+}
+
+int OccupancyVoxelMap::getShardIdx(const Eigen::Vector3i &voxelKey) const {
+	const Eigen::Vector3i blockKey(floorDiv(voxelKey.x(), kBlockSize), floorDiv(voxelKey.y(), kBlockSize),
+			floorDiv(voxelKey.z(), kBlockSize));
+	return static_cast<int>(EigenVec3iHash()(blockKey) & (kNumShards - 1));
+}
+
+void OccupancyVoxelMap::integrate(const PointCloud &scan, const Eigen::Vector3d &sensorPosition,
+		const SpaceCarvingParameters &params, bool isClearFreeSpace) {
+	if (scan.IsEmpty()) {
+		return;
+	}
+	isHasNormals_ = isHasNormals_ || scan.HasNormals();
+	isHasColors_ = isHasColors_ || scan.HasColors();
+
+	// updates binned by thread and then by shard, no two threads ever write to the same vector
+#ifdef open3d_slam_OPENMP_FOUND
+	const int numThreads = omp_get_max_threads();
+#else
+	const int numThreads = 1;
+#endif
+	std::vector<std::vector<std::vector<Hit>>> hits(numThreads, std::vector<std::vector<Hit>>(kNumShards));
+	std::vector<std::vector<std::vector<Eigen::Vector3i>>> misses(numThreads,
+			std::vector<std::vector<Eigen::Vector3i>>(kNumShards));
+	const int nPoints = scan.points_.size();
+#pragma omp parallel num_threads(numThreads)
+	{
+#ifdef open3d_slam_OPENMP_FOUND
+		const int threadIdx = omp_get_thread_num();
+#else
+		const int threadIdx = 0;
+#endif
+		auto &threadHits = hits[threadIdx];
+		auto &threadMisses = misses[threadIdx];
+		const auto addMissIfExists = [&](const Eigen::Vector3i &key) {
+			const int shardIdx = getShardIdx(key);
+			if (shards_[shardIdx].hasVoxelWithKey(key)) {
+				threadMisses[shardIdx].push_back(key);
+			}
+		};
+#pragma omp for schedule(static)
+		for (int i = 0; i < nPoints; ++i) {
+			const Eigen::Vector3d &p = scan.points_[i];
+			const Eigen::Vector3i key = getVoxelIdx(p, inverseVoxelSize_);
+			threadHits[getShardIdx(key)].push_back( { key, static_cast<size_t>(i) });
+			if (!isClearFreeSpace) {
+				continue;
+			}
+			// stop short of the surface, otherwise rays at grazing angles clear it
+			const Eigen::Vector3d ray = p - sensorPosition;
+			const double length = ray.norm();
+			const double clearedLength = std::min(length - params.truncationDistance_, params.maxRaytracingLength_);
+			if (clearedLength <= 0.0) {
+				continue;
+			}
+			traverseVoxelsAlongRay(sensorPosition, sensorPosition + ray * (clearedLength / length), voxelSize_,
+					inverseVoxelSize_, addMissIfExists);
+		}
+	}
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int shardIdx = 0; shardIdx < kNumShards; ++shardIdx) {
+		applyUpdates(shardIdx, scan, params, hits, misses);
+	}
+}
+
+void OccupancyVoxelMap::applyUpdates(int shardIdx, const PointCloud &scan, const SpaceCarvingParameters &params,
+		const std::vector<std::vector<std::vector<Hit>>> &hits,
+		const std::vector<std::vector<std::vector<Eigen::Vector3i>>> &misses) {
+	std::vector<Hit> shardHits;
+	std::vector<Eigen::Vector3i> shardMisses;
+	for (size_t t = 0; t < hits.size(); ++t) {
+		shardHits.insert(shardHits.end(), hits[t][shardIdx].begin(), hits[t][shardIdx].end());
+		shardMisses.insert(shardMisses.end(), misses[t][shardIdx].begin(), misses[t][shardIdx].end());
+	}
+	std::sort(shardHits.begin(), shardHits.end(), [](const Hit &a, const Hit &b) {
+		return isKeyLess(a.key_, b.key_);
+	});
+	std::sort(shardMisses.begin(), shardMisses.end(), isKeyLess);
+	shardMisses.erase(std::unique(shardMisses.begin(), shardMisses.end()), shardMisses.end());
+
+	VoxelizedPointCloud &shard = shards_[shardIdx];
+	shard.isHasNormals_ = isHasNormals_;
+	shard.isHasColors_ = isHasColors_;
+	const bool isScanHasNormals = scan.HasNormals();
+	const bool isScanHasColors = scan.HasColors();
+	for (size_t begin = 0; begin < shardHits.size();) {
+		const Eigen::Vector3i &key = shardHits[begin].key_;
+		auto search = shard.voxels_.find(key);
+		if (search == shard.voxels_.end()) {
+			search = shard.voxels_.insert( { key, AggregatedVoxel() }).first;
+		}
+		AggregatedVoxel &voxel = search->second;
+		size_t end = begin;
+		for (; end < shardHits.size() && shardHits[end].key_ == key; ++end) {
+			const size_t idx = shardHits[end].pointIdx_;
+			voxel.aggregatePoint(scan.points_[idx]);
+			if (isScanHasNormals) {
+				voxel.aggregateNormal(scan.normals_[idx]);
+			}
+			if (isScanHasColors) {
+				voxel.aggregateColor(scan.colors_[idx]);
+			}
+		}
+		voxel.logOdds_ = std::min<float>(voxel.logOdds_ + params.hitLogOdds_, params.maxLogOdds_);
+		begin = end;
+	}
+
+	// a voxel with a point in this scan is occupied, even if some other ray passed through it
+	size_t hitIdx = 0;
+	for (const auto &key : shardMisses) {
+		while (hitIdx < shardHits.size() && isKeyLess(shardHits[hitIdx].key_, key)) {
+			++hitIdx;
+		}
+		if (hitIdx < shardHits.size() && shardHits[hitIdx].key_ == key) {
+			continue;
+		}
+		auto search = shard.voxels_.find(key);
+		if (search == shard.voxels_.end()) {
+			continue;
+		}
+		search->second.logOdds_ += params.missLogOdds_;
+		if (search->second.logOdds_ < 0.0f) {
+			shard.removeKey(key);
+		}
+	}
+}
+
+PointCloud OccupancyVoxelMap::toPointCloud() const {
+	std::vector<size_t> offsets(kNumShards + 1, 0);
+	for (int i = 0; i < kNumShards; ++i) {
+		offsets[i + 1] = offsets[i] + shards_[i].size();
+	}
+	PointCloud ret;
+	ret.points_.resize(offsets.back());
+	if (isHasNormals_) {
+		ret.normals_.resize(offsets.back());
+	}
+	if (isHasColors_) {
+		ret.colors_.resize(offsets.back());
+	}
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < kNumShards; ++i) {
+		size_t idx = offsets[i];
+		for (const auto &voxel : shards_[i].voxels_) {
+			ret.points_[idx] = voxel.second.getAggregatedPosition();
+			if (isHasNormals_) {
+				ret.normals_[idx] = voxel.second.getAggregatedNormal();
+			}
+			if (isHasColors_) {
+				ret.colors_[idx] = voxel.second.getAggregatedColor();
+			}
+			++idx;
+		}
+	}
+	return ret;
+}
+
+void OccupancyVoxelMap::transform(const Transform &T) {
+	if (empty()) {
+		return;
+	}
+	// voxels get new keys and can end up in another shard, hence first bin them by the destination shard
+	using KeyVoxel = std::pair<Eigen::Vector3i, AggregatedVoxel>;
+	std::vector<std::vector<std::vector<KeyVoxel>>> moved(kNumShards, std::vector<std::vector<KeyVoxel>>(kNumShards));
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < kNumShards; ++i) {
+		for (const auto &v : shards_[i].voxels_) {
+			AggregatedVoxel voxel = v.second;
+			voxel.aggregatedPosition_ = T.linear() * voxel.aggregatedPosition_
+					+ voxel.numAggregatedPoints_ * T.translation();
+			voxel.aggregatedNormal_ = T.linear() * voxel.aggregatedNormal_;
+			const Eigen::Vector3i key = getVoxelIdx(voxel.getAggregatedPosition(), inverseVoxelSize_);
+			moved[i][getShardIdx(key)].emplace_back(key, voxel);
+		}
+	}
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int j = 0; j < kNumShards; ++j) {
+		VoxelizedPointCloud &shard = shards_[j];
+		shard.clear();
+		for (int i = 0; i < kNumShards; ++i) {
+			for (const auto &kv : moved[i][j]) {
+				auto search = shard.voxels_.find(kv.first);
+				if (search == shard.voxels_.end()) {
+					shard.voxels_.insert(kv);
+				} else {
+					mergeInto(kv.second, &search->second);
+				}
+			}
+		}
+	}
+}
+
+size_t OccupancyVoxelMap::size() const {
+	size_t n = 0;
+	for (const auto &shard : shards_) {
+		n += shard.size();
+	}
+	return n;
+}
+
+bool OccupancyVoxelMap::empty() const {
+	return size() == 0;
+}
+
+void OccupancyVoxelMap::clear() {
+	for (auto &shard : shards_) {
+		shard.clear();
+	}
+}
+
+Eigen::Vector3d OccupancyVoxelMap::getVoxelSize() const {
+	return voxelSize_;
+}
+
+bool OccupancyVoxelMap::hasNormals() const {
+	return isHasNormals_;
+}
+
+bool OccupancyVoxelMap::hasColors() const {
+	return isHasColors_;
+}
+
+const std::vector<VoxelizedPointCloud>& OccupancyVoxelMap::getShards() const {
+	return shards_;
+}
+
+void OccupancyVoxelMap::setShards(std::vector<VoxelizedPointCloud> &&shards) {
+	shards_ = std::move(shards);
+	isHasNormals_ = std::any_of(shards_.begin(), shards_.end(), [](const VoxelizedPointCloud &s) {
+		return s.hasNormals();
+	});
+	isHasColors_ = std::any_of(shards_.begin(), shards_.end(), [](const VoxelizedPointCloud &s) {
+		return s.hasColors();
+	});
+}
+
+} // namespace o3d_slam
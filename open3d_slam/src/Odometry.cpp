@@ -12,6 +12,7 @@
 #include "open3d_slam/time.hpp"
 #include "open3d_slam/output.hpp"
 #include "open3d_slam/CloudRegistration.hpp"
+#include "open3d_slam/ScanFeatureCache.hpp"
 
 #include <iostream>
 
@@ -22,16 +23,30 @@ LidarOdometry::LidarOdometry() {
 	cloudRegistration_ = cloudRegistrationFactory(params_.scanMatcher_);
 }
 
-PointCloudPtr LidarOdometry::preprocess(const PointCloud &in) const{
-	auto croppedCloud = cropper_->crop(in);
-	o3d_slam::voxelize(params_.scanProcessing_.voxelSize_, croppedCloud.get());
-	cloudRegistration_->estimateNormalsOrCovariancesIfNeeded(croppedCloud.get());
-	return croppedCloud->RandomDownSample(params_.scanProcessing_.downSamplingRatio_);
+PointCloudPtr LidarOdometry::preprocess(const PointCloud &in, const Time &timestamp) const{
+	auto croppedCloud = cropAndVoxelize(*cropper_, params_.scanProcessing_.voxelSize_, in);
+	// normals see the whole voxelized scan, the downsampling comes after. Scans that come from a
+	// range image have them already
+	if (!in.HasNormals()) {
+		cloudRegistration_->estimateNormalsOrCovariancesIfNeeded(croppedCloud.get());
+	}
+	ScanFeatureCache::Entry entry;
+	if (scanFeatureCache_ != nullptr && croppedCloud->HasNormals()
+			&& cloudRegistration_->getNormalEstimationParameters(&entry.knn_, &entry.maxRadius_)) {
+		auto cached = std::make_shared<PointCloud>();
+		cached->points_ = croppedCloud->points_;
+		cached->normals_ = croppedCloud->normals_;
+		entry.cloud_ = cached;
+		entry.voxelSize_ = params_.scanProcessing_.voxelSize_;
+		scanFeatureCache_->insert(timestamp, entry);
+	}
+	randomDownSample(params_.scanProcessing_.downSamplingRatio_, croppedCloud.get());
+	return croppedCloud;
 }
 
 bool LidarOdometry::addRangeScan(const open3d::geometry::PointCloud &cloud, const Time &timestamp) {
 	if (cloudPrev_.IsEmpty()) {
-		auto preProcessed = preprocess(cloud);
+		auto preProcessed = preprocess(cloud, timestamp);
 		cloudPrev_ = *preProcessed;
 		odomToRangeSensorBuffer_.push(timestamp, odomToRangeSensorCumulative_);
 		lastMeasurementTimestamp_ = timestamp;
@@ -44,7 +59,7 @@ bool LidarOdometry::addRangeScan(const open3d::geometry::PointCloud &cloud, cons
 	}
 
 	const o3d_slam::Timer timer;
-	auto preProcessed = preprocess(cloud);
+	auto preProcessed = preprocess(cloud, timestamp);
 	const auto result = cloudRegistration_->registerClouds(cloudPrev_,*preProcessed, Transform::Identity());
 
 	//todo magic
@@ -100,6 +115,10 @@ void LidarOdometry::setParameters(const OdometryParameters &p) {
 }
 
 
+void LidarOdometry::setScanFeatureCache(std::shared_ptr<ScanFeatureCache> cache) {
+	scanFeatureCache_ = cache;
+}
+
 void LidarOdometry::setInitialTransform(const Eigen::Matrix4d &initialTransform) {
 	//todo decide what to do
 	// if I uncomment stuff below the odom jumps but starts from the pose you specified
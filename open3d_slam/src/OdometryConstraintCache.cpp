@@ -0,0 +1,72 @@
+/*
+ * OdometryConstraintCache.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/OdometryConstraintCache.hpp"
+
+#include <algorithm>
+
+namespace o3d_slam {
+
+uint64 OdometryConstraintCache::toKey(size_t sourceIdx, size_t targetIdx) {
+	return (static_cast<uint64>(sourceIdx) << 32) | static_cast<uint64>(static_cast<uint32>(targetIdx));
+}
+
+bool OdometryConstraintCache::hasConstraint(size_t sourceIdx, size_t targetIdx) const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	return entryIdxs_.count(toKey(sourceIdx, targetIdx)) > 0;
+}
+
+bool OdometryConstraintCache::isUpToDate(size_t sourceIdx, size_t targetIdx, const Revisions &revisions) const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	const auto search = entryIdxs_.find(toKey(sourceIdx, targetIdx));
+	if (search == entryIdxs_.end()) {
+		return false;
+	}
+	const Revisions &stored = entries_[search->second].revisions_;
+	return stored.source_ == revisions.source_ && stored.target_ == revisions.target_;
+}
+
+void OdometryConstraintCache::insert(const Constraint &c, const Revisions &revisions) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	const uint64 key = toKey(c.sourceSubmapIdx_, c.targetSubmapIdx_);
+	const auto search = entryIdxs_.find(key);
+	if (search != entryIdxs_.end()) {
+		entries_[search->second] = Entry { c, revisions };
+		return;
+	}
+	entryIdxs_.emplace(key, entries_.size());
+	entries_.push_back(Entry { c, revisions });
+}
+
+Constraints OdometryConstraintCache::getConstraints() const {
+	Constraints constraints;
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		constraints.reserve(entries_.size());
+		for (const auto &entry : entries_) {
+			constraints.push_back(entry.constraint_);
+		}
+	}
+	std::sort(constraints.begin(), constraints.end(), [](const Constraint &c1, const Constraint &c2) {
+		return c1.targetSubmapIdx_ < c2.targetSubmapIdx_
+				|| (c1.targetSubmapIdx_ == c2.targetSubmapIdx_ && c1.sourceSubmapIdx_ < c2.sourceSubmapIdx_);
+	});
+	return constraints;
+}
+
+size_t OdometryConstraintCache::size() const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	return entries_.size();
+}
+
+void OdometryConstraintCache::clear() {
+	std::lock_guard<std::mutex> lck(mutex_);
+	entries_.clear();
+	entryIdxs_.clear();
+}
+
+} // namespace o3d_slam
@@ -11,6 +11,7 @@
 #include "open3d_slam/helpers.hpp"
 #include "open3d_slam/output.hpp"
 #include "open3d_slam/SubmapCollection.hpp"
+#include "open3d_slam/pose_graph_optimization.hpp"
 #include <open3d/pipelines/registration/GlobalOptimization.h>
 #include <open3d/io/PoseGraphIO.h>
 
@@ -37,7 +38,12 @@ void OptimizationProblem::solve() {
 	option.edge_prune_threshold_ = p.edgePruneThreshold_;
 	option.preference_loop_closure_ = p.loopClosurePreference_;
 	poseGraphNonOptimized_ = poseGraph_;
-	GlobalOptimization(poseGraph_, method, criteria, option);
+	if (p.isUseSparseSolver_) {
+		// nodes still hold the previous solution, only the new ones are initialized from odometry
+		sparseGlobalOptimization(criteria, option, &poseGraph_);
+	} else {
+		GlobalOptimization(poseGraph_, method, criteria, option);
+	}
 	poseGraphOptimized_ = poseGraph_;
 	isRunningOptimization_ = false;
 	std::cout << "Finished graph optimization\n";
@@ -21,6 +21,9 @@
 #include <open3d/io/PointCloudIO.h>
 #include "open3d_slam/helpers.hpp"
 
+#include <map>
+#include <sstream>
+
 #ifdef open3d_slam_OPENMP_FOUND
 #include <omp.h>
 #endif
@@ -47,142 +50,196 @@ void PlaceRecognition::updateRegistrationAlgorithm(const MapperParameters &p){
 	cloudRegistration = cloudRegistrationFactory(toCloudRegistrationType(params_.scanMatcher_));
 }
 
+struct PlaceRecognition::SourceSubmapData {
+	PointCloud sparse_;
+	PointCloud map_;
+	Submap::Feature feature_;
+	bool isHasFeatures_ = false;
+};
+
 Constraints PlaceRecognition::buildLoopClosureConstraints(const Transform &mapToRangeSensor,
 		const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
 		size_t activeSubmapIdx, const Time &timestamp) const {
+	const LoopClosureCandidates candidates = getLoopClosureCandidates(mapToRangeSensor, submapCollection, adjMatrix,
+			lastFinishedSubmapIdx, activeSubmapIdx, timestamp);
+	return buildLoopClosureConstraints(candidates, submapCollection);
+}
 
-	using namespace open3d::pipelines::registration;
-	Constraints constraints;
-	const PlaceRecognitionParameters &cfg = params_.placeRecognition_;
-	const auto edgeLengthChecker = CorrespondenceCheckerBasedOnEdgeLength(cfg.correspondenceCheckerEdgeLength_);
-	const auto distanceChecker = CorrespondenceCheckerBasedOnDistance(cfg.correspondenceCheckerDistance_);
-	const Submap &sourceSubmap = submapCollection.getSubmap(lastFinishedSubmapIdx);
-	const std::vector<size_t> closeSubmapsIdxs = std::move(
-			getLoopClosureCandidatesIdxs(mapToRangeSensor, submapCollection, adjMatrix, lastFinishedSubmapIdx,
-					activeSubmapIdx));
+LoopClosureCandidates PlaceRecognition::getLoopClosureCandidates(const Transform &mapToRangeSensor,
+		const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
+		size_t activeSubmapIdx, const Time &timestamp) const {
+	const std::vector<size_t> closeSubmapsIdxs = getLoopClosureCandidatesIdxs(mapToRangeSensor, submapCollection,
+			adjMatrix, lastFinishedSubmapIdx, activeSubmapIdx);
 	std::cout << "considering submap " << lastFinishedSubmapIdx << " for loop closure, num candidate submaps: "
 			<< closeSubmapsIdxs.size() << std::endl;
-	using namespace open3d::pipelines::registration;
-	if (closeSubmapsIdxs.empty()) {
+	LoopClosureCandidates candidates;
+	candidates.reserve(closeSubmapsIdxs.size());
+	for (const size_t id : closeSubmapsIdxs) {
+		LoopClosureCandidate c;
+		c.sourceSubmapIdx_ = lastFinishedSubmapIdx;
+		c.targetSubmapIdx_ = id;
+		c.timestamp_ = timestamp;
+		candidates.push_back(c);
+	}
+	return candidates;
+}
+
+Constraints PlaceRecognition::buildLoopClosureConstraints(const LoopClosureCandidates &candidates,
+		const SubmapCollection &submapCollection) const {
+	Constraints constraints;
+	if (candidates.empty()) {
 		return constraints;
 	}
-	const PointCloud sourceSparse = sourceSubmap.getSparseMapPointCloud();
-	const PointCloud source = sourceSubmap.getMapPointCloudCopy();
-	const Submap::Feature sourceFeature = sourceSubmap.getFeatures();
-//#pragma omp parallel for
-	for (int i = 0; i < closeSubmapsIdxs.size(); ++i) {
-		const int id = closeSubmapsIdxs.at(i);
-		const std::string matchingSubmapsString = " submap: " + std::to_string(lastFinishedSubmapIdx) + " with submap " + std::to_string(id);
-
-		const Submap &targetSubmap = submapCollection.getSubmap(id);
-		const PointCloud targetSparse = targetSubmap.getSparseMapPointCloud();
-		const Submap::Feature targetFeature = targetSubmap.getFeatures();
-		RegistrationResult ransacResult;
-		{
-			Timer t("ransac matching");
-			ransacResult = RegistrationRANSACBasedOnFeatureMatching(sourceSparse, targetSparse, sourceFeature,
-					targetFeature, true, cfg.ransacMaxCorrespondenceDistance_,
-					TransformationEstimationPointToPoint(false), cfg.ransacModelSize_, { distanceChecker,
-							edgeLengthChecker }, RANSACConvergenceCriteria(cfg.ransacNumIter_, cfg.ransacProbability_));
-		}
-		if (ransacResult.correspondence_set_.size() < cfg.ransacMinCorrespondenceSetSize_) {
-			std::cout << "REJECTED loop closure, " << ransacResult.correspondence_set_.size()
-					<< " correspondences. " << matchingSubmapsString << "\n";
-			continue;
-		}
 
-		if (!isRegistrationConsistent(ransacResult.transformation_)) {
-			std::cout << "REJECTED loop closure, with ransac inconsistant " << matchingSubmapsString << "\n";
+	// the source submap is shared among its candidates, copy its data only once
+	std::map<size_t, SourceSubmapData> sources;
+	for (const auto &candidate : candidates) {
+		if (sources.count(candidate.sourceSubmapIdx_) > 0) {
 			continue;
 		}
-
-		const PointCloud target = targetSubmap.getMapPointCloudCopy();
-		const double mapVoxelSize = getMapVoxelSize(params_.mapBuilder_,
-				magic::voxelSizeCorrespondenceSearchIfMapVoxelSizeIsZero);
-
-		const double voxelSizeForOverlap = magic::voxelExpansionFactorOverlapComputation * mapVoxelSize;
-		const size_t minNumPointsPerVoxel = 1;
-		std::vector<size_t> sourceIdxs, targetIdxs;
-		computeIndicesOfOverlappingPoints(source, target, Transform(ransacResult.transformation_),
-				voxelSizeForOverlap, minNumPointsPerVoxel, &sourceIdxs, &targetIdxs);
-		const PointCloud sourceOverlap = *source.SelectByIndex(sourceIdxs);
-		const PointCloud targetOverlap = *target.SelectByIndex(targetIdxs);
-
-//		const auto &sourceOverlap = source;
-//		const auto &targetOverlap = target;
-
-		const auto icpResult = cloudRegistration->registerClouds(sourceOverlap, targetOverlap,Transform(ransacResult.transformation_));
-//		printf("submap %ld size: %ld \n", id, source.points_.size());
-//			printf("submap %ld overlap size: %ld \n", id, source.points_.size());
-//			printf("submap %ld size: %ld \n", lastFinishedSubmapIdx, target.points_.size());
-//			printf("submap %ld overlap size: %ld \n", lastFinishedSubmapIdx, target.points_.size());
-
-		const auto &cfg = params_.placeRecognition_;
-		if (icpResult.fitness_ < cfg.minRefinementFitness_) {
-			std::cout << "REJECTED loop closure, refinement score: " << icpResult.fitness_ << ", " << matchingSubmapsString << "\n";;
-			continue;
+		const Submap &sourceSubmap = submapCollection.getSubmap(candidate.sourceSubmapIdx_);
+		SourceSubmapData &source = sources[candidate.sourceSubmapIdx_];
+		source.isHasFeatures_ = sourceSubmap.getSparseMapAndFeaturesCopy(&source.sparse_, &source.feature_);
+		if (source.isHasFeatures_) {
+			source.map_ = sourceSubmap.getMapPointCloudCopy();
 		}
+	}
 
-		if (!isRegistrationConsistent(icpResult.transformation_)) {
-			std::cout << "REJECTED loop closure, icp reg inconsistent, " << matchingSubmapsString << "\n";;
-			continue;
-		}
+	const int nCandidates = candidates.size();
+	Constraints results(nCandidates);
+	std::vector<uint8> isAccepted(nCandidates, 0);
+	std::vector<std::ostringstream> logs(nCandidates);
+#pragma omp parallel for schedule(dynamic, 1) if (nCandidates > 1)
+	for (int i = 0; i < nCandidates; ++i) {
+		const auto &candidate = candidates[i];
+		isAccepted[i] = buildLoopClosureConstraint(candidate, sources.at(candidate.sourceSubmapIdx_), submapCollection,
+				&results[i], &logs[i]);
+	}
 
-//#pragma omp critical
-		{
-			std::cout << "source features num: " << sourceSubmap.getFeatures().Num() << "\n";
-			std::cout << "target features num: " << sourceSubmap.getFeatures().Num() << "\n";
-			std::cout << "registered num correspondences: " << ransacResult.correspondence_set_.size() << std::endl;
-			std::cout << "registered with fitness: " << ransacResult.fitness_ << std::endl;
-			std::cout << "registered with rmse: " << ransacResult.inlier_rmse_ << std::endl;
-			std::cout << "registered with transformation: \n" << asString(Transform(ransacResult.transformation_))
-					<< std::endl;
-
-			std::cout << "refined with fitness: " << icpResult.fitness_ << std::endl;
-			std::cout << "refined with rmse: " << icpResult.inlier_rmse_ << std::endl;
-			std::cout << "refined with transformation: \n" << asString(Transform(icpResult.transformation_))
-					<< std::endl;
+	// collect in the order of the candidates, so the result does not depend on the scheduling
+	for (int i = 0; i < nCandidates; ++i) {
+		std::cout << logs[i].str();
+		if (isAccepted[i]) {
+			constraints.emplace_back(std::move(results[i]));
 		}
+	}
+	return constraints;
+}
 
-		Constraint c;
-		c.sourceToTarget_ = Transform(icpResult.transformation_);
-		c.sourceSubmapIdx_ = lastFinishedSubmapIdx;
-		c.targetSubmapIdx_ = id;
-		c.informationMatrix_ = open3d::pipelines::registration::GetInformationMatrixFromPointClouds(sourceOverlap,
-				targetOverlap, cfg.maxIcpCorrespondenceDistance_, icpResult.transformation_);
-		c.isInformationMatrixValid_ = true;
-		c.isOdometryConstraint_ = false;
-		c.timestamp_ = timestamp;
-//#pragma omp critical
-		{
-			constraints.emplace_back(std::move(c));
-		}
-		assert_eq<int>(lastFinishedSubmapIdx,sourceSubmap.getId(), "oops source submap");
-		assert_eq<int>(id,targetSubmap.getId(), "oops target submap");
-
-		if (params_.placeRecognition_.isDumpPlaceRecognitionAlignmentsToFile_) {
-			std::string lcName = std::to_string(recognitionCounter_) + "_"+ std::to_string(sourceSubmap.getId())+"_"+std::to_string(targetSubmap.getId());
-			PointCloud sourceOverlapCopy = sourceOverlap;
-			PointCloud sourceCopy = source;
-			sourceCopy.Transform(icpResult.transformation_);
-			sourceOverlapCopy.Transform(icpResult.transformation_);
-			saveToFile(folderPath_ + "/overlap_source_" + lcName, sourceOverlapCopy);
-			saveToFile(folderPath_ + "/full_source_" + lcName, sourceCopy);
-			saveToFile(folderPath_ + "/full_target_" + lcName, target);
-			saveToFile(folderPath_ + "/overlap_target_" + lcName, targetOverlap);
-//			std::cout << "Dumped place recognition to file \n";
-		}
-		std::cout << "ACCEPTED loop closure: " << matchingSubmapsString <<", " << asStringXYZRPY(c.sourceToTarget_) << "\n";;
+bool PlaceRecognition::buildLoopClosureConstraint(const LoopClosureCandidate &candidate,
+		const SourceSubmapData &source, const SubmapCollection &submapCollection, Constraint *constraint,
+		std::ostream *log) const {
 
-	} // end for loop
-	return constraints;
+	using namespace open3d::pipelines::registration;
+	const PlaceRecognitionParameters &cfg = params_.placeRecognition_;
+	const auto edgeLengthChecker = CorrespondenceCheckerBasedOnEdgeLength(cfg.correspondenceCheckerEdgeLength_);
+	const auto distanceChecker = CorrespondenceCheckerBasedOnDistance(cfg.correspondenceCheckerDistance_);
+	const size_t lastFinishedSubmapIdx = candidate.sourceSubmapIdx_;
+	const size_t id = candidate.targetSubmapIdx_;
+	const std::string matchingSubmapsString = " submap: " + std::to_string(lastFinishedSubmapIdx) + " with submap " + std::to_string(id);
+
+	if (!source.isHasFeatures_) {
+		*log << "REJECTED loop closure, no source features yet. " << matchingSubmapsString << "\n";
+		return false;
+	}
+	const Submap &sourceSubmap = submapCollection.getSubmap(lastFinishedSubmapIdx);
+	const Submap &targetSubmap = submapCollection.getSubmap(id);
+	// copies, the mapping thread might be moving the points of the target submap meanwhile
+	PointCloud targetSparse;
+	Submap::Feature targetFeature;
+	if (!targetSubmap.getSparseMapAndFeaturesCopy(&targetSparse, &targetFeature)) {
+		*log << "REJECTED loop closure, no target features yet. " << matchingSubmapsString << "\n";
+		return false;
+	}
+	RegistrationResult ransacResult;
+	{
+		Timer t("ransac matching");
+		ransacResult = RegistrationRANSACBasedOnFeatureMatching(source.sparse_, targetSparse, source.feature_,
+				targetFeature, true, cfg.ransacMaxCorrespondenceDistance_,
+				TransformationEstimationPointToPoint(false), cfg.ransacModelSize_, { distanceChecker,
+						edgeLengthChecker }, RANSACConvergenceCriteria(cfg.ransacNumIter_, cfg.ransacProbability_));
+	}
+	if (ransacResult.correspondence_set_.size() < cfg.ransacMinCorrespondenceSetSize_) {
+		*log << "REJECTED loop closure, " << ransacResult.correspondence_set_.size()
+				<< " correspondences. " << matchingSubmapsString << "\n";
+		return false;
+	}
+
+	if (!isRegistrationConsistent(ransacResult.transformation_, log)) {
+		*log << "REJECTED loop closure, with ransac inconsistant " << matchingSubmapsString << "\n";
+		return false;
+	}
+
+	const PointCloud &sourceMap = source.map_;
+	const PointCloud target = targetSubmap.getMapPointCloudCopy();
+	const double mapVoxelSize = getMapVoxelSize(params_.mapBuilder_,
+			magic::voxelSizeCorrespondenceSearchIfMapVoxelSizeIsZero);
+
+	const double voxelSizeForOverlap = magic::voxelExpansionFactorOverlapComputation * mapVoxelSize;
+	const size_t minNumPointsPerVoxel = 1;
+	std::vector<size_t> sourceIdxs, targetIdxs;
+	computeIndicesOfOverlappingPoints(sourceMap, target, Transform(ransacResult.transformation_),
+			voxelSizeForOverlap, minNumPointsPerVoxel, &sourceIdxs, &targetIdxs);
+	const PointCloud sourceOverlap = *sourceMap.SelectByIndex(sourceIdxs);
+	const PointCloud targetOverlap = *target.SelectByIndex(targetIdxs);
+
+	const auto icpResult = cloudRegistration->registerClouds(sourceOverlap, targetOverlap,Transform(ransacResult.transformation_));
+
+	if (icpResult.fitness_ < cfg.minRefinementFitness_) {
+		*log << "REJECTED loop closure, refinement score: " << icpResult.fitness_ << ", " << matchingSubmapsString << "\n";
+		return false;
+	}
+
+	if (!isRegistrationConsistent(icpResult.transformation_, log)) {
+		*log << "REJECTED loop closure, icp reg inconsistent, " << matchingSubmapsString << "\n";
+		return false;
+	}
+
+	*log << "source features num: " << source.feature_.Num() << "\n";
+	*log << "target features num: " << targetFeature.Num() << "\n";
+	*log << "registered num correspondences: " << ransacResult.correspondence_set_.size() << std::endl;
+	*log << "registered with fitness: " << ransacResult.fitness_ << std::endl;
+	*log << "registered with rmse: " << ransacResult.inlier_rmse_ << std::endl;
+	*log << "registered with transformation: \n" << asString(Transform(ransacResult.transformation_))
+			<< std::endl;
+
+	*log << "refined with fitness: " << icpResult.fitness_ << std::endl;
+	*log << "refined with rmse: " << icpResult.inlier_rmse_ << std::endl;
+	*log << "refined with transformation: \n" << asString(Transform(icpResult.transformation_))
+			<< std::endl;
+
+	Constraint &c = *constraint;
+	c.sourceToTarget_ = Transform(icpResult.transformation_);
+	c.sourceSubmapIdx_ = lastFinishedSubmapIdx;
+	c.targetSubmapIdx_ = id;
+	c.informationMatrix_ = open3d::pipelines::registration::GetInformationMatrixFromPointClouds(sourceOverlap,
+			targetOverlap, cfg.maxIcpCorrespondenceDistance_, icpResult.transformation_);
+	c.isInformationMatrixValid_ = true;
+	c.isOdometryConstraint_ = false;
+	c.timestamp_ = candidate.timestamp_;
+	assert_eq<int>(lastFinishedSubmapIdx,sourceSubmap.getId(), "oops source submap");
+	assert_eq<int>(id,targetSubmap.getId(), "oops target submap");
+
+	if (params_.placeRecognition_.isDumpPlaceRecognitionAlignmentsToFile_) {
+		std::string lcName = std::to_string(recognitionCounter_) + "_"+ std::to_string(sourceSubmap.getId())+"_"+std::to_string(targetSubmap.getId());
+		PointCloud sourceOverlapCopy = sourceOverlap;
+		PointCloud sourceCopy = sourceMap;
+		sourceCopy.Transform(icpResult.transformation_);
+		sourceOverlapCopy.Transform(icpResult.transformation_);
+		saveToFile(folderPath_ + "/overlap_source_" + lcName, sourceOverlapCopy);
+		saveToFile(folderPath_ + "/full_source_" + lcName, sourceCopy);
+		saveToFile(folderPath_ + "/full_target_" + lcName, target);
+		saveToFile(folderPath_ + "/overlap_target_" + lcName, targetOverlap);
+	}
+	*log << "ACCEPTED loop closure: " << matchingSubmapsString <<", " << asStringXYZRPY(c.sourceToTarget_) << "\n";
+	return true;
 }
 
 void PlaceRecognition::setFolderPath(const std::string &folderPath) {
 	folderPath_ = folderPath;
 }
 
-bool PlaceRecognition::isRegistrationConsistent(const Eigen::Matrix4d &mat) const {
+bool PlaceRecognition::isRegistrationConsistent(const Eigen::Matrix4d &mat, std::ostream *log) const {
 	const double kRadToDeg = 180.0 / M_PI;
 	const Transform T(mat);
 	const Eigen::Vector3d rpy = toRPY(Eigen::Quaterniond(T.rotation()));
@@ -193,37 +250,37 @@ bool PlaceRecognition::isRegistrationConsistent(const Eigen::Matrix4d &mat) cons
 	const PlaceRecognitionConsistencyCheckParameters &p = params_.placeRecognition_.consistencyCheck_;
 	if (std::fabs(roll) > p.maxDriftRoll_) {
 		result = false;
-		std::cout << "  PlaceRecognition::isRegistrationConsistent The roll drift is: " << roll * kRadToDeg
+		*log << "  PlaceRecognition::isRegistrationConsistent The roll drift is: " << roll * kRadToDeg
 				<< " [deg] which is > than " << p.maxDriftRoll_ * kRadToDeg << "\n";
 	}
 	if (std::fabs(pitch) > p.maxDriftPitch_) {
 		result = false;
-		std::cout << "  PlaceRecognition::isRegistrationConsistent The pitch drift is: " << pitch * kRadToDeg
+		*log << "  PlaceRecognition::isRegistrationConsistent The pitch drift is: " << pitch * kRadToDeg
 				<< " [deg] which is > than " << p.maxDriftPitch_ * kRadToDeg << "\n";
 	}
 	if (std::fabs(yaw) > p.maxDriftYaw_) {
 		result = false;
-		std::cout << "  PlaceRecognition::isRegistrationConsistent The yaw drift is: " << yaw * kRadToDeg
+		*log << "  PlaceRecognition::isRegistrationConsistent The yaw drift is: " << yaw * kRadToDeg
 				<< " [deg] which is > than " << p.maxDriftYaw_ * kRadToDeg << "\n";
 	}
 	if (std::fabs(T.translation().x()) > p.maxDriftX_){
 		result = false;
-		std::cout << "  PlaceRecognition::isRegistrationConsistent The x drift is: " << T.translation().x()
+		*log << "  PlaceRecognition::isRegistrationConsistent The x drift is: " << T.translation().x()
 				<< " [m] which is > than " << p.maxDriftX_ << "\n";
 	}
 	if (std::fabs(T.translation().y()) > p.maxDriftY_){
 		result = false;
-		std::cout << "  PlaceRecognition::isRegistrationConsistent The y drift is: " << T.translation().y()
+		*log << "  PlaceRecognition::isRegistrationConsistent The y drift is: " << T.translation().y()
 				<< " [m] which is > than " << p.maxDriftY_ << "\n";
 	}
 	if (std::fabs(T.translation().z()) > p.maxDriftZ_){
 		result = false;
-		std::cout << "  PlaceRecognition::isRegistrationConsistent The z drift is: " << T.translation().z()
+		*log << "  PlaceRecognition::isRegistrationConsistent The z drift is: " << T.translation().z()
 				<< " [m] which is > than " << p.maxDriftZ_ << "\n";
 	}
 
 	if (!result) {
-		std::cout << "   It is very unlikely that lidar odometry has drifted that much. Most likely, "
+		*log << "   It is very unlikely that lidar odometry has drifted that much. Most likely, "
 				"the place recognition module has fallen prey to spatial aliasing. If you are sure that this is "
 				"not the case, feel free to disable this check! \n";
 	}
@@ -235,52 +292,118 @@ std::vector<size_t> PlaceRecognition::getLoopClosureCandidatesIdxs(const Transfo
 		const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
 		size_t activeSubmapIdx) const {
 	std::vector<size_t> idxs;
-	const size_t nSubmaps = submapCollection.getNumSubmaps();
-	idxs.reserve(nSubmaps);
-	const Eigen::Vector3d lastFinishedSubmabCenter = submapCollection.getSubmap(lastFinishedSubmapIdx).getMapToSubmapCenter();
-	for (size_t i = 0; i < nSubmaps; ++i) {
-		if (i == activeSubmapIdx) {
-			continue;
-		}
-		const std::string matchingSubmapsString = " submap: " + std::to_string(lastFinishedSubmapIdx) + " with submap " + std::to_string(i);
-		const auto id1 = submapCollection.getSubmap(i).getId();
-		const auto id2 = submapCollection.getSubmap(activeSubmapIdx).getId();
-		if (adjMatrix.isAdjacent(id1, id2)) {
-			continue;
+	const Eigen::Vector3d lastFinishedSubmapCenter =
+			submapCollection.getSubmap(lastFinishedSubmapIdx).getMapToSubmapCenter();
+	const std::vector<size_t> closeIdxs = submapCollection.getSubmapCenterIndex().findWithinRadius(
+			lastFinishedSubmapCenter, params_.placeRecognition_.loopClosureSearchRadius_);
+	idxs.reserve(closeIdxs.size());
+	for (const size_t i : closeIdxs) {
+		if (isLoopClosureCandidate(i, submapCollection, adjMatrix, lastFinishedSubmapIdx, activeSubmapIdx, true)) {
+			idxs.push_back(i);
 		}
+	}
+	if (params_.placeRecognition_.globalDescriptor_.isUseGlobalDescriptor_) {
+		return rankByGlobalDescriptor(idxs, submapCollection, adjMatrix, lastFinishedSubmapIdx, activeSubmapIdx);
+	}
+	return idxs;
+}
 
-		const bool isAdjacent = std::abs<int>(i - lastFinishedSubmapIdx) == 1
-				|| adjMatrix.isAdjacent(i, lastFinishedSubmapIdx);
-		if (isAdjacent){
-//			std::cout << "Skipping the loop closure of " << matchingSubmapsString
-//					<< " since they are adjacent \n";
-			continue;
-		}
+bool PlaceRecognition::isLoopClosureCandidate(size_t i, const SubmapCollection &submapCollection,
+		const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx, size_t activeSubmapIdx,
+		bool isCheckDistance) const {
+	if (i == activeSubmapIdx) {
+		return false;
+	}
+	const std::string matchingSubmapsString = " submap: " + std::to_string(lastFinishedSubmapIdx) + " with submap " + std::to_string(i);
+	const auto id1 = submapCollection.getSubmap(i).getId();
+	const auto id2 = submapCollection.getSubmap(activeSubmapIdx).getId();
+	if (adjMatrix.isAdjacent(id1, id2)) {
+		return false;
+	}
 
+	const bool isAdjacent = std::abs<int>(i - lastFinishedSubmapIdx) == 1
+			|| adjMatrix.isAdjacent(i, lastFinishedSubmapIdx);
+	if (isAdjacent){
+//		std::cout << "Skipping the loop closure of " << matchingSubmapsString
+//				<< " since they are adjacent \n";
+		return false;
+	}
+
+	const double maxDistance = params_.placeRecognition_.loopClosureSearchRadius_;
+	if (isCheckDistance) {
+		const Eigen::Vector3d lastFinishedSubmabCenter = submapCollection.getSubmap(lastFinishedSubmapIdx).getMapToSubmapCenter();
 		const Eigen::Vector3d submapCenter = submapCollection.getSubmap(i).getMapToSubmapCenter();
-		const double maxDistance = params_.placeRecognition_.loopClosureSearchRadius_;
 		const double distance = (lastFinishedSubmabCenter-submapCenter).norm();
 //		const double distance = (mapToRangeSensor.translation() - submapCollection.getSubmap(i).getMapToSubmapCenter()).norm();
 		const bool isTooFar = distance > maxDistance;
 //		std::cout << "distance submap to submap " << i << " : " << distance << std::endl;
 		if (isTooFar) {
-			continue;
+			return false;
 		}
+	}
 
-		const int consecutiveThreshold = (int) std::ceil(maxDistance / params_.submaps_.radius_);
-		const bool isConsecutive = std::abs<int>(i - lastFinishedSubmapIdx) <= consecutiveThreshold;
-		if (isConsecutive) {
-			continue;
+	const int consecutiveThreshold = (int) std::ceil(maxDistance / params_.submaps_.radius_);
+	const bool isConsecutive = std::abs<int>(i - lastFinishedSubmapIdx) <= consecutiveThreshold;
+	if (isConsecutive) {
+		return false;
+	}
+
+	const int loopClosingDistance = adjMatrix.getDistanceToNearestLoopClosureSubmap(lastFinishedSubmapIdx);
+//	std::cout << "submap " << lastFinishedSubmapIdx<<" has lc dist of: " << loopClosingDistance << "\n";
+	if (loopClosingDistance < params_.placeRecognition_.minSubmapsBetweenLoopClosures_){
+		std::cout << "Skipping the loop closure of " << matchingSubmapsString << " since there are fewer than "<<  params_.placeRecognition_.minSubmapsBetweenLoopClosures_ << " submaps inbetween \n";
+		return false;
+	}
+
+	return true;
+}
+
+std::vector<size_t> PlaceRecognition::rankByGlobalDescriptor(const std::vector<size_t> &closeSubmapsIdxs,
+		const SubmapCollection &submapCollection, const AdjacencyMatrix &adjMatrix, size_t lastFinishedSubmapIdx,
+		size_t activeSubmapIdx) const {
+	const GlobalDescriptorParameters &p = params_.placeRecognition_.globalDescriptor_;
+	const ScanContextIndex &index = submapCollection.getScanContextIndex();
+	ScanContext query;
+	if (!index.getDescriptor(lastFinishedSubmapIdx, &query)) {
+		return closeSubmapsIdxs;
+	}
+
+	// submaps with a similar descriptor anywhere in the map, plus the ones close by
+	std::map<size_t, double> descriptorDistances;
+	const size_t numNearest = magic::globalDescriptorNumNearestRingKeysPerCandidate * p.numCandidates_;
+	for (const auto &match : index.query(query, numNearest)) {
+		if (isLoopClosureCandidate(match.submapId_, submapCollection, adjMatrix, lastFinishedSubmapIdx,
+				activeSubmapIdx, false)) {
+			descriptorDistances[match.submapId_] = match.distance_;
+		}
+	}
+	for (const size_t idx : closeSubmapsIdxs) {
+		ScanContext descriptor;
+		if (descriptorDistances.count(idx) == 0 && index.getDescriptor(idx, &descriptor)) {
+			descriptorDistances[idx] = query.distance(descriptor);
 		}
+	}
 
-		const int loopClosingDistance = adjMatrix.getDistanceToNearestLoopClosureSubmap(lastFinishedSubmapIdx);
-//		std::cout << "submap " << lastFinishedSubmapIdx<<" has lc dist of: " << loopClosingDistance << "\n";
-		if (loopClosingDistance < params_.placeRecognition_.minSubmapsBetweenLoopClosures_){
-			std::cout << "Skipping the loop closure of " << matchingSubmapsString << " since there are fewer than "<<  params_.placeRecognition_.minSubmapsBetweenLoopClosures_ << " submaps inbetween \n";
-			continue;
+	std::vector<ScanContextIndex::Match> ranked;
+	for (const auto &d : descriptorDistances) {
+		if (d.second <= p.maxDescriptorDistance_) {
+			ranked.push_back( { d.first, d.second });
 		}
+	}
+	std::sort(ranked.begin(), ranked.end(), [](const ScanContextIndex::Match &a, const ScanContextIndex::Match &b) {
+		return a.distance_ < b.distance_ || (a.distance_ == b.distance_ && a.submapId_ < b.submapId_);
+	});
+	const size_t numCandidates = std::max(p.numCandidates_, 0);
+	if (ranked.size() > numCandidates) {
+		ranked.resize(numCandidates);
+	}
 
-		idxs.push_back(i);
+	std::vector<size_t> idxs;
+	idxs.reserve(ranked.size());
+	for (const auto &match : ranked) {
+		std::cout << "  global descriptor candidate for submap " << lastFinishedSubmapIdx << ": submap "
+				<< match.submapId_ << ", distance: " << match.distance_ << "\n";
+		idxs.push_back(match.submapId_);
 	}
 	return idxs;
 }
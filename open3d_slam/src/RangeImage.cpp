@@ -0,0 +1,283 @@
+/*
+ * RangeImage.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/RangeImage.hpp"
+#include "open3d_slam/math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <open3d/geometry/PointCloud.h>
+
+#ifdef open3d_slam_OPENMP_FOUND
+#include <omp.h>
+#endif
+
+namespace o3d_slam {
+
+namespace {
+enum FeatureLabel : uint8 {
+	None = 0, Edge = 1, Planar = 2, Ground = 4
+};
+} // namespace
+
+RangeImage::RangeImage(int numRows, int numCols) {
+	resize(numRows, numCols);
+}
+
+void RangeImage::resize(int numRows, int numCols) {
+	numRows_ = std::max(numRows, 0);
+	numCols_ = std::max(numCols, 0);
+	const size_t nCells = static_cast<size_t>(numRows_) * numCols_;
+	numPoints_ = 0;
+	isValid_.assign(nCells, 0);
+	ranges_.assign(nCells, 0.0f);
+	points_.resize(nCells);
+	timeOffsets_.assign(nCells, 0.0);
+	normals_.clear();
+	hasNormal_.clear();
+}
+
+size_t RangeImage::cellIdx(int row, int col) const {
+	return static_cast<size_t>(row) * numCols_ + col;
+}
+
+void RangeImage::setPoint(int row, int col, const Eigen::Vector3d &p, double timeOffset) {
+	if (row < 0 || row >= numRows_ || col < 0 || col >= numCols_ || !p.allFinite()) {
+		return;
+	}
+	const size_t idx = cellIdx(row, col);
+	const float range = p.norm();
+	if (isValid_[idx] && ranges_[idx] <= range) {
+		return;
+	}
+	numPoints_ += isValid_[idx] ? 0 : 1;
+	isValid_[idx] = 1;
+	ranges_[idx] = range;
+	points_[idx] = p;
+	timeOffsets_[idx] = timeOffset;
+}
+
+int RangeImage::getColumnFromAzimuth(const Eigen::Vector3d &p) const {
+	const double azimuth = std::atan2(p.y(), p.x()) + M_PI;
+	const int col = static_cast<int>(azimuth / (2.0 * M_PI) * numCols_);
+	return std::min(std::max(col, 0), numCols_ - 1);
+}
+
+int RangeImage::getNumRows() const {
+	return numRows_;
+}
+
+int RangeImage::getNumCols() const {
+	return numCols_;
+}
+
+size_t RangeImage::getNumPoints() const {
+	return numPoints_;
+}
+
+bool RangeImage::isValid(int row, int col) const {
+	return isValid_[cellIdx(row, col)];
+}
+
+const Eigen::Vector3d& RangeImage::getPoint(int row, int col) const {
+	return points_[cellIdx(row, col)];
+}
+
+double RangeImage::getRange(int row, int col) const {
+	return ranges_[cellIdx(row, col)];
+}
+
+std::vector<double> RangeImage::getColumnTimeOffsets() const {
+	std::vector<double> columnTimes(numCols_, std::numeric_limits<double>::quiet_NaN());
+	for (int col = 0; col < numCols_; ++col) {
+		double sum = 0.0;
+		int n = 0;
+		for (int row = 0; row < numRows_; ++row) {
+			const size_t idx = cellIdx(row, col);
+			if (isValid_[idx]) {
+				sum += timeOffsets_[idx];
+				++n;
+			}
+		}
+		if (n > 0) {
+			columnTimes[col] = sum / n;
+		}
+	}
+	return columnTimes;
+}
+
+std::vector<double> RangeImage::getColumnTimeOffsetsFromFiringOrder(double scanDuration) const {
+	std::vector<double> columnTimes(numCols_);
+	for (int col = 0; col < numCols_; ++col) {
+		columnTimes[col] = scanDuration * col / numCols_;
+	}
+	return columnTimes;
+}
+
+void RangeImage::estimateNormals(int halfWindowRows, int halfWindowCols, double maxNeighbourDistance) {
+	normals_.assign(isValid_.size(), Eigen::Vector3d::Zero());
+	hasNormal_.assign(isValid_.size(), 0);
+	const double maxDistanceSquared = maxNeighbourDistance * maxNeighbourDistance;
+	// the scan wraps around, the first and the last column are neighbours
+	const int colWindow = std::min(halfWindowCols, (numCols_ - 1) / 2);
+#pragma omp parallel for schedule(static)
+	for (int row = 0; row < numRows_; ++row) {
+		for (int col = 0; col < numCols_; ++col) {
+			const size_t idx = cellIdx(row, col);
+			if (!isValid_[idx]) {
+				continue;
+			}
+			const Eigen::Vector3d &p = points_[idx];
+			// moments relative to p, keeps the covariance well conditioned far away from the sensor
+			Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+			Eigen::Matrix3d sumSquares = Eigen::Matrix3d::Zero();
+			int n = 0;
+			for (int r = std::max(row - halfWindowRows, 0); r <= std::min(row + halfWindowRows, numRows_ - 1); ++r) {
+				for (int dc = -colWindow; dc <= colWindow; ++dc) {
+					const size_t neighbourIdx = cellIdx(r, (col + dc + numCols_) % numCols_);
+					if (!isValid_[neighbourIdx]) {
+						continue;
+					}
+					const Eigen::Vector3d d = points_[neighbourIdx] - p;
+					if (d.squaredNorm() > maxDistanceSquared) {
+						continue;
+					}
+					sum += d;
+					sumSquares += d * d.transpose();
+					++n;
+				}
+			}
+			if (n < 3) {
+				continue;
+			}
+			const Eigen::Vector3d mean = sum / n;
+			const Eigen::Matrix3d covariance = sumSquares / n - mean * mean.transpose();
+			normals_[idx] = orientNormalTowardsViewpoint(normalFromCovariance(covariance), p, Eigen::Vector3d::Zero());
+			hasNormal_[idx] = 1;
+		}
+	}
+}
+
+bool RangeImage::hasNormals() const {
+	return !normals_.empty();
+}
+
+std::vector<uint8> RangeImage::computeFeatureLabels(const RangeImageFeatureParameters &p) const {
+	const int halfWindow = std::min(p.curvatureHalfWindow_, (numCols_ - 1) / 2);
+	std::vector<uint8> labels(isValid_.size(), None);
+#pragma omp parallel for schedule(static)
+	for (int row = 0; row < numRows_; ++row) {
+		for (int col = 0; col < numCols_; ++col) {
+			const size_t idx = cellIdx(row, col);
+			if (!isValid_[idx]) {
+				continue;
+			}
+			const double range = ranges_[idx];
+			double sum = 0.0;
+			bool isComplete = halfWindow > 0;
+			for (int dc = -halfWindow; dc <= halfWindow && isComplete; ++dc) {
+				const size_t neighbourIdx = cellIdx(row, (col + dc + numCols_) % numCols_);
+				isComplete = isValid_[neighbourIdx];
+				sum += ranges_[neighbourIdx] - range;
+			}
+			if (isComplete && range > 0.0) {
+				const double curvature = std::abs(sum) / (2 * halfWindow * range);
+				if (curvature > p.edgeMinCurvature_) {
+					labels[idx] |= Edge;
+				} else if (curvature < p.planarMaxCurvature_) {
+					labels[idx] |= Planar;
+				}
+			}
+			const Eigen::Vector3d &point = points_[idx];
+			if (point.z() > p.groundMaxZ_) {
+				continue;
+			}
+			for (const int r : { row - 1, row + 1 }) {
+				if (r < 0 || r >= numRows_ || !isValid_[cellIdx(r, col)]) {
+					continue;
+				}
+				const Eigen::Vector3d d = points_[cellIdx(r, col)] - point;
+				if (std::atan2(std::abs(d.z()), d.head<2>().norm()) < p.groundMaxSlope_) {
+					labels[idx] |= Ground;
+					break;
+				}
+			}
+		}
+	}
+	return labels;
+}
+
+void RangeImage::extractFeatures(const RangeImageFeatureParameters &p, PointCloud *edges, PointCloud *planar,
+		PointCloud *ground) const {
+	const std::vector<uint8> labels = computeFeatureLabels(p);
+	auto collect = [&](uint8 label, PointCloud *out) {
+		if (out == nullptr) {
+			return;
+		}
+		out->Clear();
+		for (size_t idx = 0; idx < labels.size(); ++idx) {
+			if (labels[idx] & label) {
+				out->points_.push_back(points_[idx]);
+				if (hasNormals() && hasNormal_[idx]) {
+					out->normals_.push_back(normals_[idx]);
+				}
+			}
+		}
+		if (out->normals_.size() != out->points_.size()) {
+			out->normals_.clear();
+		}
+	};
+	collect(Edge, edges);
+	collect(Planar, planar);
+	collect(Ground, ground);
+}
+
+void RangeImage::keepOnlyFeaturePoints(const RangeImageFeatureParameters &p) {
+	const std::vector<uint8> labels = computeFeatureLabels(p);
+	for (size_t idx = 0; idx < labels.size(); ++idx) {
+		if (isValid_[idx] && labels[idx] == None) {
+			isValid_[idx] = 0;
+			--numPoints_;
+		}
+	}
+}
+
+bool RangeImage::isPointKept(size_t idx) const {
+	return isValid_[idx] && (!hasNormals() || hasNormal_[idx]);
+}
+
+PointCloud RangeImage::toPointCloud() const {
+	PointCloud cloud;
+	cloud.points_.reserve(numPoints_);
+	if (hasNormals()) {
+		cloud.normals_.reserve(numPoints_);
+	}
+	for (size_t idx = 0; idx < isValid_.size(); ++idx) {
+		if (!isPointKept(idx)) {
+			continue;
+		}
+		cloud.points_.push_back(points_[idx]);
+		if (hasNormals()) {
+			cloud.normals_.push_back(normals_[idx]);
+		}
+	}
+	return cloud;
+}
+
+std::vector<float> RangeImage::getPointTimeOffsets(const std::vector<double> &columnTimeOffsets) const {
+	std::vector<float> timeOffsets;
+	timeOffsets.reserve(numPoints_);
+	for (size_t idx = 0; idx < isValid_.size(); ++idx) {
+		if (isPointKept(idx)) {
+			timeOffsets.push_back(columnTimeOffsets[idx % numCols_]);
+		}
+	}
+	return timeOffsets;
+}
+
+} // namespace o3d_slam
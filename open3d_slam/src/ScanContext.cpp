@@ -0,0 +1,195 @@
+/*
+ * ScanContext.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/ScanContext.hpp"
+#include "open3d_slam/assert.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace o3d_slam {
+
+ScanContext::ScanContext(const GlobalDescriptorParameters &p) :
+		numRings_(p.numRings_), numSectors_(p.numSectors_), maxRadius_(p.maxRadius_) {
+	assert_gt(numRings_, 0, "ScanContext num rings");
+	assert_gt(numSectors_, 0, "ScanContext num sectors");
+	assert_gt(maxRadius_, 0.0, "ScanContext max radius");
+}
+
+void ScanContext::compute(const PointCloud &cloud, const Eigen::Vector3d &center) {
+	descriptor_.setZero(numRings_, numSectors_);
+	ringKey_.setZero(numRings_);
+	double minZ = std::numeric_limits<double>::max();
+	for (const auto &p : cloud.points_) {
+		if ((p - center).head<2>().norm() <= maxRadius_) {
+			minZ = std::min(minZ, p.z());
+		}
+	}
+	for (const auto &p : cloud.points_) {
+		const Eigen::Vector3d d = p - center;
+		const double r = d.head<2>().norm();
+		if (r > maxRadius_) {
+			continue;
+		}
+		const int ring = std::min(static_cast<int>(r / maxRadius_ * numRings_), numRings_ - 1);
+		const double angle = std::atan2(d.y(), d.x()) + M_PI;
+		const int sector = std::min(static_cast<int>(angle / (2.0 * M_PI) * numSectors_), numSectors_ - 1);
+		// + small offset, so that the lowest point still marks the bin as occupied
+		const double height = p.z() - minZ + 1e-3;
+		descriptor_(ring, sector) = std::max(descriptor_(ring, sector), height);
+	}
+	for (int i = 0; i < numRings_; ++i) {
+		ringKey_(i) = static_cast<double>((descriptor_.row(i).array() > 0.0).count()) / numSectors_;
+	}
+}
+
+double ScanContext::distance(const ScanContext &other) const {
+	assert_eq(numRings_, other.numRings_, "ScanContext num rings mismatch");
+	assert_eq(numSectors_, other.numSectors_, "ScanContext num sectors mismatch");
+	if (isEmpty() || other.isEmpty()) {
+		return 1.0;
+	}
+	const Eigen::RowVectorXd norms = descriptor_.colwise().norm();
+	const Eigen::RowVectorXd otherNorms = other.descriptor_.colwise().norm();
+	// cosine similarity of every pair of sectors, the shifts are the wrapped diagonals
+	const Eigen::MatrixXd dots = descriptor_.transpose() * other.descriptor_;
+	double minDistance = 1.0;
+	for (int shift = 0; shift < numSectors_; ++shift) {
+		double similarity = 0.0;
+		int numValid = 0;
+		for (int j = 0; j < numSectors_; ++j) {
+			const int k = (j + shift) % numSectors_;
+			if (norms(j) == 0.0 || otherNorms(k) == 0.0) {
+				continue;
+			}
+			similarity += dots(j, k) / (norms(j) * otherNorms(k));
+			++numValid;
+		}
+		if (numValid > 0) {
+			minDistance = std::min(minDistance, 1.0 - similarity / numValid);
+		}
+	}
+	return minDistance;
+}
+
+const Eigen::VectorXd& ScanContext::getRingKey() const {
+	return ringKey_;
+}
+
+bool ScanContext::isEmpty() const {
+	return descriptor_.size() == 0 || (descriptor_.array() == 0.0).all();
+}
+
+void ScanContextIndex::insert(size_t submapId, const ScanContext &descriptor) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	const auto search = submapIdToIdx_.find(submapId);
+	if (search != submapIdToIdx_.end()) {
+		const size_t idx = search->second;
+		descriptors_[idx] = descriptor;
+		if (idx < numInTree_ && !isReplaced_[idx]) {
+			isReplaced_[idx] = 1;
+			++numReplaced_;
+		}
+	} else {
+		submapIdToIdx_.emplace(submapId, descriptors_.size());
+		submapIds_.push_back(submapId);
+		descriptors_.push_back(descriptor);
+	}
+	if (getNumNotInTree() > numInTree_) {
+		rebuildTree();
+	}
+}
+
+size_t ScanContextIndex::getNumNotInTree() const {
+	return descriptors_.size() - numInTree_ + numReplaced_;
+}
+
+void ScanContextIndex::rebuildTree() {
+	Eigen::MatrixXd ringKeys(descriptors_.front().getRingKey().size(), descriptors_.size());
+	for (size_t i = 0; i < descriptors_.size(); ++i) {
+		ringKeys.col(i) = descriptors_[i].getRingKey();
+	}
+	ringKeyTree_ = std::make_unique<open3d::geometry::KDTreeFlann>(ringKeys);
+	numInTree_ = descriptors_.size();
+	isReplaced_.assign(numInTree_, 0);
+	numReplaced_ = 0;
+}
+
+void ScanContextIndex::clear() {
+	std::lock_guard<std::mutex> lck(mutex_);
+	submapIds_.clear();
+	descriptors_.clear();
+	submapIdToIdx_.clear();
+	ringKeyTree_.reset();
+	numInTree_ = 0;
+	isReplaced_.clear();
+	numReplaced_ = 0;
+}
+
+size_t ScanContextIndex::size() const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	return submapIds_.size();
+}
+
+bool ScanContextIndex::getDescriptor(size_t submapId, ScanContext *descriptor) const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	const auto search = submapIdToIdx_.find(submapId);
+	if (search == submapIdToIdx_.end()) {
+		return false;
+	}
+	*descriptor = descriptors_[search->second];
+	return true;
+}
+
+std::vector<ScanContextIndex::Match> ScanContextIndex::query(const ScanContext &descriptor, size_t numNearest) const {
+	std::vector<Match> matches;
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (submapIds_.empty() || descriptor.isEmpty() || numNearest == 0) {
+		return matches;
+	}
+	const Eigen::VectorXd &ringKey = descriptor.getRingKey();
+	// squared ring key distance and descriptor idx
+	std::vector<std::pair<double, size_t>> candidates;
+	candidates.reserve(numNearest + getNumNotInTree());
+	if (ringKeyTree_ != nullptr) {
+		// the replaced descriptors are dropped from the result, ask for enough to make up for them
+		std::vector<int> idxs;
+		std::vector<double> squaredDistances;
+		const int knn = std::min(numNearest + numReplaced_, numInTree_);
+		ringKeyTree_->SearchKNN(ringKey, knn, idxs, squaredDistances);
+		for (size_t i = 0; i < idxs.size(); ++i) {
+			if (!isReplaced_[idxs[i]]) {
+				candidates.emplace_back(squaredDistances[i], idxs[i]);
+			}
+		}
+	}
+	const auto addCandidate = [&](size_t idx) {
+		candidates.emplace_back((ringKey - descriptors_[idx].getRingKey()).squaredNorm(), idx);
+	};
+	for (size_t idx = numInTree_; idx < descriptors_.size(); ++idx) {
+		addCandidate(idx);
+	}
+	for (size_t idx = 0; idx < numInTree_ && numReplaced_ > 0; ++idx) {
+		if (isReplaced_[idx]) {
+			addCandidate(idx);
+		}
+	}
+	const size_t numKept = std::min(numNearest, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + numKept, candidates.end());
+	matches.reserve(numKept);
+	for (size_t i = 0; i < numKept; ++i) {
+		const size_t idx = candidates[i].second;
+		matches.push_back( { submapIds_[idx], descriptor.distance(descriptors_[idx]) });
+	}
+	std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+		return a.distance_ < b.distance_ || (a.distance_ == b.distance_ && a.submapId_ < b.submapId_);
+	});
+	return matches;
+}
+
+} // namespace o3d_slam
@@ -0,0 +1,156 @@
+/*
+ * ScanFeatureCache.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/ScanFeatureCache.hpp"
+#include "open3d_slam/VoxelHashMap.hpp"
+#include "open3d_slam/math.hpp"
+
+#include <open3d/geometry/KDTreeFlann.h>
+
+#ifdef open3d_slam_OPENMP_FOUND
+#include <omp.h>
+#endif
+
+namespace o3d_slam {
+
+namespace {
+// above this many points without a cached neighbour it is cheaper to estimate everything
+const double kMaxFractionOfEstimatedPoints = 0.3;
+
+Eigen::Vector3d computeNormal(const PointCloud &cloud, const std::vector<int> &nn) {
+	if (nn.size() < 3) {
+		return Eigen::Vector3d::UnitZ();
+	}
+	Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+	for (const int idx : nn) {
+		mean += cloud.points_[idx];
+	}
+	mean /= nn.size();
+	Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+	for (const int idx : nn) {
+		const Eigen::Vector3d d = cloud.points_[idx] - mean;
+		covariance += d * d.transpose();
+	}
+	return normalFromCovariance(covariance);
+}
+} // namespace
+
+ScanFeatureCache::ScanFeatureCache(size_t capacity) :
+		capacity_(capacity) {
+}
+
+void ScanFeatureCache::insert(const Time &timestamp, const Entry &entry) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (!entries_.empty() && timestamp <= entries_.back().first) {
+		return;
+	}
+	entries_.emplace_back(timestamp, entry);
+	while (entries_.size() > capacity_) {
+		entries_.pop_front();
+	}
+}
+
+bool ScanFeatureCache::take(const Time &timestamp, Entry *entry) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	while (!entries_.empty() && entries_.front().first < timestamp) {
+		entries_.pop_front();
+	}
+	if (entries_.empty() || entries_.front().first != timestamp) {
+		return false;
+	}
+	*entry = std::move(entries_.front().second);
+	entries_.pop_front();
+	return true;
+}
+
+size_t ScanFeatureCache::size() const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	return entries_.size();
+}
+
+void ScanFeatureCache::clear() {
+	std::lock_guard<std::mutex> lck(mutex_);
+	entries_.clear();
+}
+
+bool transferNormals(const ScanFeatureCache::Entry &entry, int knn, double maxRadius, PointCloud *cloud) {
+	if (entry.cloud_ == nullptr || !entry.cloud_->HasNormals() || entry.voxelSize_ <= 0.0 || entry.knn_ != knn
+			|| entry.maxRadius_ != maxRadius) {
+		return false;
+	}
+	const PointCloud &cached = *entry.cloud_;
+	const InverseVoxelSize invVoxelSize = fromVoxelSize(Eigen::Vector3d::Constant(entry.voxelSize_));
+	// the cached scan is voxelized, so there is (almost always) one point per voxel
+	RobinHoodHashMap<Eigen::Vector3i, uint32, EigenVec3iHash> voxelToIdx(cached.points_.size());
+	for (size_t i = 0; i < cached.points_.size(); ++i) {
+		voxelToIdx.insert(std::make_pair(getVoxelIdx(cached.points_[i], invVoxelSize), static_cast<uint32>(i)));
+	}
+
+	const auto &index = voxelToIdx;
+	const int nPoints = cloud->points_.size();
+	std::vector<Eigen::Vector3d> normals(nPoints);
+	std::vector<uint8> isTransferred(nPoints, 0);
+	const double maxDistanceSquared = entry.voxelSize_ * entry.voxelSize_;
+	int nMissing = 0;
+#pragma omp parallel for schedule(static) reduction(+:nMissing)
+	for (int i = 0; i < nPoints; ++i) {
+		const Eigen::Vector3d &p = cloud->points_[i];
+		const Eigen::Vector3i key = getVoxelIdx(p, invVoxelSize);
+		double minDistanceSquared = maxDistanceSquared;
+		for (int dx = -1; dx <= 1; ++dx) {
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dz = -1; dz <= 1; ++dz) {
+					const auto search = index.find(key + Eigen::Vector3i(dx, dy, dz));
+					if (search == index.end()) {
+						continue;
+					}
+					const double distanceSquared = (cached.points_[search->second] - p).squaredNorm();
+					if (distanceSquared <= minDistanceSquared) {
+						minDistanceSquared = distanceSquared;
+						normals[i] = cached.normals_[search->second];
+						isTransferred[i] = 1;
+					}
+				}
+			}
+		}
+		nMissing += isTransferred[i] ? 0 : 1;
+	}
+
+	// decide before building the kd tree, with this many misses the caller estimates all the normals anyway
+	if (nMissing > kMaxFractionOfEstimatedPoints * nPoints) {
+		return false;
+	}
+	if (nMissing > 0) {
+		std::vector<int> idxsToEstimate;
+		idxsToEstimate.reserve(nMissing);
+		for (int i = 0; i < nPoints; ++i) {
+			if (!isTransferred[i]) {
+				idxsToEstimate.push_back(i);
+			}
+		}
+		const open3d::geometry::KDTreeFlann kdTree(*cloud);
+		const int nToEstimate = idxsToEstimate.size();
+#pragma omp parallel for schedule(static)
+		for (int j = 0; j < nToEstimate; ++j) {
+			const int i = idxsToEstimate[j];
+			std::vector<int> nn;
+			std::vector<double> distances;
+			kdTree.SearchHybrid(cloud->points_[i], maxRadius, knn, nn, distances);
+			normals[i] = computeNormal(*cloud, nn);
+		}
+	}
+
+	// same as NormalizeNormals followed by OrientNormalsTowardsCameraLocation with the sensor at the origin
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < nPoints; ++i) {
+		normals[i] = orientNormalTowardsViewpoint(normals[i], cloud->points_[i], Eigen::Vector3d::Zero());
+	}
+	cloud->normals_ = std::move(normals);
+	return true;
+}
+
+} // namespace o3d_slam
@@ -9,6 +9,7 @@
 #include "open3d_slam/helpers.hpp"
 #include "open3d_slam/assert.hpp"
 #include "open3d_slam/CloudRegistration.hpp"
+#include "open3d_slam/ScanFeatureCache.hpp"
 
 namespace o3d_slam {
 
@@ -18,6 +19,10 @@ std::shared_ptr<CloudRegistration> cloudRegistration;
 
 } // namespace
 
+void ScanToMapRegistration::setScanFeatureCache(std::shared_ptr<ScanFeatureCache> cache) {
+	scanFeatureCache_ = cache;
+}
+
 ScanToMapIcp::ScanToMapIcp() {
 	update(params_);
 }
@@ -32,19 +37,30 @@ void ScanToMapIcp::update(const MapperParameters &p) {
 	cloudRegistration = cloudRegistrationFactory(toCloudRegistrationType(p.scanMatcher_));
 }
 
-PointCloudPtr ScanToMapIcp::preprocess(const PointCloud &in) const{
-	auto croppedCloud = mapBuilderCropper_->crop(in);
-	o3d_slam::voxelize(params_.scanProcessing_.voxelSize_, croppedCloud.get());
-	cloudRegistration->estimateNormalsOrCovariancesIfNeeded(croppedCloud.get());
-	return croppedCloud->RandomDownSample(params_.scanProcessing_.downSamplingRatio_);
+PointCloudPtr ScanToMapIcp::preprocess(const PointCloud &in, const Time &timestamp) const{
+	auto croppedCloud = cropAndVoxelize(*mapBuilderCropper_, params_.scanProcessing_.voxelSize_, in);
+	// scans that come from a range image have their normals already
+	bool isHasNormals = in.HasNormals();
+	int knn = 0;
+	double maxRadius = 0.0;
+	ScanFeatureCache::Entry cached;
+	if (!isHasNormals && scanFeatureCache_ != nullptr && params_.scanMatcher_.isReuseOdometryNormals_
+			&& cloudRegistration->getNormalEstimationParameters(&knn, &maxRadius) && scanFeatureCache_->take(timestamp, &cached)) {
+		isHasNormals = transferNormals(cached, knn, maxRadius, croppedCloud.get());
+	}
+	if (!isHasNormals) {
+		cloudRegistration->estimateNormalsOrCovariancesIfNeeded(croppedCloud.get());
+	}
+	randomDownSample(params_.scanProcessing_.downSamplingRatio_, croppedCloud.get());
+	return croppedCloud;
 }
 
 ProcessedScans ScanToMapIcp::processForScanMatchingAndMerging(const PointCloud &in,
-		const Transform &mapToRangeSensor) const {
+		const Transform &mapToRangeSensor, const Time &timestamp) const {
 	ProcessedScans retVal;
 	PointCloudPtr narrowCropped, wideCropped;
 	Timer timer;
-	wideCropped = preprocess(in);
+	wideCropped = preprocess(in, timestamp);
 	scanMatcherCropper_->setPose(Transform::Identity());
 	narrowCropped = scanMatcherCropper_->crop(*wideCropped);
 	retVal.match_ = narrowCropped;
@@ -55,11 +71,25 @@ ProcessedScans ScanToMapIcp::processForScanMatchingAndMerging(const PointCloud &
 }
 RegistrationResult ScanToMapIcp::scanToMapRegistration(const PointCloud &scan, const Submap &activeSubmap,
 		const Transform &mapToRangeSensor, const Transform &initialGuess) const {
-	const PointCloud &activeSubmapPointCloud = activeSubmap.getMapPointCloud();
-	scanMatcherCropper_->setPose(mapToRangeSensor);
-	const PointCloudPtr mapPatch = scanMatcherCropper_->crop(activeSubmapPointCloud);
-	assert_gt<int>(mapPatch->points_.size(), 0, "map patch size is zero");
-	return cloudRegistration->registerClouds(scan, *mapPatch, initialGuess);
+	// the references stay valid, only the mapping thread modifies the active submap. The submap is kept
+	// in its own frame, the registration runs in it and the result is moved back to the map frame.
+	const IncrementalKdTree &mapIndex = activeSubmap.getMapIndex();
+	const Transform mapToSubmap = activeSubmap.getMapToSubmapOrigin();
+	const Transform submapToInitialGuess = mapToSubmap.inverse() * initialGuess;
+	scanMatcherCropper_->setPose(mapToSubmap.inverse() * mapToRangeSensor);
+	RegistrationResult result;
+	if (cloudRegistration->isIndexedTargetSupported() && !mapIndex.empty()) {
+		// query the submap's index directly, the cropper gates the correspondences instead of cropping the map
+		result = cloudRegistration->registerCloudToIndex(scan, mapIndex, scanMatcherCropper_.get(),
+				submapToInitialGuess);
+	} else {
+		const PointCloud &activeSubmapPointCloud = activeSubmap.getMapPointCloud();
+		const PointCloudPtr mapPatch = scanMatcherCropper_->crop(activeSubmapPointCloud);
+		assert_gt<int>(mapPatch->points_.size(), 0, "map patch size is zero");
+		result = cloudRegistration->registerClouds(scan, *mapPatch, submapToInitialGuess);
+	}
+	result.transformation_ = mapToSubmap.matrix() * result.transformation_;
+	return result;
 }
 
 bool ScanToMapIcp::isMergeScanValid(const PointCloud &in) const {
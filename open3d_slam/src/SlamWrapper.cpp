@@ -23,6 +23,8 @@
 #include "open3d_slam/Odometry.hpp"
 #include "open3d_slam/MotionCompensation.hpp"
 #include "open3d_slam/ScanToMapRegistration.hpp"
+#include "open3d_slam/MapFile.hpp"
+#include "open3d_slam/ScanFeatureCache.hpp"
 
 #ifdef open3d_slam_OPENMP_FOUND
 #include <omp.h>
@@ -33,6 +35,8 @@ namespace o3d_slam {
 namespace {
 using namespace o3d_slam::frames;
 const double timingStatsEveryNsec = 15.0;
+// the workers are woken up by new data, the timeout is only a safety net
+const auto workerWaitTimeout = std::chrono::milliseconds(500);
 }
 
 SlamWrapper::SlamWrapper() {
@@ -88,6 +92,14 @@ const MapperParameters &SlamWrapper::getMapperParameters() const{
 	return params_.mapper_;
 }
 
+const RangeImageParameters &SlamWrapper::getRangeImageParameters() const{
+	return params_.rangeImage_;
+}
+
+const ConstantVelocityMotionCompensationParameters &SlamWrapper::getMotionCompensationParameters() const{
+	return params_.motionCompensation_;
+}
+
 MapperParameters *SlamWrapper::getMapperParametersPtr(){
 	return mapper_->getParametersPtr();
 }
@@ -105,35 +117,49 @@ size_t SlamWrapper::getMappingBufferSizeLimit() const {
 	return mappingBuffer_.size_limit();
 }
 
-void SlamWrapper::addRangeScan(const open3d::geometry::PointCloud cloud, const Time timestamp) {
+void SlamWrapper::addRangeScan(const open3d::geometry::PointCloud &cloud, const Time timestamp) {
+	addRangeScan(cloud, timestamp, std::vector<float>());
+}
+
+void SlamWrapper::addRangeScan(const open3d::geometry::PointCloud &cloud, const Time timestamp,
+		std::vector<float> pointTimeOffsets) {
 	updateFirstMeasurementTime(timestamp);
 
-	auto removedNans = removePointsWithNonFiniteValues(cloud);
-	const TimestampedPointCloud timestampedCloud { timestamp, *removedNans };
-	if (!odometryBuffer_.empty()) {
-		const auto latestTime = odometryBuffer_.peek_back().time_;
-		if (timestamp < latestTime) {
-			std::cerr << "you are trying to add a range scan out of order! Dropping the measurement! \n";
-			return;
-		}
+	if (!pointTimeOffsets.empty() && pointTimeOffsets.size() != cloud.points_.size()) {
+		std::cerr << "Number of point times does not match the number of points, ignoring them! \n";
+		pointTimeOffsets.clear();
+	}
+	auto removedNans = pointTimeOffsets.empty() ?
+			removePointsWithNonFiniteValues(cloud) : removePointsWithNonFiniteValues(cloud, &pointTimeOffsets);
+	const TimestampedPointCloud timestampedCloud { timestamp, std::move(removedNans),
+			std::make_shared<const std::vector<float>>(std::move(pointTimeOffsets)) };
+	TimestampedPointCloud latest;
+	if (odometryBuffer_.tryPeekBack(&latest) && timestamp < latest.time_) {
+		std::cerr << "you are trying to add a range scan out of order! Dropping the measurement! \n";
+		return;
 	}
 	odometryBuffer_.push(timestampedCloud);
 }
 
+bool SlamWrapper::waitUntilBuffersHaveSpace(std::chrono::milliseconds timeout) const {
+	// keep one slot free, the odometry worker pushes into the mapping buffer
+	return odometryBuffer_.waitUntilSizeBelow(odometryBuffer_.size_limit() - 1, timeout)
+			&& mappingBuffer_.waitUntilSizeBelow(mappingBuffer_.size_limit() - 1, timeout);
+}
+
 std::pair<PointCloud, Time> SlamWrapper::getLatestRegisteredCloudTimestampPair() const {
-	if (registeredCloudBuffer_.empty()) {
+	RegisteredPointCloud c;
+	if (!registeredCloudBuffer_.tryPeekBack(&c)) {
 		return {PointCloud(),Time()};
 	}
-	RegisteredPointCloud c = registeredCloudBuffer_.peek_back();
 //	c.raw_.cloud_.Transform(c.transform_.matrix());
-	return {c.raw_.cloud_,c.raw_.time_};
+	return {*c.undistorted_,c.raw_.time_};
 }
 
 void SlamWrapper::finishProcessing() {
 	while (isRunWorkers_) {
-		if (!mappingBuffer_.empty()) {
+		if (!mappingBuffer_.waitUntilEmpty(std::chrono::milliseconds(200))) {
 			std::cout << "  Waiting for the mapping buffer to be emptied \n";
-			std::this_thread::sleep_for(std::chrono::milliseconds(200));
 			continue;
 		} else {
 			std::cout << "  Mapping buffer emptied \n";
@@ -154,10 +180,11 @@ void SlamWrapper::finishProcessing() {
 			break;
 		}
 		if (isOptimizedGraphAvailable_) {
-			isOptimizedGraphAvailable_ = false;
 			const auto poseBeforeUpdate = mapper_->getMapToRangeSensorBuffer().latest_measurement();
 			std::cout << "latest pose before update: \n " << asStringXYZRPY(poseBeforeUpdate.transform_) << "\n";
 			updateSubmapsAndTrajectory();
+			isOptimizedGraphAvailable_ = false;
+			wakeUpLoopClosureWorker();
 			const auto poseAfterUpdate = mapper_->getMapToRangeSensorBuffer().latest_measurement();
 			std::cout << "latest pose after update: \n " << asStringXYZRPY(poseAfterUpdate.transform_) << "\n";
 			if (params_.mapper_.isDumpSubmapsToFileBeforeAndAfterLoopClosures_) {
@@ -192,6 +219,13 @@ void SlamWrapper::loadParametersAndInitialize() {
 	mapper_ = std::make_shared<o3d_slam::Mapper>(odometry_->getBuffer(), submaps_);
 	mapper_->setParameters(params_.mapper_);
 
+	if (params_.mapper_.scanMatcher_.isReuseOdometryNormals_) {
+		// sized like the mapping buffer, the mapping can lag behind the odometry by that many scans
+		auto scanFeatureCache = std::make_shared<ScanFeatureCache>(mappingBuffer_.size_limit() + 1);
+		odometry_->setScanFeatureCache(scanFeatureCache);
+		mapper_->setScanFeatureCache(scanFeatureCache);
+	}
+
 	optimizationProblem_ = std::make_shared<o3d_slam::OptimizationProblem>();
 	optimizationProblem_->setParameters(params_.mapper_);
 
@@ -209,13 +243,52 @@ void SlamWrapper::loadParametersAndInitialize() {
 }
 
 void SlamWrapper::setInitialMap(const PointCloud &initialMap) {
-	TimestampedPointCloud measurement{fromUniversal(0), std::move(initialMap)};
+	PointCloud map = initialMap;
   {
 	  Timer t("initial map preparation");
-  	mapper_->getScanToMapRegistration().prepareInitialMap(&measurement.cloud_);
+  	mapper_->getScanToMapRegistration().prepareInitialMap(&map);
   }
   std::cout << "Initial map prepared! \n";
-	const bool mappingResult = mapper_->addRangeMeasurement(measurement.cloud_, measurement.time_);
+	insertInitialMap(map);
+}
+
+bool SlamWrapper::loadInitialMap(const std::string &filename) {
+	const std::string binaryMapSuffix = ".o3dmap";
+	const bool isBinaryMap = filename.size() >= binaryMapSuffix.size()
+			&& filename.compare(filename.size() - binaryMapSuffix.size(), binaryMapSuffix.size(), binaryMapSuffix) == 0;
+	if (!isBinaryMap) {
+		PointCloud map;
+		if (!open3d::io::ReadPointCloud(filename, map)) {
+			std::cerr << "[Error] Initialization pointcloud not loaded" << std::endl;
+			return false;
+		}
+		setInitialMap(map);
+		return true;
+	}
+
+	PointCloud map;
+	{
+		Timer t("initial map loading");
+		MapFileView mapFile;
+		if (!mapFile.open(filename)) {
+			std::cerr << "[Error] Initialization map " << filename << " not loaded" << std::endl;
+			return false;
+		}
+		map = mapFile.toAssembledPointCloud();
+	}
+	// the saved map carries the normals (covariances), estimate them only if they are missing
+	if (!mapper_->getScanToMapRegistration().isMergeScanValid(map)) {
+		setInitialMap(map);
+		return true;
+	}
+	insertInitialMap(map);
+	return true;
+}
+
+void SlamWrapper::insertInitialMap(const PointCloud &initialMap) {
+	// voxelizes the map and builds the map index, which dominates the startup for large maps
+	Timer t("initial map insertion");
+	const bool mappingResult = mapper_->addRangeMeasurement(initialMap, fromUniversal(0));
 	if (!mappingResult) {
 		std::cerr << "WARNING: mapping initialization has failed!!!! \n";
 	}
@@ -249,13 +322,32 @@ void SlamWrapper::startWorkers() {
 
 void SlamWrapper::stopWorkers(){
 	isRunWorkers_ = false;
+	odometryBuffer_.wakeUp();
+	mappingBuffer_.wakeUp();
+	registeredCloudBuffer_.wakeUp();
+	wakeUpLoopClosureWorker();
+}
+
+void SlamWrapper::wakeUpLoopClosureWorker() {
+	{
+		// taking the lock makes sure a worker that is about to wait does not miss the notification
+		std::lock_guard<std::mutex> lck(loopClosureWorkerMutex_);
+	}
+	loopClosureWorkerCondition_.notify_all();
 }
 
 bool SlamWrapper::saveMap(const std::string &directory) {
-	PointCloud map = mapper_->getAssembledMapPointCloud();
 	createDirectoryOrNoActionIfExists(directory);
 	const std::string filename = directory + "map.pcd";
-	return saveToFile(filename, map);
+	const bool savingResult = mapper_->getSubmaps().exportToFile(filename, false);
+	if (params_.saving_.isSaveBinaryMap_) {
+		return saveBinaryMap(directory) && savingResult;
+	}
+	return savingResult;
+}
+bool SlamWrapper::saveBinaryMap(const std::string &directory) {
+	createDirectoryOrNoActionIfExists(directory);
+	return mapper_->getSubmaps().saveToMapFile(directory + "map.o3dmap");
 }
 bool SlamWrapper::saveDenseSubmaps(const std::string &directory) {
 	return saveSubmaps(directory, true);
@@ -269,15 +361,18 @@ bool SlamWrapper::saveSubmaps(const std::string &directory, const bool& isDenseM
 
 void SlamWrapper::odometryWorker() {
 	while (isRunWorkers_) {
-		if (odometryBuffer_.empty()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		TimestampedPointCloud measurement;
+		if (!odometryBuffer_.waitAndPop(&measurement, workerWaitTimeout)) {
 			continue;
 		}
 		odometryStatisticsTimer_.startStopwatch();
-		const TimestampedPointCloud measurement = odometryBuffer_.pop();
-		auto undistortedCloud = motionCompensationOdom_->undistortInputPointCloud(measurement.cloud_, measurement.time_);
+		std::shared_ptr<const PointCloud> odometryCloud = measurement.cloud_;
+		if (params_.motionCompensation_.isUndistortInputCloud_) {
+			odometryCloud = motionCompensationOdom_->undistortInputPointCloud(*measurement.cloud_, measurement.time_,
+					*measurement.pointTimeOffsets_);
+		}
 
-		const auto isOdomOkay = odometry_->addRangeScan(*undistortedCloud, measurement.time_);
+		const auto isOdomOkay = odometry_->addRangeScan(*odometryCloud, measurement.time_);
 
 		// this ensures that the odom is always ahead of the mapping
 		// so then we can look stuff up in the interpolation buffer
@@ -303,20 +398,17 @@ void SlamWrapper::odometryWorker() {
 }
 void SlamWrapper::mappingWorker() {
 	while (isRunWorkers_) {
-		if (mappingBuffer_.empty()) {
+		TimestampedPointCloud measurement;
+		if (!mappingBuffer_.waitAndPop(&measurement, workerWaitTimeout)) {
+			// woken up by the loop closure worker or timed out
 			checkIfOptimizedGraphAvailable();
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
 			continue;
 		}
 		mappingStatisticsTimer_.startStopwatch();
-		TimestampedPointCloud measurement;
-		{
-			const TimestampedPointCloud raw = mappingBuffer_.pop();
-			auto undistortedCloud =
-					motionCompensationMap_->undistortInputPointCloud(raw.cloud_,
-							raw.time_);
-			measurement.time_ = raw.time_;
-			measurement.cloud_ = *undistortedCloud;
+		std::shared_ptr<const PointCloud> mappingCloud = measurement.cloud_;
+		if (params_.motionCompensation_.isUndistortInputCloud_) {
+			mappingCloud = motionCompensationMap_->undistortInputPointCloud(*measurement.cloud_, measurement.time_,
+					*measurement.pointTimeOffsets_);
 		}
 		if (!odometry_->getBuffer().has(measurement.time_)) {
 			std::cout << "Weird, the odom buffer does not seem to have the transform!!! \n";
@@ -329,7 +421,7 @@ void SlamWrapper::mappingWorker() {
 		}
 		const size_t activeSubmapIdx = mapper_->getActiveSubmap().getId();
 		mapperOnlyTimer_.startStopwatch();
-		const bool mappingResult = mapper_->addRangeMeasurement(measurement.cloud_, measurement.time_);
+		const bool mappingResult = mapper_->addRangeMeasurement(*mappingCloud, measurement.time_);
 		const double timeElapsed = 	mapperOnlyTimer_.elapsedMsecSinceStopwatchStart();
 		mapperOnlyTimer_.addMeasurementMsec(timeElapsed);
 
@@ -337,6 +429,7 @@ void SlamWrapper::mappingWorker() {
 			RegisteredPointCloud registeredCloud;
 			registeredCloud.submapId_ = activeSubmapIdx;
 			registeredCloud.raw_ = measurement;
+			registeredCloud.undistorted_ = mappingCloud;
 			registeredCloud.transform_ = mapper_->getMapToRangeSensor(measurement.time_);
 			registeredCloud.sourceFrame_ = frames::rangeSensorFrame;
 			registeredCloud.targetFrame_ = frames::mapFrame;
@@ -366,10 +459,11 @@ void SlamWrapper::mappingWorker() {
 
 void SlamWrapper::checkIfOptimizedGraphAvailable(){
 	if (isOptimizedGraphAvailable_) {
-		isOptimizedGraphAvailable_ = false;
 		const auto poseBeforeUpdate = mapper_->getMapToRangeSensorBuffer().latest_measurement();
 		std::cout << "latest pose before update: \n " << asStringXYZRPY(poseBeforeUpdate.transform_) << "\n";
 		updateSubmapsAndTrajectory();
+		isOptimizedGraphAvailable_ = false;
+		wakeUpLoopClosureWorker();
 		const auto poseAfterUpdate = mapper_->getMapToRangeSensorBuffer().latest_measurement();
 		std::cout << "latest pose after update: \n " << asStringXYZRPY(poseAfterUpdate.transform_) << "\n";
 		if (params_.mapper_.isDumpSubmapsToFileBeforeAndAfterLoopClosures_){
@@ -380,15 +474,13 @@ void SlamWrapper::checkIfOptimizedGraphAvailable(){
 
 void SlamWrapper::denseMapWorker() {
 	while (isRunWorkers_) {
-		if (registeredCloudBuffer_.empty()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		RegisteredPointCloud regCloud;
+		if (!registeredCloudBuffer_.waitAndPop(&regCloud, workerWaitTimeout)) {
 			continue;
 		}
 		denseMapStatiscticsTimer_.startStopwatch();
 
-		const RegisteredPointCloud regCloud = registeredCloudBuffer_.pop();
-
-		mapper_->getSubmapsPtr()->getSubmapPtr(regCloud.submapId_)->insertScanDenseMap(regCloud.raw_.cloud_,
+		mapper_->getSubmapsPtr()->getSubmapPtr(regCloud.submapId_)->insertScanDenseMap(*regCloud.undistorted_,
 					regCloud.transform_, regCloud.raw_.time_, true);
 
 		const double timeMeasurement = denseMapStatiscticsTimer_.elapsedMsecSinceStopwatchStart();
@@ -420,14 +512,20 @@ void SlamWrapper::attemptLoopClosuresIfReady() {
 		if (submaps_->numLoopClosureCandidates() > 0) {
 			const auto lcc = submaps_->popLoopClosureCandidates();
 			loopClosureCandidates_.insert(lcc.begin(), lcc.end());
+			wakeUpLoopClosureWorker();
 		}
 	}
 }
 void SlamWrapper::loopClosureWorker() {
 	while (isRunWorkers_) {
-		if (loopClosureCandidates_.empty() || isOptimizedGraphAvailable_) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(200));
-			continue;
+		{
+			std::unique_lock<std::mutex> lck(loopClosureWorkerMutex_);
+			const bool isReady = loopClosureWorkerCondition_.wait_for(lck, workerWaitTimeout, [this]() {
+				return !isRunWorkers_ || (!loopClosureCandidates_.empty() && !isOptimizedGraphAvailable_);
+			});
+			if (!isReady || !isRunWorkers_) {
+				continue;
+			}
 		}
 
 		Constraints loopClosureConstraints;
@@ -439,13 +537,11 @@ void SlamWrapper::loopClosureWorker() {
 		}
 
 		if (loopClosureConstraints.empty()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(200));
 			continue;
 		}
 		{
 			Timer t("optimization_problem");
-			auto odometryConstraints = submaps_->getOdometryConstraints();
-			computeOdometryConstraints(*submaps_, &odometryConstraints);
+			const auto odometryConstraints = submaps_->buildOdometryConstraints();
 
 //			optimizationProblem_->clearLoopClosureConstraints();
 			optimizationProblem_->clearOdometryConstraints();
@@ -462,6 +558,7 @@ void SlamWrapper::loopClosureWorker() {
 			//optimizationProblem_->print();
 			lastLoopClosureConstraints_ = loopClosureConstraints;
 			isOptimizedGraphAvailable_ = true;
+			mappingBuffer_.wakeUp();
 		}
 
 	} // end while
@@ -0,0 +1,223 @@
+/*
+ * StreamingPointCloudWriter.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/StreamingPointCloudWriter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace o3d_slam {
+
+namespace {
+const size_t kChunkSize = 1 << 16; // points
+const int kPointCountWidth = 12; // digits, zero padded so that it can be overwritten in place
+
+std::string paddedCount(size_t count) {
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%0*zu", kPointCountWidth, count);
+	return std::string(buffer);
+}
+
+bool hasSuffix(const std::string &str, const std::string &suffix) {
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+uint8 toColorByte(double c) {
+	return static_cast<uint8>(std::round(std::min(std::max(c, 0.0), 1.0) * 255.0));
+}
+
+template<typename T>
+char* append(const T &value, char *out) {
+	std::memcpy(out, &value, sizeof(T));
+	return out + sizeof(T);
+}
+
+char* appendVector(const Eigen::Vector3d &v, char *out) {
+	out = append(static_cast<float>(v.x()), out);
+	out = append(static_cast<float>(v.y()), out);
+	return append(static_cast<float>(v.z()), out);
+}
+} // namespace
+
+double StreamingPointCloudWriter::Statistics::getMegabytes() const {
+	return numBytes_ / (1024.0 * 1024.0);
+}
+
+double StreamingPointCloudWriter::Statistics::getMegabytesPerSecond() const {
+	return elapsedSec_ > 0.0 ? getMegabytes() / elapsedSec_ : 0.0;
+}
+
+StreamingPointCloudWriter::~StreamingPointCloudWriter() {
+	if (isOpen()) {
+		close();
+	}
+}
+
+bool StreamingPointCloudWriter::open(const std::string &filename, bool hasNormals, bool hasColors) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (hasSuffix(filename, ".pcd")) {
+		format_ = Format::Pcd;
+	} else if (hasSuffix(filename, ".ply")) {
+		format_ = Format::Ply;
+	} else {
+		std::cerr << "StreamingPointCloudWriter: unsupported file extension: " << filename << ", use .pcd or .ply \n";
+		return false;
+	}
+	file_.open(filename, std::ios::binary | std::ios::trunc);
+	if (!file_.is_open()) {
+		std::cerr << "StreamingPointCloudWriter: could not open: " << filename << "\n";
+		return false;
+	}
+	filename_ = filename;
+	hasNormals_ = hasNormals;
+	hasColors_ = hasColors;
+	isGood_ = true;
+	pointCountPositions_.clear();
+	numPoints_ = 0;
+	numBytes_ = 0;
+	startTime_ = std::chrono::steady_clock::now();
+	writeHeader();
+	return isGood_;
+}
+
+bool StreamingPointCloudWriter::isOpen() const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	return file_.is_open();
+}
+
+bool StreamingPointCloudWriter::write(const PointCloud &cloud) {
+	if (cloud.IsEmpty()) {
+		return true;
+	}
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		if (!file_.is_open()) {
+			return false;
+		}
+	}
+	std::string bytes;
+	const size_t nPoints = cloud.points_.size();
+	for (size_t begin = 0; begin < nPoints; begin += kChunkSize) {
+		const size_t end = std::min(begin + kChunkSize, nPoints);
+		serializeChunk(cloud, begin, end, &bytes);
+		std::lock_guard<std::mutex> lck(mutex_);
+		file_.write(bytes.data(), bytes.size());
+		isGood_ = isGood_ && file_.good();
+		numPoints_ += end - begin;
+		numBytes_ += bytes.size();
+	}
+	std::lock_guard<std::mutex> lck(mutex_);
+	return isGood_;
+}
+
+bool StreamingPointCloudWriter::close() {
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (!file_.is_open()) {
+		return false;
+	}
+	const std::string count = paddedCount(numPoints_);
+	for (const auto &pos : pointCountPositions_) {
+		file_.seekp(pos);
+		file_.write(count.data(), count.size());
+	}
+	file_.flush();
+	isGood_ = isGood_ && file_.good();
+	file_.close();
+	if (!isGood_) {
+		std::cerr << "StreamingPointCloudWriter: failed writing: " << filename_ << "\n";
+	}
+	return isGood_;
+}
+
+StreamingPointCloudWriter::Statistics StreamingPointCloudWriter::getStatistics() const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	Statistics stats;
+	stats.numPoints_ = numPoints_;
+	stats.numBytes_ = numBytes_;
+	stats.elapsedSec_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+	return stats;
+}
+
+void StreamingPointCloudWriter::writeHeader() {
+	if (format_ == Format::Pcd) {
+		std::string fields = "x y z", sizes = "4 4 4", types = "F F F", counts = "1 1 1";
+		if (hasNormals_) {
+			fields += " normal_x normal_y normal_z";
+			sizes += " 4 4 4";
+			types += " F F F";
+			counts += " 1 1 1";
+		}
+		if (hasColors_) {
+			fields += " rgb";
+			sizes += " 4";
+			types += " F";
+			counts += " 1";
+		}
+		file_ << "# .PCD v0.7 - Point Cloud Data file format\n" << "VERSION 0.7\n" << "FIELDS " << fields << "\n"
+				<< "SIZE " << sizes << "\n" << "TYPE " << types << "\n" << "COUNT " << counts << "\n" << "WIDTH ";
+		pointCountPositions_.push_back(file_.tellp());
+		file_ << paddedCount(0) << "\n" << "HEIGHT 1\n" << "VIEWPOINT 0 0 0 1 0 0 0\n" << "POINTS ";
+		pointCountPositions_.push_back(file_.tellp());
+		file_ << paddedCount(0) << "\n" << "DATA binary\n";
+	} else {
+		file_ << "ply\n" << "format binary_little_endian 1.0\n" << "comment open3d_slam map\n" << "element vertex ";
+		pointCountPositions_.push_back(file_.tellp());
+		file_ << paddedCount(0) << "\n" << "property float x\n" << "property float y\n" << "property float z\n";
+		if (hasNormals_) {
+			file_ << "property float nx\n" << "property float ny\n" << "property float nz\n";
+		}
+		if (hasColors_) {
+			file_ << "property uchar red\n" << "property uchar green\n" << "property uchar blue\n";
+		}
+		file_ << "end_header\n";
+	}
+	isGood_ = isGood_ && file_.good();
+}
+
+size_t StreamingPointCloudWriter::getPointSizeInBytes() const {
+	size_t size = 3 * sizeof(float);
+	if (hasNormals_) {
+		size += 3 * sizeof(float);
+	}
+	if (hasColors_) {
+		size += format_ == Format::Pcd ? sizeof(float) : 3 * sizeof(uint8);
+	}
+	return size;
+}
+
+void StreamingPointCloudWriter::serializeChunk(const PointCloud &cloud, size_t begin, size_t end,
+		std::string *bytes) const {
+	const bool isCopyNormals = hasNormals_ && cloud.HasNormals();
+	const bool isCopyColors = hasColors_ && cloud.HasColors();
+	const Eigen::Vector3d zero = Eigen::Vector3d::Zero();
+	bytes->resize((end - begin) * getPointSizeInBytes());
+	char *out = &(*bytes)[0];
+	for (size_t i = begin; i < end; ++i) {
+		out = appendVector(cloud.points_[i], out);
+		if (hasNormals_) {
+			out = appendVector(isCopyNormals ? cloud.normals_[i] : zero, out);
+		}
+		if (hasColors_) {
+			const Eigen::Vector3d &c = isCopyColors ? cloud.colors_[i] : zero;
+			const uint8 r = toColorByte(c.x()), g = toColorByte(c.y()), b = toColorByte(c.z());
+			if (format_ == Format::Pcd) {
+				// pcl packs rgb into the bits of a float
+				const uint32 rgb = (static_cast<uint32>(r) << 16) | (static_cast<uint32>(g) << 8) | static_cast<uint32>(b);
+				out = append(rgb, out);
+			} else {
+				out = append(r, out);
+				out = append(g, out);
+				out = append(b, out);
+			}
+		}
+	}
+}
+
+} // namespace o3d_slam
@@ -10,8 +10,11 @@
 #include "open3d_slam/assert.hpp"
 #include "open3d_slam/magic.hpp"
 #include "open3d_slam/typedefs.hpp"
+#include "open3d_slam/serialization.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <numeric>
 #include <utility>
@@ -21,7 +24,7 @@ namespace o3d_slam {
 
 namespace {
 namespace registration = open3d::pipelines::registration;
-const std::string voxelMapLayer = "layer";
+const VoxelMap::LayerId voxelMapLayer = 0;
 } // namespace
 
 Submap::Submap(size_t id, size_t parentId) :
@@ -45,20 +48,31 @@ bool Submap::insertScan(const PointCloud &rawScan, const PointCloud &preProcesse
 	}
 
 	mapToRangeSensor_ = mapToRangeSensor;
+	Transform submapToRangeSensor;
+	{
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		pageInMap();
+		submapToRangeSensor = mapToSubmap_.inverse() * mapToRangeSensor;
+	}
 
-	if (params_.isUseInitialMap_ && mapCloud_.IsEmpty()){
+	if (params_.isUseInitialMap_ && mapCloud_.empty()){
 		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
-		mapCloud_ = preProcessedScan;
-		voxelize(params_.mapBuilder_.mapVoxelSize_, &mapCloud_);
+		PointCloud initialMap = preProcessedScan;
+		initialMap.Transform(mapToSubmap_.inverse().matrix());
+		voxelize(params_.mapBuilder_.mapVoxelSize_, &initialMap);
+		mapCloud_.setCloud(std::move(initialMap));
+		rebuildMapIndex();
+		++mapRevision_;
 		return true;
 	}
 
-	auto transformedCloud = o3d_slam::transform(mapToRangeSensor.matrix(), preProcessedScan);
+	// the map cloud is kept in the submap frame
+	auto transformedCloud = o3d_slam::transform(submapToRangeSensor.matrix(), preProcessedScan);
 	if (isPerformCarving) {
 		carvingStatisticsTimer_.startStopwatch();
 		{
 			std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
-			carve(rawScan, mapToRangeSensor, *mapBuilderCropper_, params_.mapBuilder_.carving_, &mapCloud_);
+			carve(rawScan, submapToRangeSensor, *mapBuilderCropper_, params_.mapBuilder_.carving_);
 		}
 		const double timeMeasurement = carvingStatisticsTimer_.elapsedMsecSinceStopwatchStart();
 		carvingStatisticsTimer_.addMeasurementMsec(timeMeasurement);
@@ -70,10 +84,10 @@ bool Submap::insertScan(const PointCloud &rawScan, const PointCloud &preProcesse
 		}
 	}
 	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
-	mapCloud_ += *transformedCloud;
-	mapBuilderCropper_->setPose(mapToRangeSensor);
-	voxelizeInsideCroppingVolume(*mapBuilderCropper_, params_.mapBuilder_, &mapCloud_);
+	mapBuilderCropper_->setPose(submapToRangeSensor);
+	insertIntoMapCloud(*transformedCloud, *mapBuilderCropper_);
 	++nScansInsertedMap_;
+	++mapRevision_;
 	return true;
 }
 
@@ -84,68 +98,80 @@ bool Submap::insertScanDenseMap(const PointCloud &rawScan, const Transform &mapT
 	auto cropped = denseMapCropper_->crop(rawScan);
 	auto validColors = colorCropper_.crop(*cropped);
 	auto transformedCloud = o3d_slam::transform(mapToRangeSensor.matrix(), *validColors);
+	const SpaceCarvingParameters &carving = params_.denseMapBuilder_.carving_;
+	const bool isClearFreeSpace = isPerformCarving && nScansInsertedDenseMap_ % carving.carveSpaceEveryNscans_ == 0;
 	{
 		std::lock_guard<std::mutex> lck(denseMapMutex_);
-		denseMap_.insert(*transformedCloud);
-	}
-	if (isPerformCarving) {
-		std::lock_guard<std::mutex> lck(denseMapMutex_);
-		carve(rawScan, mapToRangeSensor.translation(), params_.denseMapBuilder_.carving_, &denseMap_);
+		pageInDenseMap();
+		applyPendingDenseMapTransform();
+		denseMap_.integrate(*transformedCloud, mapToRangeSensor.translation(), carving, isClearFreeSpace);
 	}
 	++nScansInsertedDenseMap_;
 	return true;
 }
 
 void Submap::transform(const Transform &T) {
-	const Eigen::Matrix4d mat(T.matrix());
-	sparseMapCloud_.Transform(mat);
+	// after a loop closure every submap gets moved, the map cloud and its index stay in the submap frame,
+	// the dense map is moved lazily, doing it here would stall the mapping thread
 	{
 		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
-		mapCloud_.Transform(mat);
-
+		mapToSubmap_ = T * mapToSubmap_;
 	}
 	{
 		std::lock_guard<std::mutex> lck(denseMapMutex_);
-		denseMap_.transform(T);
+		pendingDenseMapTransform_ = T * pendingDenseMapTransform_;
+		isDenseMapTransformPending_ = true;
 	}
 	mapToRangeSensor_ = mapToRangeSensor_ * T;
 	submapCenter_ = T * submapCenter_;
 }
 
-void Submap::carve(const PointCloud &rawScan, const Transform &mapToRangeSensor,
-		const CroppingVolume &cropper, const SpaceCarvingParameters &params, PointCloud *map) {
-	if (map->points_.empty() || !(nScansInsertedMap_ % params.carveSpaceEveryNscans_ == 1)) {
+void Submap::applyPendingDenseMapTransform() const {
+	if (!isDenseMapTransformPending_) {
+		return;
+	}
+	denseMap_.transform(pendingDenseMapTransform_);
+	pendingDenseMapTransform_.setIdentity();
+	isDenseMapTransformPending_ = false;
+}
+
+void Submap::carve(const PointCloud &rawScan, const Transform &submapToRangeSensor,
+		const CroppingVolume &cropper, const SpaceCarvingParameters &params) {
+	if (mapCloud_.empty() || nScansInsertedMap_ % params.carveSpaceEveryNscans_ != 0) {
 		return;
 	}
 //	Timer timer("carving");
-	auto scan = o3d_slam::transform(mapToRangeSensor.matrix(), rawScan);
+	auto scan = o3d_slam::transform(submapToRangeSensor.matrix(), rawScan);
 //	auto croppedScan = removeDuplicatePointsWithinSameVoxels(*scan, Eigen::Vector3d::Constant(params_.mapBuilder_.mapVoxelSize_));
-	const auto wideCroppedIdxs = cropper.getIndicesWithinVolume(*map);
+	const PointCloud &map = mapCloud_.getCloud();
+	const auto wideCroppedIdxs = cropper.getIndicesWithinVolume(map);
 	auto idxsToRemove = std::move(
-			getIdxsOfCarvedPoints(*scan, *map, mapToRangeSensor.translation(), wideCroppedIdxs, params));
-	toRemove_ = std::move(*(map->SelectByIndex(idxsToRemove)));
+			getIdxsOfCarvedPoints(*scan, map, submapToRangeSensor.translation(), wideCroppedIdxs, params));
+	toRemove_ = std::move(*(map.SelectByIndex(idxsToRemove)));
 	scanRef_ = std::move(*scan);
 //	std::cout << "Would remove: " << idxsToRemove.size() << std::endl;
-	removeByIds(idxsToRemove, map);
+	mapCloud_.remove(idxsToRemove);
+	if (isMaintainMapIndex_) {
+		mapIndex_.remove(toRemove_);
+	}
 }
 
-void Submap::carve(const PointCloud &scan, const Eigen::Vector3d &sensorPosition, const SpaceCarvingParameters &param, VoxelizedPointCloud *cloud){
-	if (cloud->empty() || !(nScansInsertedDenseMap_ % param.carveSpaceEveryNscans_ == 1)) {
-			return;
-		}
-	const PointCloudPtr croppedScanPtr = removeDuplicatePointsWithinSameVoxels(scan, Eigen::Vector3d::Constant(params_.denseMapBuilder_.mapVoxelSize_));
-	std::vector<Eigen::Vector3i> keysToRemove = getKeysOfCarvedPoints(*croppedScanPtr, *cloud, sensorPosition, param);
-	for (const auto &k : keysToRemove){
-		cloud->removeKey(k);
+void Submap::insertIntoMapCloud(const PointCloud &transformedScan, const CroppingVolume &cropper) {
+	if (!isMaintainMapIndex_) {
+		mapCloud_.insert(transformedScan, cropper, nullptr, nullptr);
+		return;
 	}
+	PointCloud removedPoints, addedPoints;
+	mapCloud_.insert(transformedScan, cropper, &removedPoints, &addedPoints);
+	mapIndex_.remove(removedPoints);
+	mapIndex_.insert(addedPoints);
 }
 
-void Submap::voxelizeInsideCroppingVolume(const CroppingVolume &cropper, const MapBuilderParameters &param,
-		PointCloud *map) const {
-	if (param.mapVoxelSize_ > 0.0) {
-		//			Timer timer("voxelize_map",true);
-		auto voxelizedMap = voxelizeWithinCroppingVolume(param.mapVoxelSize_, cropper, *map);
-		*map = *voxelizedMap;
+void Submap::rebuildMapIndex() const {
+	if (isMaintainMapIndex_) {
+		mapIndex_.build(mapCloud_.getCloud());
+	} else {
+		mapIndex_.clear();
 	}
 }
 
@@ -166,8 +192,10 @@ Submap::Submap(const Submap &other) :
   isCenterComputed_ = other.isCenterComputed_;
   id_ = other.id_;
   feature_ = other.feature_;
+  scanContext_ = other.scanContext_;
   nScansInsertedDenseMap_ = other.nScansInsertedDenseMap_;
   nScansInsertedMap_ = other.nScansInsertedMap_;
+  mapRevision_ = other.mapRevision_;
   featureTimer_ = other.featureTimer_;
   params_ = other.params_;
   denseMapCropper_ = other.denseMapCropper_;
@@ -177,48 +205,116 @@ Submap::Submap(const Submap &other) :
   mapToSubmap_ = other.mapToSubmap_;
   mapCloud_ = other.mapCloud_;
   sparseMapCloud_ = other.sparseMapCloud_;
+  isMaintainMapIndex_ = other.isMaintainMapIndex_;
+  mapIndex_ = other.mapIndex_;
+  pendingDenseMapTransform_ = other.pendingDenseMapTransform_;
+  isDenseMapTransformPending_ = other.isDenseMapTransformPending_;
+  pageFilePrefix_ = other.pageFilePrefix_;
+  isMapPagedOut_ = other.isMapPagedOut_;
+  isDenseMapPagedOut_ = other.isDenseMapPagedOut_;
+  numMapPointsPagedOut_ = other.numMapPointsPagedOut_;
+  isPagedOutMapHasNormals_ = other.isPagedOutMapHasNormals_;
+  isPagedOutMapHasColors_ = other.isPagedOutMapHasColors_;
+  isPagedOutDenseMapHasNormals_ = other.isPagedOutDenseMapHasNormals_;
+  isPagedOutDenseMapHasColors_ = other.isPagedOutDenseMapHasColors_;
+  lastAccessTime_ = other.lastAccessTime_.load();
 
 //	update(params_);
 }
 
-const Transform& Submap::getMapToSubmapOrigin() const {
+Transform Submap::getMapToSubmapOrigin() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
 	return mapToSubmap_;
 }
 
 Eigen::Vector3d Submap::getMapToSubmapCenter() const {
-	return isCenterComputed_ ? submapCenter_ : mapToSubmap_.translation();
+	return isCenterComputed_ ? submapCenter_ : getMapToSubmapOrigin().translation();
 }
 
 const Submap::PointCloud& Submap::getMapPointCloud() const {
-	return mapCloud_;
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	pageInMap();
+	return mapCloud_.getCloud();
 }
 PointCloud Submap::getMapPointCloudCopy() const {
 	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
-	auto copy = mapCloud_;
-	return std::move(copy);
+	PointCloud copy;
+	if (isMapPagedOut_) {
+		// read straight from the page, assembling the whole map should not pull every submap back into RAM
+		readMapPage(&copy, nullptr, nullptr);
+	} else {
+		copy = mapCloud_.getCloud();
+	}
+	copy.Transform(mapToSubmap_.matrix());
+	return copy;
 }
-const VoxelizedPointCloud& Submap::getDenseMap() const {
+const OccupancyVoxelMap& Submap::getDenseMap() const {
+	std::lock_guard<std::mutex> lck(denseMapMutex_);
+	pageInDenseMap();
+	applyPendingDenseMapTransform();
 	return denseMap_;
 }
 
-VoxelizedPointCloud Submap::getDenseMapCopy() const {
+OccupancyVoxelMap Submap::getDenseMapCopy() const {
 	std::lock_guard<std::mutex> lck(denseMapMutex_);
-	auto copy = denseMap_;
-	return std::move(copy);
+	OccupancyVoxelMap copy;
+	if (isDenseMapPagedOut_) {
+		readDenseMapPage(&copy);
+	} else {
+		copy = denseMap_;
+	}
+	if (isDenseMapTransformPending_) {
+		copy.transform(pendingDenseMapTransform_);
+	}
+	return copy;
 }
 
 const Submap::PointCloud& Submap::getSparseMapPointCloud() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	pageInMap();
 	return sparseMapCloud_;
 }
 
+bool Submap::getSparseMapAndFeaturesCopy(PointCloud *sparse, Feature *feature) const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	if (feature_ == nullptr) {
+		return false;
+	}
+	if (isMapPagedOut_) {
+		PointCloud map;
+		if (!readMapPage(&map, sparse, feature)) {
+			std::cerr << "Submap " << id_ << ": failed to read " << pageFilePrefix_ << "_map.bin \n";
+			sparse->Clear();
+			*feature = Feature();
+			return false;
+		}
+	} else {
+		*sparse = sparseMapCloud_;
+		*feature = *feature_;
+	}
+	sparse->Transform(mapToSubmap_.matrix());
+	return true;
+}
+
 void Submap::setMapToSubmapOrigin(const Transform &T) {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
 	mapToSubmap_ = T;
 }
 
 void Submap::update(const MapperParameters &p) {
 	mapBuilderCropper_ = croppingVolumeFactory(p.mapBuilder_.cropper_);
 	denseMapCropper_ = croppingVolumeFactory(p.denseMapBuilder_.cropper_);
-	denseMap_ = std::move(VoxelizedPointCloud(Eigen::Vector3d::Constant(p.denseMapBuilder_.mapVoxelSize_)));
+	denseMap_ = OccupancyVoxelMap(Eigen::Vector3d::Constant(p.denseMapBuilder_.mapVoxelSize_));
+	{
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		mapCloud_.setVoxelSize(p.mapBuilder_.mapVoxelSize_);
+	}
+	const bool isMaintainMapIndex = p.scanMatcher_.scanToMapRegType_ != ScanToMapRegistrationType::GeneralizedIcp;
+	if (isMaintainMapIndex != isMaintainMapIndex_) {
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		isMaintainMapIndex_ = isMaintainMapIndex;
+		rebuildMapIndex();
+	}
 
 	//todo remove magic
 	voxelMap_ = std::move(
@@ -228,11 +324,34 @@ void Submap::update(const MapperParameters &p) {
 }
 
 bool Submap::isEmpty() const {
-	return mapCloud_.points_.empty();
+	return getNumMapPoints() == 0;
+}
+
+size_t Submap::getNumMapPoints() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	return isMapPagedOut_ ? numMapPointsPagedOut_ : mapCloud_.size();
 }
 
-const VoxelMap& Submap::getVoxelMap() const {
-	return voxelMap_;
+size_t Submap::getNumPointsInVoxelMap(const PointCloud &cloud, const Transform &mapToCloud) const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	pageInMap();
+	const Transform submapToCloud = mapToSubmap_.inverse() * mapToCloud;
+	size_t numPoints = 0;
+	for (const auto &p : cloud.points_) {
+		numPoints += voxelMap_.hasVoxelContainingPoint(submapToCloud * p) ? 1 : 0;
+	}
+	return numPoints;
+}
+
+const IncrementalKdTree& Submap::getMapIndex() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	pageInMap();
+	return mapIndex_;
+}
+
+size_t Submap::getMapRevision() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	return mapRevision_;
 }
 
 void Submap::computeFeatures() {
@@ -241,34 +360,226 @@ void Submap::computeFeatures() {
 		return;
 	}
 
-	std::thread computeVoxelMapThread([this]() {
+	isComputingFeatures_ = true;
+	// runs next to the mapping thread, which might be using this submap, hence it works on a copy. The
+	// voxel map and the sparse cloud are in the submap frame, a loop closure meanwhile does not touch them.
+	PointCloud mapCopy;
+	Transform mapToSubmapAtCopy;
+	Eigen::Vector3d voxelMapVoxelSize;
+	{
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		pageInMap();
+		mapCopy = mapCloud_.getCloud();
+		mapToSubmapAtCopy = mapToSubmap_;
+		voxelMapVoxelSize = voxelMap_.getVoxelSize();
+	}
+	// built aside and swapped in under the lock, the mapping thread reads the voxel map meanwhile
+	VoxelMap voxelMap(voxelMapVoxelSize);
+	std::thread computeVoxelMapThread([&voxelMap, &mapCopy]() {
 //		Timer t("compute_voxel_submap");
-		voxelMap_.clear();
-		voxelMap_.insertCloud(voxelMapLayer,mapCloud_);
+		voxelMap.insertCloud(voxelMapLayer, mapCopy);
 	});
 
-	auto mapCopy = getMapPointCloudCopy();
 	const auto &p = params_.placeRecognition_;
-	sparseMapCloud_ = *(mapCopy.VoxelDownSample(p.featureVoxelSize_));
-	sparseMapCloud_.EstimateNormals(
+	PointCloud sparseMapCloud = *(mapCopy.VoxelDownSample(p.featureVoxelSize_));
+	sparseMapCloud.EstimateNormals(
 			open3d::geometry::KDTreeSearchParamHybrid(p.normalEstimationRadius_, p.normalKnn_));
-	sparseMapCloud_.NormalizeNormals();
-	sparseMapCloud_.OrientNormalsTowardsCameraLocation(Eigen::Vector3d::Zero());
-	feature_ = registration::ComputeFPFHFeature(sparseMapCloud_,
+	sparseMapCloud.NormalizeNormals();
+	// towards the map origin
+	sparseMapCloud.OrientNormalsTowardsCameraLocation(mapToSubmapAtCopy.inverse().translation());
+	auto feature = registration::ComputeFPFHFeature(sparseMapCloud,
 			open3d::geometry::KDTreeSearchParamHybrid(p.featureRadius_, p.featureKnn_));
+	ScanContext scanContext;
+	if (p.globalDescriptor_.isUseGlobalDescriptor_) {
+		scanContext = ScanContext(p.globalDescriptor_);
+		// the descriptor is not rotation invariant, it is computed in the map frame
+		const PointCloud mapCopyInMapFrame = *o3d_slam::transform(mapToSubmapAtCopy.matrix(), mapCopy);
+		scanContext.compute(mapCopyInMapFrame, getMapToSubmapCenter());
+	}
 	computeVoxelMapThread.join();
+	{
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		sparseMapCloud_ = std::move(sparseMapCloud);
+		feature_ = std::move(feature);
+		scanContext_ = std::move(scanContext);
+		voxelMap_ = std::move(voxelMap);
+		isComputingFeatures_ = false;
+	}
 	featureTimer_.reset();
 }
 
 const Submap::Feature& Submap::getFeatures() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	pageInMap();
 	assert_nonNullptr(feature_, "Feature ptr is nullptr");
 	return *feature_;
 }
 
+bool Submap::hasFeatures() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	return feature_ != nullptr;
+}
+
+ScanContext Submap::getScanContext() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	return scanContext_;
+}
+
 void Submap::computeSubmapCenter() {
 	auto mapCopy = getMapPointCloudCopy();
 	submapCenter_ = mapCopy.GetCenter();
 	isCenterComputed_ = true;
 }
 
+bool Submap::pageOut(const std::string &filePrefix) {
+	{
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		// the features being computed would be stored next to a stale page
+		if (isComputingFeatures_) {
+			return false;
+		}
+		if (!isMapPagedOut_) {
+			std::ofstream out(filePrefix + "_map.bin", std::ios::binary | std::ios::trunc);
+			serialize(mapCloud_.getCloud(), &out);
+			serialize(sparseMapCloud_, &out);
+			const uint8 isHasFeature = feature_ != nullptr;
+			out.write(reinterpret_cast<const char*>(&isHasFeature), sizeof(isHasFeature));
+			if (isHasFeature) {
+				serialize(*feature_, &out);
+			}
+			if (!out) {
+				std::cerr << "Submap " << id_ << ": failed to page out the map to " << filePrefix << "_map.bin \n";
+				return false;
+			}
+			pageFilePrefix_ = filePrefix;
+			numMapPointsPagedOut_ = mapCloud_.size();
+			isPagedOutMapHasNormals_ = mapCloud_.getCloud().HasNormals();
+			isPagedOutMapHasColors_ = mapCloud_.getCloud().HasColors();
+			// swap with empty objects, clear() would keep the memory
+			mapCloud_ = VoxelizedMapCloud(mapCloud_.getVoxelSize());
+			sparseMapCloud_ = PointCloud();
+			if (isHasFeature) {
+				feature_ = std::make_shared<Feature>();
+			}
+			voxelMap_ = VoxelMap(voxelMap_.getVoxelSize());
+			mapIndex_ = IncrementalKdTree();
+			isMapPagedOut_ = true;
+		}
+	}
+	std::lock_guard<std::mutex> lck(denseMapMutex_);
+	if (!isDenseMapPagedOut_) {
+		std::ofstream out(filePrefix + "_dense_map.bin", std::ios::binary | std::ios::trunc);
+		serialize(denseMap_, &out);
+		if (!out) {
+			std::cerr << "Submap " << id_ << ": failed to page out the dense map to " << filePrefix
+					<< "_dense_map.bin \n";
+			return false;
+		}
+		pageFilePrefix_ = filePrefix;
+		isPagedOutDenseMapHasNormals_ = denseMap_.hasNormals();
+		isPagedOutDenseMapHasColors_ = denseMap_.hasColors();
+		denseMap_ = OccupancyVoxelMap(denseMap_.getVoxelSize());
+		isDenseMapPagedOut_ = true;
+	}
+	return true;
+}
+
+void Submap::getMapFields(bool isDenseMap, bool *hasNormals, bool *hasColors) const {
+	if (isDenseMap) {
+		std::lock_guard<std::mutex> lck(denseMapMutex_);
+		*hasNormals = isDenseMapPagedOut_ ? isPagedOutDenseMapHasNormals_ : denseMap_.hasNormals();
+		*hasColors = isDenseMapPagedOut_ ? isPagedOutDenseMapHasColors_ : denseMap_.hasColors();
+		return;
+	}
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	*hasNormals = isMapPagedOut_ ? isPagedOutMapHasNormals_ : mapCloud_.getCloud().HasNormals();
+	*hasColors = isMapPagedOut_ ? isPagedOutMapHasColors_ : mapCloud_.getCloud().HasColors();
+}
+
+bool Submap::isPagedOut() const {
+	std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+	return isMapPagedOut_;
+}
+
+void Submap::pageInMap() const {
+	if (!isMapPagedOut_) {
+		touch();
+		return;
+	}
+	const bool isHadFeature = feature_ != nullptr;
+	auto feature = std::make_shared<Feature>();
+	PointCloud map;
+	if (!readMapPage(&map, &sparseMapCloud_, feature.get())) {
+		throw std::runtime_error("Submap " + std::to_string(id_) + ": failed to page in " + pageFilePrefix_ + "_map.bin");
+	}
+	mapCloud_.setCloud(std::move(map));
+	if (isHadFeature) {
+		feature_ = feature;
+		voxelMap_.insertCloud(voxelMapLayer, mapCloud_.getCloud());
+	}
+	rebuildMapIndex();
+	isMapPagedOut_ = false;
+	touch();
+}
+
+void Submap::pageInDenseMap() const {
+	if (!isDenseMapPagedOut_) {
+		touch();
+		return;
+	}
+	if (!readDenseMapPage(&denseMap_)) {
+		throw std::runtime_error(
+				"Submap " + std::to_string(id_) + ": failed to page in " + pageFilePrefix_ + "_dense_map.bin");
+	}
+	isDenseMapPagedOut_ = false;
+	touch();
+}
+
+bool Submap::readMapPage(PointCloud *map, PointCloud *sparse, Feature *feature) const {
+	std::ifstream in(pageFilePrefix_ + "_map.bin", std::ios::binary);
+	if (!deserialize(in, map)) {
+		return false;
+	}
+	if (sparse == nullptr) {
+		return true;
+	}
+	uint8 isHasFeature = 0;
+	if (!deserialize(in, sparse) || !in.read(reinterpret_cast<char*>(&isHasFeature), sizeof(isHasFeature))) {
+		return false;
+	}
+	return feature == nullptr || !isHasFeature || deserialize(in, feature);
+}
+
+bool Submap::readDenseMapPage(OccupancyVoxelMap *denseMap) const {
+	std::ifstream in(pageFilePrefix_ + "_dense_map.bin", std::ios::binary);
+	return deserialize(in, denseMap);
+}
+
+void Submap::touch() const {
+	lastAccessTime_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64 Submap::getLastAccessTime() const {
+	return lastAccessTime_;
+}
+
+size_t Submap::getMemoryFootprint() const {
+	auto cloudBytes = [](const PointCloud &cloud) {
+		return (cloud.points_.capacity() + cloud.normals_.capacity() + cloud.colors_.capacity())
+				* sizeof(Eigen::Vector3d);
+	};
+	size_t bytes = 0;
+	{
+		std::lock_guard<std::mutex> lck(mapPointCloudMutex_);
+		bytes += mapCloud_.getMemoryFootprint() + cloudBytes(sparseMapCloud_);
+		bytes += feature_ != nullptr ? feature_->data_.size() * sizeof(double) : 0;
+		bytes += voxelMap_.size() * (sizeof(Eigen::Vector3i) + sizeof(VoxelWithIdxs)) + mapCloud_.size() * sizeof(size_t);
+		bytes += mapIndex_.size() * sizeof(IncrementalKdTree::Neighbor);
+	}
+	std::lock_guard<std::mutex> lck(denseMapMutex_);
+	bytes += denseMap_.size() * (sizeof(Eigen::Vector3i) + sizeof(AggregatedVoxel));
+	return bytes;
+}
+
 } // namespace o3d_slam
@@ -0,0 +1,210 @@
+/*
+ * SubmapCenterIndex.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/SubmapCenterIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace o3d_slam {
+
+SubmapCenterIndex::SubmapCenterIndex(double cellSize) :
+		cellSize_(cellSize), inverseCellSize_(fromVoxelSize(Eigen::Vector3d::Constant(cellSize))) {
+}
+
+Eigen::Vector3i SubmapCenterIndex::getCellKey(const Eigen::Vector3d &p) const {
+	return getVoxelIdx(p, inverseCellSize_);
+}
+
+void SubmapCenterIndex::setCellSize(double cellSize) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (cellSize == cellSize_) {
+		return;
+	}
+	cellSize_ = cellSize;
+	inverseCellSize_ = fromVoxelSize(Eigen::Vector3d::Constant(cellSize));
+	cells_.clear();
+	numIndexed_ = 0;
+	for (size_t i = 0; i < centers_.size(); ++i) {
+		if (isIndexed_[i]) {
+			insertIntoCell(i);
+		}
+	}
+}
+
+void SubmapCenterIndex::update(size_t submapIdx, const Eigen::Vector3d &center) {
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (submapIdx >= centers_.size()) {
+		centers_.resize(submapIdx + 1, Eigen::Vector3d::Zero());
+		isIndexed_.resize(submapIdx + 1, 0);
+	}
+	if (isIndexed_[submapIdx]) {
+		if (getCellKey(center) == getCellKey(centers_[submapIdx])) {
+			centers_[submapIdx] = center;
+			return;
+		}
+		removeFromCell(submapIdx);
+	}
+	centers_[submapIdx] = center;
+	insertIntoCell(submapIdx);
+}
+
+void SubmapCenterIndex::insertIntoCell(size_t submapIdx) {
+	const Eigen::Vector3i key = getCellKey(centers_[submapIdx]);
+	cells_[key].push_back(submapIdx);
+	if (numIndexed_ == 0) {
+		minKey_ = key;
+		maxKey_ = key;
+	} else {
+		minKey_ = minKey_.cwiseMin(key);
+		maxKey_ = maxKey_.cwiseMax(key);
+	}
+	isIndexed_[submapIdx] = 1;
+	++numIndexed_;
+}
+
+void SubmapCenterIndex::removeFromCell(size_t submapIdx) {
+	const Eigen::Vector3i key = getCellKey(centers_[submapIdx]);
+	auto search = cells_.find(key);
+	if (search != cells_.end()) {
+		std::vector<size_t> &idxs = search->second;
+		idxs.erase(std::remove(idxs.begin(), idxs.end(), submapIdx), idxs.end());
+		if (idxs.empty()) {
+			cells_.erase(key);
+		}
+	}
+	isIndexed_[submapIdx] = 0;
+	--numIndexed_;
+}
+
+void SubmapCenterIndex::clear() {
+	std::lock_guard<std::mutex> lck(mutex_);
+	cells_.clear();
+	centers_.clear();
+	isIndexed_.clear();
+	numIndexed_ = 0;
+}
+
+size_t SubmapCenterIndex::size() const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	return numIndexed_;
+}
+
+void SubmapCenterIndex::findNearestInCell(const Eigen::Vector3i &key, const Eigen::Vector3d &query, size_t *best,
+		double *bestSquaredDistance) const {
+	const auto search = cells_.find(key);
+	if (search == cells_.end()) {
+		return;
+	}
+	for (const size_t idx : search->second) {
+		const double squaredDistance = (centers_[idx] - query).squaredNorm();
+		if (squaredDistance < *bestSquaredDistance || (squaredDistance == *bestSquaredDistance && idx < *best)) {
+			*best = idx;
+			*bestSquaredDistance = squaredDistance;
+		}
+	}
+}
+
+void SubmapCenterIndex::findNearestLinear(const Eigen::Vector3d &query, size_t *best,
+		double *bestSquaredDistance) const {
+	for (size_t idx = 0; idx < centers_.size(); ++idx) {
+		if (!isIndexed_[idx]) {
+			continue;
+		}
+		const double squaredDistance = (centers_[idx] - query).squaredNorm();
+		if (squaredDistance < *bestSquaredDistance || (squaredDistance == *bestSquaredDistance && idx < *best)) {
+			*best = idx;
+			*bestSquaredDistance = squaredDistance;
+		}
+	}
+}
+
+bool SubmapCenterIndex::findNearest(const Eigen::Vector3d &query, size_t *submapIdx, double *distance) const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (numIndexed_ == 0) {
+		return false;
+	}
+	size_t best = 0;
+	double bestSquaredDistance = std::numeric_limits<double>::infinity();
+	const Eigen::Vector3i key = getCellKey(query);
+	size_t numVisitedCells = 0;
+	for (int r = 0;; ++r) {
+		if (numVisitedCells > numIndexed_) {
+			findNearestLinear(query, &best, &bestSquaredDistance);
+			break;
+		}
+		// cells at chebyshev distance r from the query cell
+		for (int dx = -r; dx <= r; ++dx) {
+			for (int dy = -r; dy <= r; ++dy) {
+				const bool isOnShell = std::abs(dx) == r || std::abs(dy) == r;
+				const int dzStep = isOnShell ? 1 : std::max(2 * r, 1);
+				for (int dz = -r; dz <= r; dz += dzStep) {
+					findNearestInCell(key + Eigen::Vector3i(dx, dy, dz), query, &best, &bestSquaredDistance);
+					++numVisitedCells;
+				}
+			}
+		}
+		// everything outside of the searched cells is at least r cells away
+		const double searchedRadius = r * cellSize_;
+		const bool isCoveredAllCells = (key.array() - r <= minKey_.array()).all()
+				&& (key.array() + r >= maxKey_.array()).all();
+		if (bestSquaredDistance <= searchedRadius * searchedRadius || isCoveredAllCells) {
+			break;
+		}
+	}
+	*submapIdx = best;
+	if (distance != nullptr) {
+		*distance = std::sqrt(bestSquaredDistance);
+	}
+	return true;
+}
+
+std::vector<size_t> SubmapCenterIndex::findWithinRadius(const Eigen::Vector3d &query, double radius) const {
+	std::lock_guard<std::mutex> lck(mutex_);
+	std::vector<size_t> idxs;
+	if (numIndexed_ == 0 || radius < 0.0) {
+		return idxs;
+	}
+	const double squaredRadius = radius * radius;
+	const auto addIfWithinRadius = [&](size_t idx) {
+		if ((centers_[idx] - query).squaredNorm() <= squaredRadius) {
+			idxs.push_back(idx);
+		}
+	};
+	const Eigen::Vector3i minKey = getCellKey(query - Eigen::Vector3d::Constant(radius)).cwiseMax(minKey_);
+	const Eigen::Vector3i maxKey = getCellKey(query + Eigen::Vector3d::Constant(radius)).cwiseMin(maxKey_);
+	if ((minKey.array() > maxKey.array()).any()) {
+		return idxs;
+	}
+	const Eigen::Vector3d numCells = (maxKey - minKey).cast<double>().array() + 1.0;
+	if (numCells.prod() > numIndexed_) {
+		for (size_t idx = 0; idx < centers_.size(); ++idx) {
+			if (isIndexed_[idx]) {
+				addIfWithinRadius(idx);
+			}
+		}
+		return idxs;
+	}
+	for (int x = minKey.x(); x <= maxKey.x(); ++x) {
+		for (int y = minKey.y(); y <= maxKey.y(); ++y) {
+			for (int z = minKey.z(); z <= maxKey.z(); ++z) {
+				const auto search = cells_.find(Eigen::Vector3i(x, y, z));
+				if (search == cells_.end()) {
+					continue;
+				}
+				for (const size_t idx : search->second) {
+					addIfWithinRadius(idx);
+				}
+			}
+		}
+	}
+	std::sort(idxs.begin(), idxs.end());
+	return idxs;
+}
+
+} // namespace o3d_slam
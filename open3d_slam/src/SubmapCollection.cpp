@@ -13,14 +13,20 @@
 #include "open3d_slam/magic.hpp"
 #include "open3d_slam/output.hpp"
 #include "open3d_slam/constraint_builders.hpp"
+#include "open3d_slam/MapFile.hpp"
+#include "open3d_slam/StreamingPointCloudWriter.hpp"
 
 #include <open3d/io/PointCloudIO.h>
 #include <open3d/pipelines/registration/Registration.h>
 
 #include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
 #include <numeric>
 #include <utility>
 #include <set>
+#include <sstream>
 #include <thread>
 
 namespace o3d_slam {
@@ -31,6 +37,17 @@ SubmapCollection::SubmapCollection() {
 	overlapScansBuffer_.set_size_limit(5);
 }
 
+SubmapCollection::~SubmapCollection() {
+	if (!params_.submaps_.isPageOutToDisk_) {
+		return;
+	}
+	for (size_t i = 0; i < submaps_.size(); ++i) {
+		const std::string prefix = getPageFilePrefix(i);
+		std::remove((prefix + "_map.bin").c_str());
+		std::remove((prefix + "_dense_map.bin").c_str());
+	}
+}
+
 void SubmapCollection::setMapToRangeSensor(const Transform &T) {
 	mapToRangeSensor_ = T;
 }
@@ -68,8 +85,14 @@ size_t SubmapCollection::numLoopClosureCandidates() const {
 
 size_t SubmapCollection::getTotalNumPoints() const {
 	const int nSubmaps = submaps_.size();
-	return std::accumulate(submaps_.begin(), submaps_.end(), 0, [](size_t sum, const Submap &s) {
-		return sum + s.getMapPointCloud().points_.size();
+	return std::accumulate(submaps_.begin(), submaps_.end(), size_t(0), [](size_t sum, const Submap &s) {
+		return sum + s.getNumMapPoints();
+	});
+}
+
+size_t SubmapCollection::getMemoryFootprint() const {
+	return std::accumulate(submaps_.begin(), submaps_.end(), size_t(0), [](size_t sum, const Submap &s) {
+		return sum + s.getMemoryFootprint();
 	});
 }
 
@@ -87,8 +110,8 @@ void SubmapCollection::addScanToBuffer(const PointCloud &scan, const Transform &
 }
 
 void SubmapCollection::insertBufferedScans(Submap *submap) {
-	while (!overlapScansBuffer_.empty()) {
-		auto scan = overlapScansBuffer_.pop();
+	ScanTimeTransform scan;
+	while (overlapScansBuffer_.tryPop(&scan)) {
 		submap->insertScan(scan.cloud_, scan.cloud_, scan.mapToRangeSensor_, scan.timestamp_, false);
 	}
 }
@@ -141,6 +164,7 @@ void SubmapCollection::createNewSubmap(const Transform &mapToSubmap) {
 	newSubmap.setParameters(params_);
 	submaps_.emplace_back(std::move(newSubmap));
 	activeSubmapIdx_ = submaps_.size() - 1;
+	submapCenterIndex_.update(activeSubmapIdx_, submaps_.at(activeSubmapIdx_).getMapToSubmapCenter());
 	numScansMergedInActiveSubmap_ = 0;
 	std::cout << "Created submap: " << activeSubmapIdx_ << " with parent " << submapParentId << std::endl;
 //	std::cout << "Submap " << activeSubmapIdx_ << " pose: " << asString(newSubmap.getMapToSubmapOrigin())
@@ -148,16 +172,9 @@ void SubmapCollection::createNewSubmap(const Transform &mapToSubmap) {
 }
 
 size_t SubmapCollection::findClosestSubmap(const Transform &mapToRangeSensor) const {
-
-	std::vector<size_t> idxs(submaps_.size());
-	std::iota(idxs.begin(), idxs.end(), 0);
-	auto lessThan = [this, &mapToRangeSensor](size_t idxa, size_t idxb) {
-		const auto p0 = mapToRangeSensor.translation();
-		const auto pa = submaps_.at(idxa).getMapToSubmapCenter();
-		const auto pb = submaps_.at(idxb).getMapToSubmapCenter();
-		return (p0 - pa).norm() < (p0 - pb).norm();
-	};
-	return *(std::min_element(idxs.begin(), idxs.end(), lessThan));
+	size_t closestIdx = activeSubmapIdx_;
+	submapCenterIndex_.findNearest(mapToRangeSensor.translation(), &closestIdx, nullptr);
+	return closestIdx;
 }
 
 const Submap& SubmapCollection::getActiveSubmap() const {
@@ -193,6 +210,7 @@ bool SubmapCollection::insertScan(const PointCloud &rawScan, const PointCloud &p
 		std::lock_guard<std::mutex> lck(featureComputationMutex_);
 		submaps_.at(prevActiveSubmapIdx).insertScan(rawScan, preProcessedScan, mapToRangeSensor, timestamp, true);
 		submaps_.at(prevActiveSubmapIdx).computeSubmapCenter();
+		submapCenterIndex_.update(prevActiveSubmapIdx, submaps_.at(prevActiveSubmapIdx).getMapToSubmapCenter());
 		std::cout << "Active submap changed from " << prevActiveSubmapIdx << " to " << activeSubmapIdx_ << "\n";
 		lastFinishedSubmapIdx_ = prevActiveSubmapIdx;
 		TimestampedSubmapId timestampedId { prevActiveSubmapIdx, timestamp };
@@ -204,6 +222,7 @@ bool SubmapCollection::insertScan(const PointCloud &rawScan, const PointCloud &p
 //		std::cout << "Adding edge between " << id1 << " and " << id2 << std::endl;
 		insertBufferedScans(&submaps_.at(activeSubmapIdx_));
 		assert_true(!submaps_.at(activeSubmapIdx_).isEmpty(), "submap should not be empty after switching");
+		pageOutSubmaps();
 	} else {
 		submaps_.at(activeSubmapIdx_).insertScan(rawScan, preProcessedScan, mapToRangeSensor, timestamp, true);
 	}
@@ -217,6 +236,7 @@ void SubmapCollection::setParameters(const MapperParameters &p) {
 		submap.setParameters(p);
 	}
 	placeRecognition_.setParameters(p);
+	submapCenterIndex_.setCellSize(params_.submaps_.radius_);
 	assert_gt<size_t>(params_.submaps_.numScansOverlap_, 0, "Num scan overlap has to be > 0");
 	overlapScansBuffer_.set_size_limit(params_.submaps_.numScansOverlap_);
 }
@@ -232,6 +252,12 @@ void SubmapCollection::computeFeatures(const TimestampedSubmapIds &finishedSubma
 //			std::cout << "computing features for submap: " << id.submapId_ << std::endl;
 //			std::cout << "submap size: " << submaps_.at(id.submapId_).getMapPointCloud().points_.size() << std::endl;
 			submaps_.at(id.submapId_).computeFeatures();
+			if (params_.placeRecognition_.globalDescriptor_.isUseGlobalDescriptor_) {
+				const ScanContext scanContext = submaps_.at(id.submapId_).getScanContext();
+				if (!scanContext.isEmpty()) {
+					scanContextIndex_.insert(id.submapId_, scanContext);
+				}
+			}
 			loopClosureCandidatesIdxs_.push(id);
 		}
 	};
@@ -251,30 +277,53 @@ bool SubmapCollection::isComputingFeatures() const {
 	return isComputingFeatures_;
 }
 
-const Constraints& SubmapCollection::getOdometryConstraints() const {
-	return odometryConstraints_;
+Constraints SubmapCollection::getOdometryConstraints() const {
+	return odometryConstraints_.getConstraints();
+}
+
+Constraints SubmapCollection::buildOdometryConstraints() {
+	computeOdometryConstraints(*this, &odometryConstraints_);
+	return odometryConstraints_.getConstraints();
+}
+
+const ScanContextIndex& SubmapCollection::getScanContextIndex() const {
+	return scanContextIndex_;
+}
+
+const SubmapCenterIndex& SubmapCollection::getSubmapCenterIndex() const {
+	return submapCenterIndex_;
 }
 
 Constraints SubmapCollection::buildLoopClosureConstraints(
 		const TimestampedSubmapIds &loopClosureCandidatesIdxs)  {
-	Constraints retVal;
+	// place recognition keeps references to the sparse clouds and features
+	std::lock_guard<std::mutex> lck(pagingMutex_);
+	// gather the pairs of all the submaps first, then they are all matched concurrently
+	LoopClosureCandidates candidates;
 	for (const auto &id : loopClosureCandidatesIdxs) {
-		const auto constraints = placeRecognition_.buildLoopClosureConstraints(mapToRangeSensor_, *this,
-				adjacencyMatrix_, id.submapId_, activeSubmapIdx_, id.time_);
-		if (!constraints.empty()) {
-			for (int i = 0; i < constraints.size(); ++i) {
-				retVal.push_back(constraints.at(i));
-			}
+		const auto c = placeRecognition_.getLoopClosureCandidates(mapToRangeSensor_, *this, adjacencyMatrix_,
+				id.submapId_, activeSubmapIdx_, id.time_);
+		candidates.insert(candidates.end(), c.begin(), c.end());
+	}
+	const Constraints retVal = placeRecognition_.buildLoopClosureConstraints(candidates, *this);
+	for (const auto &id : loopClosureCandidatesIdxs) {
+		const size_t numConstraints = std::count_if(retVal.begin(), retVal.end(), [&id](const Constraint &c) {
+			return c.sourceSubmapIdx_ == id.submapId_;
+		});
+		if (numConstraints > 0) {
 			std::cout << " building loop closure constraints for submap: " << id.submapId_ << " resulted in: "
-					<< constraints.size() << " new constraints \n";
+					<< numConstraints << " new constraints \n";
 		}
 	}
 	return retVal;
 }
 
 bool SubmapCollection::dumpToFile(const std::string &folderPath, const std::string &filename, const bool &isDenseMap) const {
-	bool result = true;
-	for (size_t i = 0; i < submaps_.size(); ++i) {
+	std::lock_guard<std::mutex> lck(pagingMutex_);
+	std::atomic_bool result(true);
+	const int nSubmaps = submaps_.size();
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < nSubmaps; ++i) {
 		PointCloud copy;
 		if (isDenseMap) {
 			copy = submaps_.at(i).getDenseMapCopy().toPointCloud();
@@ -282,11 +331,73 @@ bool SubmapCollection::dumpToFile(const std::string &folderPath, const std::stri
 			copy = submaps_.at(i).getMapPointCloudCopy();
 		}
 		const std::string fullPath = folderPath + "/" + filename + "_" + std::to_string(i) + ".pcd";
-		result = result && open3d::io::WritePointCloudToPCD(fullPath, copy, open3d::io::WritePointCloudOption());
+		if (!open3d::io::WritePointCloudToPCD(fullPath, copy, open3d::io::WritePointCloudOption())) {
+			result = false;
+		}
 	}
 	return result;
 }
 
+bool SubmapCollection::exportToFile(const std::string &filename, const bool &isDenseMap) const {
+	// at most one submap copy per thread is alive at any time
+	std::lock_guard<std::mutex> lck(pagingMutex_);
+	// the file gets every field any of the submaps has, the header has to be written before the first cloud
+	const int nSubmaps = submaps_.size();
+	bool hasNormals = false, hasColors = false;
+	for (int i = 0; i < nSubmaps; ++i) {
+		bool submapHasNormals = false, submapHasColors = false;
+		submaps_.at(i).getMapFields(isDenseMap, &submapHasNormals, &submapHasColors);
+		hasNormals = hasNormals || submapHasNormals;
+		hasColors = hasColors || submapHasColors;
+	}
+	StreamingPointCloudWriter writer;
+	if (!writer.open(filename, hasNormals, hasColors)) {
+		return false;
+	}
+	std::atomic_bool result(true);
+	std::atomic_int nExported(0);
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < nSubmaps; ++i) {
+		PointCloud copy;
+		if (isDenseMap) {
+			copy = submaps_.at(i).getDenseMapCopy().toPointCloud();
+		} else {
+			copy = submaps_.at(i).getMapPointCloudCopy();
+		}
+		if (!writer.write(copy)) {
+			result = false;
+		}
+		const int n = ++nExported;
+		if (n == nSubmaps || (10 * n) / nSubmaps != (10 * (n - 1)) / nSubmaps) {
+			const auto stats = writer.getStatistics();
+			std::ostringstream msg;
+			msg << std::fixed << std::setprecision(1) << "Exported " << n << "/" << nSubmaps << " submaps to "
+					<< filename << ": " << stats.getMegabytes() << " MB, " << stats.getMegabytesPerSecond() << " MB/s \n";
+			std::cout << msg.str();
+		}
+	}
+	return writer.close() && result;
+}
+
+bool SubmapCollection::saveToMapFile(const std::string &filename) const {
+	// paged out submaps are read from their pages and stay on disk
+	std::lock_guard<std::mutex> lck(pagingMutex_);
+	MapFileContent content;
+	const int nSubmaps = submaps_.size();
+	content.submaps_.resize(nSubmaps);
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < nSubmaps; ++i) {
+		const Submap &submap = submaps_.at(i);
+		MapFileSubmap &out = content.submaps_[i];
+		out.id_ = submap.getId();
+		out.parentId_ = submap.getParentId();
+		out.mapToSubmapOrigin_ = submap.getMapToSubmapOrigin();
+		out.mapToSubmapCenter_ = submap.getMapToSubmapCenter();
+		out.map_ = submap.getMapPointCloudCopy();
+	}
+	return writeMapFile(filename, content);
+}
+
 void SubmapCollection::transform(const OptimizedTransforms &transformIncrements) {
 	const size_t nTransforms = transformIncrements.size();
 	std::vector<size_t> optimizedIdxs;
@@ -337,11 +448,62 @@ void SubmapCollection::transform(const OptimizedTransforms &transformIncrements)
 		}
 	}
 
+	for (size_t i = 0; i < submaps_.size(); ++i) {
+		submapCenterIndex_.update(i, submaps_.at(i).getMapToSubmapCenter());
+	}
+
 	//need to flush the buffered scans
 	overlapScansBuffer_.clear();
 
 }
 
+void SubmapCollection::pageOutSubmaps() {
+	const SubmapParameters &p = params_.submaps_;
+	if (!p.isPageOutToDisk_) {
+		return;
+	}
+	std::unique_lock<std::mutex> lck(pagingMutex_, std::try_to_lock);
+	if (!lck.owns_lock()) {
+		return; // loop closure in progress, try again at the next submap switch
+	}
+	const size_t memoryBudget = static_cast<size_t>(p.pageOutMemoryBudgetMb_ * 1e6);
+	std::vector<size_t> footprints(submaps_.size());
+	std::vector<size_t> candidates;
+	size_t totalFootprint = 0;
+	for (size_t i = 0; i < submaps_.size(); ++i) {
+		const Submap &submap = submaps_.at(i);
+		footprints[i] = submap.getMemoryFootprint();
+		totalFootprint += footprints[i];
+		const double distance = (mapToRangeSensor_.translation() - submap.getMapToSubmapCenter()).norm();
+		if (i != activeSubmapIdx_ && distance > p.pageOutMinDistance_ && footprints[i] > 0) {
+			candidates.push_back(i);
+		}
+	}
+	if (totalFootprint <= memoryBudget) {
+		return;
+	}
+	std::sort(candidates.begin(), candidates.end(), [this](size_t a, size_t b) {
+		return submaps_.at(a).getLastAccessTime() < submaps_.at(b).getLastAccessTime();
+	});
+	createDirectoryOrNoActionIfExists(p.pageOutFolder_);
+	size_t numPagedOut = 0;
+	for (const size_t idx : candidates) {
+		if (totalFootprint <= memoryBudget) {
+			break;
+		}
+		if (submaps_.at(idx).pageOut(getPageFilePrefix(idx))) {
+			totalFootprint -= footprints[idx];
+			++numPagedOut;
+		}
+	}
+	std::cout << "Paged out " << numPagedOut << " submaps, resident submaps take " << totalFootprint / 1e6
+			<< " MB \n";
+}
+
+std::string SubmapCollection::getPageFilePrefix(size_t submapIdx) const {
+	return params_.submaps_.pageOutFolder_ + "/submap_" + std::to_string(submapIdx);
+}
+
 std::vector<size_t> SubmapCollection::getAllSubmapIdxs() const {
 	std::vector<size_t> idxs(submaps_.size());
 	std::iota(idxs.begin(), idxs.end(), 0);
@@ -360,12 +522,8 @@ void SubmapCollection::setFolderPath(const std::string &folderPath) {
 bool SubmapCollection::isSwitchingSubmapsConsistant(const PointCloud &scan,
 		size_t newActiveSubmapCandidate, const Transform &mapToRangeSensor) const {
 	//Timer("submap_switch_consistency_check");
-	int numOverlappingPoints = 0;
-	const VoxelMap &voxelMap = submaps_.at(newActiveSubmapCandidate).getVoxelMap();
-	for (int i = 0; i < scan.points_.size(); ++i) {
-		const Eigen::Vector3d p = mapToRangeSensor * scan.points_.at(i);
-		numOverlappingPoints += int(voxelMap.hasVoxelContainingPoint(p));
-	}
+	const size_t numOverlappingPoints = submaps_.at(newActiveSubmapCandidate).getNumPointsInVoxelMap(scan,
+			mapToRangeSensor);
 	const double fitness = static_cast<double>(numOverlappingPoints) / scan.points_.size();
 //	std::cout << "Fitness: " << fitness << std::endl;
 	return fitness > params_.submaps_.adjacencyBasedRevisitingMinFitness_;
@@ -8,7 +8,9 @@
 #include "open3d_slam/time.hpp"
 #include "open3d_slam/assert.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 namespace o3d_slam {
 
@@ -20,150 +22,258 @@ TransformInterpolationBuffer::TransformInterpolationBuffer(size_t bufferSize) {
 	setSizeLimit(bufferSize);
 }
 
-void TransformInterpolationBuffer::push(const Time &time, const Transform &tf) {
+template<typename Read>
+void TransformInterpolationBuffer::readConsistent(Read &&read) const {
+	while (true) {
+		const uint64 sequence = sequence_.load(std::memory_order_acquire);
+		if (sequence & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+		read();
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (sequence_.load(std::memory_order_relaxed) == sequence) {
+			return;
+		}
+	}
+}
+
+void TransformInterpolationBuffer::beginWrite() {
+	sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void TransformInterpolationBuffer::endWrite() {
+	sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
 
+const TimestampedTransform& TransformInterpolationBuffer::at(size_t idx) const {
+	return transforms_[(begin_.load(std::memory_order_relaxed) + idx) % transforms_.size()];
+}
+
+void TransformInterpolationBuffer::push(const Time &time, const Transform &tf) {
+	std::lock_guard<std::mutex> lck(modifierMutex_);
+	const size_t n = size_.load(std::memory_order_relaxed);
 	//this relies that they will be pushed in order!!!
-	if (!transforms_.empty()) {
-		if (time < earliest_time()) {
+	if (n > 0) {
+		const Time earliestTime = at(0).time_;
+		const Time latestTime = at(n - 1).time_;
+		if (time < earliestTime) {
 			std::cerr
 					<< "TransformInterpolationBuffer:: you are trying to push something earlier than the earliest measurement, this should not happen \n";
 			std::cerr << "ingnoring the mesurement \n";
 			std::cerr << "Time: " << toSecondsSinceFirstMeasurement(time) << std::endl;
-			std::cerr << "earliest time: " << toSecondsSinceFirstMeasurement(earliest_time()) << std::endl;
+			std::cerr << "earliest time: " << toSecondsSinceFirstMeasurement(earliestTime) << std::endl;
 			return;
 		}
 
-		if (time < latest_time()) {
+		if (time < latestTime) {
 			std::cerr
 					<< "TransformInterpolationBuffer:: you are trying to push something out of order, this should not happen \n";
 			std::cerr << "ingnoring the mesurement \n";
 			std::cerr << "Time: " << time << std::endl;
-			std::cerr << "latest time: " << toSecondsSinceFirstMeasurement(latest_time()) << std::endl;
+			std::cerr << "latest time: " << toSecondsSinceFirstMeasurement(latestTime) << std::endl;
 			return;
 		}
 	}
-	transforms_.push_back( { time, tf });
-	removeOldMeasurementsIfNeeded();
+	const size_t capacity = transforms_.size();
+	const size_t begin = begin_.load(std::memory_order_relaxed);
+	beginWrite();
+	if (n < capacity) {
+		transforms_[(begin + n) % capacity] = { time, tf };
+		size_.store(n + 1, std::memory_order_relaxed);
+	} else {
+		// full, overwrite the oldest one
+		transforms_[begin] = { time, tf };
+		begin_.store((begin + 1) % capacity, std::memory_order_relaxed);
+	}
+	endWrite();
 }
 
 void TransformInterpolationBuffer::applyToAllElementsInTimeInterval(const Transform &t, const Time &begin,
 		const Time &end) {
 //	assert_ge(toUniversal(end),toUniversal(begin));
-	for(auto it = transforms_.begin(); it != transforms_.end(); ++it){
-		if(it->time_ >= begin && it->time_ <= end){
-			it->transform_ = it->transform_ * t;
+	std::lock_guard<std::mutex> lck(modifierMutex_);
+	beginWrite();
+	for (size_t i = 0; i < size_.load(std::memory_order_relaxed); ++i) {
+		TimestampedTransform &tf = transforms_[(begin_.load(std::memory_order_relaxed) + i) % transforms_.size()];
+		if (tf.time_ >= begin && tf.time_ <= end) {
+			tf.transform_ = tf.transform_ * t;
 		}
 	}
+	endWrite();
 }
 
 void TransformInterpolationBuffer::setSizeLimit(const size_t buffer_size_limit) {
-
-	bufferSizeLimit_ = buffer_size_limit;
-	removeOldMeasurementsIfNeeded();
+	assert_gt<size_t>(buffer_size_limit, 0, "TransformInterpolationBuffer:: size limit has to be > 0");
+	std::lock_guard<std::mutex> lck(modifierMutex_);
+	// keep the latest transforms
+	const size_t n = size_.load(std::memory_order_relaxed);
+	const size_t numKept = std::min(n, buffer_size_limit);
+	std::vector<TimestampedTransform, Eigen::aligned_allocator<TimestampedTransform>> transforms(buffer_size_limit);
+	for (size_t i = 0; i < numKept; ++i) {
+		transforms[i] = at(n - numKept + i);
+	}
+	beginWrite();
+	transforms_ = std::move(transforms);
+	begin_.store(0, std::memory_order_relaxed);
+	size_.store(numKept, std::memory_order_relaxed);
+	endWrite();
 }
 
 void TransformInterpolationBuffer::clear() {
-	transforms_.clear();
+	std::lock_guard<std::mutex> lck(modifierMutex_);
+	beginWrite();
+	begin_.store(0, std::memory_order_relaxed);
+	size_.store(0, std::memory_order_relaxed);
+	endWrite();
 }
 
-const TimestampedTransform& TransformInterpolationBuffer::latest_measurement(int offsetFromLastElement /*=0*/) const {
-	if (empty()) {
+TimestampedTransform TransformInterpolationBuffer::latest_measurement(int offsetFromLastElement /*=0*/) const {
+	size_t n = 0;
+	TimestampedTransform ret;
+	readConsistent([&]() {
+		n = std::min(size_.load(std::memory_order_relaxed), transforms_.size());
+		if (offsetFromLastElement >= 0 && static_cast<size_t>(offsetFromLastElement) < n) {
+			ret = at(n - 1 - offsetFromLastElement);
+		}
+	});
+	if (n == 0) {
 		throw std::runtime_error("TransformInterpolationBuffer:: latest_measurement: Empty buffer");
 	}
-	return *(std::prev(transforms_.end(), offsetFromLastElement+1));
+	if (offsetFromLastElement < 0 || static_cast<size_t>(offsetFromLastElement) >= n) {
+		throw std::runtime_error(
+				"TransformInterpolationBuffer:: latest_measurement: offset " + std::to_string(offsetFromLastElement)
+						+ " is out of range, buffer size: " + std::to_string(n));
+	}
+	return ret;
 }
-TimestampedTransform& TransformInterpolationBuffer::latest_measurement(int offsetFromLastElement /*=0*/) {
-	if (empty()) {
-		throw std::runtime_error("TransformInterpolationBuffer:: latest_measurement: Empty buffer");
+
+void TransformInterpolationBuffer::findBracket(const Time &time, bool isClamp, Bracket *bracket) const {
+	// the state can be torn if a writer is active, everything has to stay within bounds regardless
+	const size_t n = std::min(size_.load(std::memory_order_relaxed), transforms_.size());
+	bracket->size_ = n;
+	bracket->isInRange_ = false;
+	if (n == 0) {
+		return;
 	}
-	return *(std::prev(transforms_.end(), offsetFromLastElement+1));
+	const Time earliestTime = at(0).time_;
+	const Time latestTime = at(n - 1).time_;
+	bracket->time_ = isClamp ? std::min(std::max(time, earliestTime), latestTime) : time;
+	if (bracket->time_ < earliestTime || bracket->time_ > latestTime) {
+		return;
+	}
+	bracket->isInRange_ = true;
+	// first transform that is not earlier than the query
+	size_t lo = 0;
+	size_t hi = n - 1;
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (at(mid).time_ < bracket->time_) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	bracket->end_ = at(lo);
+	bracket->isExact_ = lo == 0 || bracket->end_.time_ == bracket->time_;
+	bracket->start_ = bracket->isExact_ ? bracket->end_ : at(lo - 1);
 }
 
 bool TransformInterpolationBuffer::has(const Time &time) const {
-	if (transforms_.empty()) {
-		return false;
-	}
-	return earliest_time() <= time && time <= latest_time();
+	Bracket bracket;
+	readConsistent([&]() {
+		findBracket(time, false, &bracket);
+	});
+	return bracket.isInRange_;
 }
 
 Transform TransformInterpolationBuffer::lookup(const Time &time) const {
-
-	if (!has(time)) {
+	Bracket bracket;
+	readConsistent([&]() {
+		findBracket(time, false, &bracket);
+	});
+	if (!bracket.isInRange_) {
 		throw std::runtime_error("TransformInterpolationBuffer:: Missing transform for: " + toString(time));
 	}
-
-	if (size() == 1) {
-		return transforms_.front().transform_;
-	}
-
-	//just return the closest
-	const auto getMeasurement = std::find_if(transforms_.begin(), transforms_.end(),
-			[&time](const TimestampedTransform &tf) {
-				return time <= tf.time_;
-			});
-	const bool isIteratorValid = getMeasurement != transforms_.end();
-	if (isIteratorValid && getMeasurement->time_ == time) {
-		return getMeasurement->transform_;
+	if (bracket.isExact_) {
+		return bracket.end_.transform_;
 	}
-	const auto start = std::prev(getMeasurement);
-
-//  std::cout << "buffer size: " << size() << "\n";
-//  std::cout << "left time: " << toSecondsSinceFirstMeasurement(start->time_) << "\n";
-//  std::cout << "right time: " << toSecondsSinceFirstMeasurement(getMeasurement->time_) << "\n";
-//  std::cout << "query time: " << toSecondsSinceFirstMeasurement(time) << "\n \n";
-//  std::cout << "times in buffer: \n";
-  printTimesCurrentlyInBuffer();
-
-	return interpolate(*start, *getMeasurement, time).transform_;
+	return interpolate(bracket.start_, bracket.end_, bracket.time_).transform_;
 }
 
-void TransformInterpolationBuffer::removeOldMeasurementsIfNeeded() {
-	while (transforms_.size() > bufferSizeLimit_) {
-		transforms_.pop_front();
+Transform TransformInterpolationBuffer::lookupClamped(const Time &time) const {
+	Bracket bracket;
+	readConsistent([&]() {
+		findBracket(time, true, &bracket);
+	});
+	if (bracket.size_ == 0) {
+		throw std::runtime_error("TransformInterpolationBuffer:: Empty buffer");
+	}
+	if (bracket.isExact_) {
+		return bracket.end_.transform_;
 	}
+	return interpolate(bracket.start_, bracket.end_, bracket.time_).transform_;
 }
 
 Time TransformInterpolationBuffer::earliest_time() const {
-	if (empty()) {
+	size_t n = 0;
+	Time ret;
+	readConsistent([&]() {
+		n = std::min(size_.load(std::memory_order_relaxed), transforms_.size());
+		if (n > 0) {
+			ret = at(0).time_;
+		}
+	});
+	if (n == 0) {
 		throw std::runtime_error("TransformInterpolationBuffer:: Empty buffer");
 	}
-	return transforms_.front().time_;
+	return ret;
 }
 
 Time TransformInterpolationBuffer::latest_time() const {
-	if (empty()) {
+	size_t n = 0;
+	Time ret;
+	readConsistent([&]() {
+		n = std::min(size_.load(std::memory_order_relaxed), transforms_.size());
+		if (n > 0) {
+			ret = at(n - 1).time_;
+		}
+	});
+	if (n == 0) {
 		throw std::runtime_error("TransformInterpolationBuffer:: Empty buffer");
 	}
-	return transforms_.back().time_;
+	return ret;
 }
 
 bool TransformInterpolationBuffer::empty() const {
-	return transforms_.empty();
+	return size() == 0;
 }
 
 size_t TransformInterpolationBuffer::size_limit() const {
-	return bufferSizeLimit_;
+	return transforms_.size();
 }
 
 size_t TransformInterpolationBuffer::size() const {
-	return transforms_.size();
+	return size_.load(std::memory_order_acquire);
 }
 
 void TransformInterpolationBuffer::printTimesCurrentlyInBuffer() const {
-	for (auto it = transforms_.cbegin(); it != transforms_.cend(); ++it) {
-		std::cout << toSecondsSinceFirstMeasurement(it->time_) << std::endl;
+	std::vector<Time> times;
+	readConsistent([&]() {
+		const size_t n = std::min(size_.load(std::memory_order_relaxed), transforms_.size());
+		times.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			times[i] = at(i).time_;
+		}
+	});
+	for (const auto &time : times) {
+		std::cout << toSecondsSinceFirstMeasurement(time) << std::endl;
 	}
 }
 
 Transform getTransform(const Time &time, const TransformInterpolationBuffer &buffer) {
-	if (time < buffer.earliest_time()) {
-		return buffer.lookup(buffer.earliest_time());
-	}
-	if (time > buffer.latest_time()) {
-		return buffer.lookup(buffer.latest_time());
-	}
-	return buffer.lookup(time);
+	return buffer.lookupClamped(time);
 }
 
 } // namespace o3d_slam
-
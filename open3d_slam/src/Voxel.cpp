@@ -7,6 +7,8 @@
 
 #include "open3d_slam/Voxel.hpp"
 #include "open3d_slam/time.hpp"
+#include "open3d_slam/assert.hpp"
+#include <algorithm>
 #include <numeric>
 #include <iostream>
 #include <unordered_set>
@@ -51,7 +53,7 @@ bool VoxelizedPointCloud::hasNormals() const {
 }
 
 void VoxelizedPointCloud::transform(const Transform &T){
-	std::unordered_map<Eigen::Vector3i, AggregatedVoxel, EigenVec3iHash> voxels;
+	ContainerImpl_t voxels;
 	if (empty()){
 			return;
 		}
@@ -59,8 +61,10 @@ void VoxelizedPointCloud::transform(const Transform &T){
 		for (const auto &v : voxels_) {
 			if (v.second.numAggregatedPoints_ > 0) {
 				AggregatedVoxel vTransformed(v.second);
-				vTransformed.aggregatedNormal_ = T * vTransformed.aggregatedNormal_;
-				vTransformed.aggregatedPosition_ = T * vTransformed.aggregatedPosition_;
+				// these are sums, the translation is added once per point and not at all to the normals
+				vTransformed.aggregatedNormal_ = T.linear() * vTransformed.aggregatedNormal_;
+				vTransformed.aggregatedPosition_ = T.linear() * vTransformed.aggregatedPosition_
+						+ vTransformed.numAggregatedPoints_ * T.translation();
 				voxels[v.first] = vTransformed;
 			}
 		}
@@ -129,46 +133,81 @@ VoxelMap::VoxelMap(const Eigen::Vector3d &voxelSize) :
 		BASE(voxelSize) {
 }
 
-void VoxelMap::insertCloud(const std::string &layer, const open3d::geometry::PointCloud &cloud, const std::vector<size_t> &idxs) {
+void VoxelMap::insertCloud(LayerId layer, const open3d::geometry::PointCloud &cloud, const std::vector<size_t> &idxs) {
+	if (idxs.empty()) {
+		return;
+	}
+	if (layer >= layers_.size()) {
+		layers_.resize(layer + 1);
+	}
+	Layer &l = layers_[layer];
+	assert_true(l.offsets_.empty(),
+			"VoxelMap: layer " + std::to_string(layer) + " is filled already, clear the map first");
+	seqNumberScratch_.resize(idxs.size());
+	for (size_t i = 0; i < idxs.size(); ++i) {
+		const auto voxelIdx = getKey(cloud.points_[idxs[i]]);
+		auto search = voxels_.find(voxelIdx);
+		if (search == voxels_.end()) {
+			search = voxels_.insert({voxelIdx, VoxelWithIdxs{voxels_.size()}}).first;
+		}
+		seqNumberScratch_[i] = search->second.seqNumber_;
+	}
+
+	// counting sort of the indices by voxel, the other layers are left as they are
+	l.offsets_.assign(voxels_.size() + 1, 0);
+	for (const size_t seqNumber : seqNumberScratch_) {
+		++l.offsets_[seqNumber + 1];
+	}
+	std::partial_sum(l.offsets_.begin(), l.offsets_.end(), l.offsets_.begin());
+	l.arena_.resize(idxs.size());
+	cursorScratch_.assign(l.offsets_.begin(), l.offsets_.end() - 1);
 	for (size_t i = 0; i < idxs.size(); ++i) {
-		const size_t idx = idxs[i];
-		const auto voxelIdx = getKey(cloud.points_[idx]);
-		voxels_[voxelIdx].idxs_[layer].emplace_back(idx);
+		l.arena_[cursorScratch_[seqNumberScratch_[i]]++] = idxs[i];
 	}
 }
-void VoxelMap::insertCloud(const std::string &layer, const open3d::geometry::PointCloud &cloud) {
+void VoxelMap::insertCloud(LayerId layer, const open3d::geometry::PointCloud &cloud) {
 	std::vector<size_t> idxs(cloud.points_.size());
 	std::iota(idxs.begin(), idxs.end(), 0);
 	insertCloud(layer, cloud, idxs);
 }
 
-std::vector<size_t> VoxelMap::getIndicesInVoxel(const std::string &layer,
-		const Eigen::Vector3d &p) const {
+VoxelMap::IdxsView VoxelMap::getIndicesInVoxel(LayerId layer, const Eigen::Vector3d &p) const {
 	return getIndicesInVoxel(layer, getKey(p));
 }
 
-std::vector<size_t> VoxelMap::getIndicesInVoxel(const std::string &layer,
-		const Eigen::Vector3i &key) const {
+VoxelMap::IdxsView VoxelMap::getIndicesInVoxel(LayerId layer, const Eigen::Vector3i &key) const {
 	const auto searchVoxel = voxels_.find(key);
 	if (searchVoxel != voxels_.end()) {
-		const auto searchLayer = searchVoxel->second.idxs_.find(layer);
-		if (searchLayer != searchVoxel->second.idxs_.end()) {
-			return searchLayer->second;
-		}
+		return getIndicesInVoxel(layer, searchVoxel->second);
 	}
-	return std::vector<size_t>();
+	return IdxsView();
 }
 
-bool VoxelMap::isVoxelHasLayer(const Eigen::Vector3i &key, const std::string &layer) const {
+VoxelMap::IdxsView VoxelMap::getIndicesInVoxel(LayerId layer, const VoxelWithIdxs &voxel) const {
+	if (layer >= layers_.size() || voxel.seqNumber_ + 1 >= layers_[layer].offsets_.size()) {
+		return IdxsView();
+	}
+	const Layer &l = layers_[layer];
+	const size_t *data = l.arena_.data();
+	return IdxsView(data + l.offsets_[voxel.seqNumber_], data + l.offsets_[voxel.seqNumber_ + 1]);
+}
 
-	const auto searchVoxel = voxels_.find(key);
-	if (searchVoxel != voxels_.end()) {
-		const auto searchLayer = searchVoxel->second.idxs_.find(layer);
-		if (searchLayer != searchVoxel->second.idxs_.end()) {
-			return true;
-		}
+bool VoxelMap::isVoxelHasLayer(const Eigen::Vector3i &key, LayerId layer) const {
+	return !getIndicesInVoxel(layer, key).empty();
+}
+
+void VoxelMap::clear() {
+	BASE::clear();
+	for (auto &l : layers_) {
+		l.offsets_.clear();
+		l.arena_.clear();
 	}
-	return false;
+}
+
+void VoxelMap::reset(const Eigen::Vector3d &voxelSize) {
+	clear();
+	voxelSize_ = voxelSize;
+	inverseVoxelSize_ = fromVoxelSize(voxelSize);
 }
 
 std::shared_ptr<PointCloud> removeDuplicatePointsWithinSameVoxels(const open3d::geometry::PointCloud &cloud, const Eigen::Vector3d &voxelSize){
@@ -0,0 +1,262 @@
+/*
+ * VoxelizedMapCloud.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/VoxelizedMapCloud.hpp"
+#include "open3d_slam/croppers.hpp"
+#include "open3d_slam/helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace o3d_slam {
+
+namespace {
+bool isFinite(const Eigen::Vector3d &v) {
+	return std::isfinite(v.x()) && std::isfinite(v.y()) && std::isfinite(v.z());
+}
+
+void addPoint(const PointCloud &from, size_t idx, PointCloud *to) {
+	if (to == nullptr) {
+		return;
+	}
+	to->points_.push_back(from.points_[idx]);
+	if (from.HasNormals()) {
+		to->normals_.push_back(from.normals_[idx]);
+	}
+}
+} // namespace
+
+constexpr uint32 VoxelizedMapCloud::kNotInGrid;
+
+VoxelizedMapCloud::VoxelizedMapCloud(double voxelSize) :
+		voxelSize_(voxelSize), inverseVoxelSize_(fromVoxelSize(Eigen::Vector3d::Constant(voxelSize))) {
+}
+
+Eigen::Vector3i VoxelizedMapCloud::getKey(const Eigen::Vector3d &p) const {
+	return getVoxelIdx(mapToGrid_ * p, inverseVoxelSize_);
+}
+
+void VoxelizedMapCloud::setCloud(PointCloud &&cloud) {
+	cloud_ = std::move(cloud);
+	indexCloud();
+}
+
+void VoxelizedMapCloud::setVoxelSize(double voxelSize) {
+	if (voxelSize == voxelSize_) {
+		return;
+	}
+	voxelSize_ = voxelSize;
+	inverseVoxelSize_ = fromVoxelSize(Eigen::Vector3d::Constant(voxelSize));
+	indexCloud();
+}
+
+void VoxelizedMapCloud::indexCloud() {
+	mapToGrid_.setIdentity();
+	keyToPointIdx_.clear();
+	const size_t n = cloud_.points_.size();
+	keys_.resize(n);
+	numMergedPoints_.assign(n, kNotInGrid);
+	if (voxelSize_ <= 0.0) {
+		return;
+	}
+	keyToPointIdx_.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		keys_[i] = getKey(cloud_.points_[i]);
+		if (keyToPointIdx_.emplace(keys_[i], i).second) {
+			numMergedPoints_[i] = 1;
+		}
+	}
+}
+
+void VoxelizedMapCloud::matchFieldsTo(const PointCloud &scan) {
+	// same as PointCloud::operator+=, a field is kept only if both clouds have it
+	const bool isEmpty = cloud_.IsEmpty();
+	isHasNormals_ = scan.HasNormals() && (isEmpty || cloud_.HasNormals());
+	isHasColors_ = scan.HasColors() && (isEmpty || cloud_.HasColors());
+	isHasCovariances_ = scan.HasCovariances() && (isEmpty || cloud_.HasCovariances());
+	if (!isHasNormals_) {
+		cloud_.normals_.clear();
+	}
+	if (!isHasColors_) {
+		cloud_.colors_.clear();
+	}
+	if (!isHasCovariances_) {
+		cloud_.covariances_.clear();
+	}
+}
+
+void VoxelizedMapCloud::appendPoint(const Eigen::Vector3d &p, const Eigen::Vector3d &normal,
+		const Eigen::Vector3d &color, const Eigen::Matrix3d &covariance, const Eigen::Vector3i &key, uint32 numPoints) {
+	cloud_.points_.push_back(p);
+	if (isHasNormals_) {
+		cloud_.normals_.push_back(normal);
+	}
+	if (isHasColors_) {
+		cloud_.colors_.push_back(color);
+	}
+	if (isHasCovariances_) {
+		cloud_.covariances_.push_back(covariance);
+	}
+	keys_.push_back(key);
+	numMergedPoints_.push_back(numPoints);
+}
+
+void VoxelizedMapCloud::insert(const PointCloud &scan, const CroppingVolume &croppingVolume,
+		PointCloud *removedPoints, PointCloud *addedPoints) {
+	if (removedPoints != nullptr) {
+		removedPoints->Clear();
+	}
+	if (addedPoints != nullptr) {
+		addedPoints->Clear();
+	}
+	if (scan.IsEmpty()) {
+		return;
+	}
+	matchFieldsTo(scan);
+
+	const Eigen::Vector3d zero = Eigen::Vector3d::Zero();
+	// bin the new points by voxel first, every voxel of the map is then updated once per scan
+	scanKeyToVoxelIdx_.clear();
+	scanVoxels_.clear();
+	scanKeys_.clear();
+	for (size_t i = 0; i < scan.points_.size(); ++i) {
+		const Eigen::Vector3d &p = scan.points_[i];
+		if (voxelSize_ <= 0.0 || !croppingVolume.isWithinVolume(p)) {
+			appendPoint(p, isHasNormals_ ? scan.normals_[i] : zero, isHasColors_ ? scan.colors_[i] : zero,
+					isHasCovariances_ ? scan.covariances_[i] : Eigen::Matrix3d::Zero(), Eigen::Vector3i::Zero(), kNotInGrid);
+			addPoint(scan, i, addedPoints);
+			continue;
+		}
+		const Eigen::Vector3i key = getKey(p);
+		const auto search = scanKeyToVoxelIdx_.emplace(key, scanVoxels_.size());
+		if (search.second) {
+			scanVoxels_.emplace_back();
+			scanKeys_.push_back(key);
+		}
+		ScanVoxel &voxel = scanVoxels_[search.first->second];
+		++voxel.numPoints_;
+		voxel.position_ += p;
+		if (isHasNormals_ && isFinite(scan.normals_[i])) {
+			voxel.normal_ += scan.normals_[i];
+		}
+		if (isHasColors_ && isValidColor(scan.colors_[i])) {
+			voxel.color_ = scan.colors_[i];
+			voxel.isHasColor_ = true;
+		}
+		if (isHasCovariances_) {
+			voxel.covariance_ += scan.covariances_[i];
+		}
+	}
+
+	for (size_t j = 0; j < scanVoxels_.size(); ++j) {
+		const ScanVoxel &voxel = scanVoxels_[j];
+		const Eigen::Vector3i &key = scanKeys_[j];
+		const auto search = keyToPointIdx_.find(key);
+		size_t idx = 0;
+		double numOld = 0.0;
+		if (search == keyToPointIdx_.end()) {
+			idx = cloud_.points_.size();
+			appendPoint(zero, zero, zero, Eigen::Matrix3d::Zero(), key, 0);
+			keyToPointIdx_.emplace(key, idx);
+		} else {
+			idx = search->second;
+			numOld = numMergedPoints_[idx];
+			addPoint(cloud_, idx, removedPoints);
+		}
+		const double numTotal = numOld + voxel.numPoints_;
+		cloud_.points_[idx] = (numOld * cloud_.points_[idx] + voxel.position_) / numTotal;
+		if (isHasNormals_) {
+			cloud_.normals_[idx] = (numOld * cloud_.normals_[idx] + voxel.normal_).normalized();
+		}
+		if (isHasColors_ && voxel.isHasColor_) {
+			cloud_.colors_[idx] = voxel.color_;
+		}
+		if (isHasCovariances_) {
+			cloud_.covariances_[idx] = (numOld * cloud_.covariances_[idx] + voxel.covariance_) / numTotal;
+		}
+		numMergedPoints_[idx] += voxel.numPoints_;
+		addPoint(cloud_, idx, addedPoints);
+	}
+}
+
+void VoxelizedMapCloud::remove(const std::vector<size_t> &idxs) {
+	const bool isHasNormals = cloud_.HasNormals();
+	const bool isHasColors = cloud_.HasColors();
+	const bool isHasCovariances = cloud_.HasCovariances();
+	// from the back, the last point is then never one that still has to be removed
+	for (auto it = idxs.rbegin(); it != idxs.rend(); ++it) {
+		const size_t idx = *it;
+		const size_t last = cloud_.points_.size() - 1;
+		if (numMergedPoints_[idx] != kNotInGrid) {
+			keyToPointIdx_.erase(keys_[idx]);
+		}
+		if (idx != last) {
+			cloud_.points_[idx] = cloud_.points_[last];
+			if (isHasNormals) {
+				cloud_.normals_[idx] = cloud_.normals_[last];
+			}
+			if (isHasColors) {
+				cloud_.colors_[idx] = cloud_.colors_[last];
+			}
+			if (isHasCovariances) {
+				cloud_.covariances_[idx] = cloud_.covariances_[last];
+			}
+			keys_[idx] = keys_[last];
+			numMergedPoints_[idx] = numMergedPoints_[last];
+			if (numMergedPoints_[idx] != kNotInGrid) {
+				keyToPointIdx_.at(keys_[idx]) = idx;
+			}
+		}
+		cloud_.points_.pop_back();
+		if (isHasNormals) {
+			cloud_.normals_.pop_back();
+		}
+		if (isHasColors) {
+			cloud_.colors_.pop_back();
+		}
+		if (isHasCovariances) {
+			cloud_.covariances_.pop_back();
+		}
+		keys_.pop_back();
+		numMergedPoints_.pop_back();
+	}
+}
+
+void VoxelizedMapCloud::transform(const Transform &T) {
+	cloud_.Transform(T.matrix());
+	mapToGrid_ = mapToGrid_ * T.inverse();
+}
+
+const PointCloud& VoxelizedMapCloud::getCloud() const {
+	return cloud_;
+}
+
+double VoxelizedMapCloud::getVoxelSize() const {
+	return voxelSize_;
+}
+
+size_t VoxelizedMapCloud::size() const {
+	return cloud_.points_.size();
+}
+
+bool VoxelizedMapCloud::empty() const {
+	return cloud_.IsEmpty();
+}
+
+size_t VoxelizedMapCloud::getNumVoxels() const {
+	return keyToPointIdx_.size();
+}
+
+size_t VoxelizedMapCloud::getMemoryFootprint() const {
+	const size_t cloudBytes = (cloud_.points_.capacity() + cloud_.normals_.capacity() + cloud_.colors_.capacity())
+			* sizeof(Eigen::Vector3d) + cloud_.covariances_.capacity() * sizeof(Eigen::Matrix3d);
+	const size_t gridBytes = keyToPointIdx_.capacity() * (sizeof(Eigen::Vector3i) + sizeof(size_t) + 1)
+			+ keys_.capacity() * sizeof(Eigen::Vector3i) + numMergedPoints_.capacity() * sizeof(uint32);
+	return cloudBytes + gridBytes;
+}
+
+} // namespace o3d_slam
@@ -20,13 +20,28 @@ namespace o3d_slam {
 /// NON MEMBER ////////
 ////////////////////////////////////////////////////////////////////
 namespace {
-bool hasConstraint(size_t sourceIdx, size_t targetIdx, const Constraints &constraints) {
-	for (const auto &c : constraints) {
-		if (c.sourceSubmapIdx_ == sourceIdx && c.targetSubmapIdx_ == targetIdx) {
-			return true;
-		}
+struct SubmapPair {
+	size_t sourceIdx_;
+	size_t targetIdx_;
+	OdometryConstraintCache::Revisions revisions_;
+};
+
+OdometryConstraintCache::Revisions getRevisions(size_t sourceIdx, size_t targetIdx, const SubmapCollection &submaps) {
+	OdometryConstraintCache::Revisions revisions;
+	revisions.source_ = submaps.getSubmap(sourceIdx).getMapRevision();
+	revisions.target_ = submaps.getSubmap(targetIdx).getMapRevision();
+	return revisions;
+}
+
+void buildOdometryConstraints(const std::vector<SubmapPair> &pairs, const SubmapCollection &submaps,
+		OdometryConstraintCache *constraints) {
+	const int nPairs = pairs.size();
+#pragma omp parallel for schedule(dynamic, 1) if (nPairs > 1)
+	for (int i = 0; i < nPairs; ++i) {
+		const auto &pair = pairs[i];
+		// the revisions were taken before building, a scan merged in the meantime makes the entry stale
+		constraints->insert(buildOdometryConstraint(pair.sourceIdx_, pair.targetIdx_, submaps), pair.revisions_);
 	}
-	return false;
 }
 } // namespace
 
@@ -93,34 +108,37 @@ Constraint buildConstraint(size_t sourceIdx, size_t targetIdx, const SubmapColle
 }
 
 void computeOdometryConstraints(const SubmapCollection &submaps,
-		const SubmapCollection::TimestampedSubmapIds &candidates, Constraints *constraints) {
-	const size_t activeSubmapIdx = submaps.getActiveSubmap().getId();
+		const SubmapCollection::TimestampedSubmapIds &candidates, OdometryConstraintCache *constraints) {
+	std::vector<SubmapPair> pairs;
 	for (const auto candidate : candidates) {
 		if (candidate.submapId_ < 1) {
 			continue;
 		}
 		const size_t targetCandidate = candidate.submapId_;
 		const size_t sourceCandidate = submaps.getSubmap(targetCandidate).getParentId();
-		if (!hasConstraint(sourceCandidate, targetCandidate, *constraints)) {
-			const Constraint c = buildOdometryConstraint(sourceCandidate, targetCandidate, submaps);
-			constraints->emplace_back(std::move(c));
+		const auto revisions = getRevisions(sourceCandidate, targetCandidate, submaps);
+		if (!constraints->isUpToDate(sourceCandidate, targetCandidate, revisions)) {
+			pairs.push_back(SubmapPair { sourceCandidate, targetCandidate, revisions });
 		}
-
 	}
-
+	buildOdometryConstraints(pairs, submaps, constraints);
 }
 
-void computeOdometryConstraints(const SubmapCollection &submaps, Constraints *constraints) {
+void computeOdometryConstraints(const SubmapCollection &submaps, OdometryConstraintCache *constraints) {
 	const size_t activeSubmapIdx = submaps.getActiveSubmap().getId();
+	std::vector<SubmapPair> pairs;
 	for (size_t submapIdx = 1; submapIdx < submaps.getNumSubmaps(); ++submapIdx) {
 		const size_t targetIdx = submapIdx;
 		const size_t sourceIdx = submaps.getSubmap(targetIdx).getParentId();
-		if (!hasConstraint(sourceIdx, targetIdx, *constraints) && sourceIdx != activeSubmapIdx
-				&& targetIdx != activeSubmapIdx) {
-			const Constraint c = buildOdometryConstraint(sourceIdx, targetIdx, submaps);
-			constraints->emplace_back(std::move(c));
+		// the active submap is still changing, keep whatever is cached for it
+		if (sourceIdx == activeSubmapIdx || targetIdx == activeSubmapIdx) {
+			continue;
+		}
+		const auto revisions = getRevisions(sourceIdx, targetIdx, submaps);
+		if (!constraints->isUpToDate(sourceIdx, targetIdx, revisions)) {
+			pairs.push_back(SubmapPair { sourceIdx, targetIdx, revisions });
 		}
 	}
-
+	buildOdometryConstraints(pairs, submaps, constraints);
 }
 } // namespace o3d_slam
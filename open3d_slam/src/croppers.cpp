@@ -11,9 +11,12 @@
 #include "open3d_slam/typedefs.hpp"
 
 #include "open3d_slam/Parameters.hpp"
+#include "open3d_slam/point_kernels.hpp"
 #include <utility>
 #include <iostream>
 #include <numeric>
+#include <algorithm>
+#include <limits>
 #ifdef open3d_slam_OPENMP_FOUND
 #include <omp.h>
 #endif
@@ -54,6 +57,22 @@ bool CroppingVolume::isWithinVolume(const Eigen::Vector3d &p) const {
   return isInvertVolume_ ? !isWithinVolumeImpl(p) : isWithinVolumeImpl(p);
 }
 
+void CroppingVolume::computeMaskImpl(const std::vector<Eigen::Vector3d> &points, std::vector<uint8> *mask) const {
+	mask->resize(points.size());
+	for (size_t i = 0; i < points.size(); ++i) {
+		(*mask)[i] = isWithinVolumeImpl(points[i]);
+	}
+}
+
+void CroppingVolume::computeMask(const PointCloud &cloud, std::vector<uint8> *mask) const {
+	computeMaskImpl(cloud.points_, mask);
+	if (isInvertVolume_) {
+		for (auto &m : *mask) {
+			m = !m;
+		}
+	}
+}
+
 void CroppingVolume::setIsInvertVolume(bool val){
   isInvertVolume_ = val;
 }
@@ -64,10 +83,12 @@ void CroppingVolume::setPose(const Eigen::Isometry3d &pose) {
 }
 
 CroppingVolume::Indices CroppingVolume::getIndicesWithinVolume(const PointCloud &cloud) const {
+	std::vector<uint8> mask;
+	computeMask(cloud, &mask);
 	Indices idxs;
-	idxs.reserve(cloud.points_.size());
-	for (size_t i = 0; i < cloud.points_.size(); ++i) {
-		if (isWithinVolume(cloud.points_[i])) {
+	idxs.reserve(std::count(mask.begin(), mask.end(), 1));
+	for (size_t i = 0; i < mask.size(); ++i) {
+		if (mask[i]) {
 			idxs.push_back(i);
 		}
 	}
@@ -76,20 +97,23 @@ CroppingVolume::Indices CroppingVolume::getIndicesWithinVolume(const PointCloud
 
 std::shared_ptr<CroppingVolume::PointCloud> CroppingVolume::crop(const PointCloud &cloud) const {
 	std::shared_ptr<CroppingVolume::PointCloud> cropped(new PointCloud());
-	const int nPoints = cloud.points_.size();
-	cropped->points_.reserve(nPoints);
+	std::vector<uint8> mask;
+	computeMask(cloud, &mask);
+	const size_t nPoints = cloud.points_.size();
+	const size_t nCropped = std::count(mask.begin(), mask.end(), 1);
+	cropped->points_.reserve(nCropped);
 	if (cloud.HasColors()) {
-		cropped->colors_.reserve(nPoints);
+		cropped->colors_.reserve(nCropped);
 	}
 	if (cloud.HasNormals()) {
-		cropped->normals_.reserve(nPoints);
+		cropped->normals_.reserve(nCropped);
 	}
 	if (cloud.HasCovariances()) {
-		cropped->covariances_.reserve(nPoints);
+		cropped->covariances_.reserve(nCropped);
 	}
 
 	for (size_t i = 0; i < nPoints; ++i) {
-		if (isWithinVolume(cloud.points_[i])) {
+		if (mask[i]) {
 			cropped->points_.push_back(cloud.points_[i]);
 			if (cloud.HasColors()) {
 				cropped->colors_.push_back(cloud.colors_[i]);
@@ -127,6 +151,10 @@ bool MinMaxRadiusCroppingVolume::isWithinVolumeImpl(const Eigen::Vector3d &p) co
 	const double d = (p - pose_.translation()).norm();
 	return  d <= radiusMax_ && d >= radiusMin_;
 }
+void MinMaxRadiusCroppingVolume::computeMaskImpl(const std::vector<Eigen::Vector3d> &points,
+		std::vector<uint8> *mask) const {
+	kernels::computeSphericalShellMask(points, pose_.translation(), radiusMin_, radiusMax_, mask);
+}
 void MinMaxRadiusCroppingVolume::setParameters(double radiusMin, double radiusMax) {
 	radiusMin_ = radiusMin;
 	radiusMax_ = radiusMax;
@@ -143,6 +171,11 @@ MaxRadiusCroppingVolume::MaxRadiusCroppingVolume(double radius) :
 bool MaxRadiusCroppingVolume::isWithinVolumeImpl(const Eigen::Vector3d &p) const {
 	return (p - pose_.translation()).norm() <= radius_;
 }
+void MaxRadiusCroppingVolume::computeMaskImpl(const std::vector<Eigen::Vector3d> &points,
+		std::vector<uint8> *mask) const {
+	kernels::computeSphericalShellMask(points, pose_.translation(), std::numeric_limits<double>::lowest(), radius_,
+			mask);
+}
 void MaxRadiusCroppingVolume::setParameters(double radius) {
 	radius_ = radius;
 }
@@ -159,6 +192,12 @@ bool MinRadiusCroppingVolume::isWithinVolumeImpl(const Eigen::Vector3d &p) const
 	return (p - pose_.translation()).norm() >= radius_;
 }
 
+void MinRadiusCroppingVolume::computeMaskImpl(const std::vector<Eigen::Vector3d> &points,
+		std::vector<uint8> *mask) const {
+	kernels::computeSphericalShellMask(points, pose_.translation(), radius_, std::numeric_limits<double>::infinity(),
+			mask);
+}
+
 void MinRadiusCroppingVolume::setParameters(double radius) {
 	radius_ = radius;
 }
@@ -176,6 +215,11 @@ bool CylinderCroppingVolume::isWithinVolumeImpl(const Eigen::Vector3d &p) const
 	return p.z() >= minZ_ && p.z() <= maxZ_ && (p - pose_.translation()).head<2>().norm() <= radius_;
 }
 
+void CylinderCroppingVolume::computeMaskImpl(const std::vector<Eigen::Vector3d> &points,
+		std::vector<uint8> *mask) const {
+	kernels::computeCylinderMask(points, pose_.translation(), radius_, minZ_, maxZ_, mask);
+}
+
 void CylinderCroppingVolume::setParameters(double radius, double minZ, double maxZ) {
 	radius_ = radius;
 	minZ_ = minZ;
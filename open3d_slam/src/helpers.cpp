@@ -12,11 +12,15 @@
 #include "open3d_slam/assert.hpp"
 #include "open3d_slam/croppers.hpp"
 #include "open3d_slam/Voxel.hpp"
+#include "open3d_slam/point_kernels.hpp"
 
 #include <open3d/Open3D.h>
 #include <open3d/pipelines/registration/Registration.h>
 #include <open3d/utility/Eigen.h>
 #include "open3d/geometry/KDTreeFlann.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
 
 #ifdef open3d_slam_OPENMP_FOUND
 #include <omp.h>
@@ -100,12 +104,138 @@ void estimateNormals(int numNearestNeighbours, open3d::geometry::PointCloud *pcl
 	pcl->EstimateNormals(param);
 }
 
+namespace {
+template<typename T>
+void keepSortedIdxs(const std::vector<size_t> &sortedIdxs, std::vector<T> *v) {
+	if (v->empty()) {
+		return;
+	}
+	// idxs are ascending, so idxs[i] >= i and the compaction can be done in place
+	for (size_t i = 0; i < sortedIdxs.size(); ++i) {
+		(*v)[i] = (*v)[sortedIdxs[i]];
+	}
+	v->resize(sortedIdxs.size());
+}
+} // namespace
+
 void randomDownSample(double downSamplingRatio, open3d::geometry::PointCloud *pcl) {
 	if (downSamplingRatio >= 1.0) {
 		return;
 	}
-	auto downSampled = pcl->RandomDownSample(downSamplingRatio);
-	*pcl = std::move(*downSampled);
+	const size_t nPoints = pcl->points_.size();
+	const size_t nSamples = static_cast<size_t>(nPoints * std::max(downSamplingRatio, 0.0));
+	std::vector<size_t> idxs(nPoints);
+	std::iota(idxs.begin(), idxs.end(), 0);
+	// partial fisher yates, only the first nSamples have to be drawn
+	// seeded once per thread, constructing a random_device for every scan is expensive
+	thread_local std::mt19937 rng(std::random_device { }());
+	for (size_t i = 0; i < nSamples; ++i) {
+		std::uniform_int_distribution<size_t> dist(i, nPoints - 1);
+		std::swap(idxs[i], idxs[dist(rng)]);
+	}
+	idxs.resize(nSamples);
+	std::sort(idxs.begin(), idxs.end());
+	keepSortedIdxs(idxs, &pcl->points_);
+	keepSortedIdxs(idxs, &pcl->normals_);
+	keepSortedIdxs(idxs, &pcl->colors_);
+	keepSortedIdxs(idxs, &pcl->covariances_);
+}
+
+std::shared_ptr<open3d::geometry::PointCloud> cropAndVoxelize(const CroppingVolume &croppingVolume, double voxelSize,
+		const open3d::geometry::PointCloud &cloud) {
+	auto output = std::make_shared<open3d::geometry::PointCloud>();
+	std::vector<uint8> mask;
+	croppingVolume.computeMask(cloud, &mask);
+	const bool hasNormals = cloud.HasNormals();
+	const bool hasColors = cloud.HasColors();
+	const bool hasCovariances = cloud.HasCovariances();
+	const size_t nCropped = std::count(mask.begin(), mask.end(), 1);
+	if (voxelSize <= 0.0) {
+		std::vector<size_t> idxs;
+		idxs.reserve(nCropped);
+		for (size_t i = 0; i < mask.size(); ++i) {
+			if (mask[i]) {
+				idxs.push_back(i);
+			}
+		}
+		return cloud.SelectByIndex(idxs);
+	}
+
+	const int nPoints = cloud.points_.size();
+	const InverseVoxelSize invVoxelSize = fromVoxelSize(Eigen::Vector3d::Constant(voxelSize));
+	std::vector<Eigen::Vector3i> keys(nPoints);
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < nPoints; ++i) {
+		if (mask[i]) {
+			keys[i] = getVoxelIdx(cloud.points_[i], invVoxelSize);
+		}
+	}
+
+	// one hash lookup per point, voxels get their output slot in the order they are first seen
+	RobinHoodHashMap<Eigen::Vector3i, uint32, EigenVec3iHash> voxelToOutputIdx(nCropped);
+	std::vector<uint32> numPointsInVoxel;
+	numPointsInVoxel.reserve(nCropped);
+	output->points_.reserve(nCropped);
+	if (hasNormals) {
+		output->normals_.reserve(nCropped);
+	}
+	if (hasColors) {
+		output->colors_.reserve(nCropped);
+	}
+	if (hasCovariances) {
+		output->covariances_.reserve(nCropped);
+	}
+	for (int i = 0; i < nPoints; ++i) {
+		if (!mask[i]) {
+			continue;
+		}
+		const auto inserted = voxelToOutputIdx.insert(std::make_pair(keys[i], static_cast<uint32>(numPointsInVoxel.size())));
+		const uint32 idx = inserted.first->second;
+		if (inserted.second) {
+			numPointsInVoxel.push_back(0);
+			output->points_.push_back(Eigen::Vector3d::Zero());
+			if (hasNormals) {
+				output->normals_.push_back(Eigen::Vector3d::Zero());
+			}
+			if (hasColors) {
+				output->colors_.push_back(Eigen::Vector3d::Zero());
+			}
+			if (hasCovariances) {
+				output->covariances_.push_back(Eigen::Matrix3d::Zero());
+			}
+		}
+		++numPointsInVoxel[idx];
+		output->points_[idx] += cloud.points_[i];
+		if (hasNormals) {
+			output->normals_[idx] += cloud.normals_[i];
+		}
+		if (hasColors) {
+			output->colors_[idx] += cloud.colors_[i];
+		}
+		if (hasCovariances) {
+			output->covariances_[idx] += cloud.covariances_[i];
+		}
+	}
+
+	const int nVoxels = numPointsInVoxel.size();
+#pragma omp parallel for schedule(static)
+	for (int j = 0; j < nVoxels; ++j) {
+		const double invNumPoints = 1.0 / numPointsInVoxel[j];
+		output->points_[j] *= invNumPoints;
+		if (hasNormals) {
+			const double norm = output->normals_[j].norm();
+			if (norm > 0.0) {
+				output->normals_[j] /= norm;
+			}
+		}
+		if (hasColors) {
+			output->colors_[j] *= invNumPoints;
+		}
+		if (hasCovariances) {
+			output->covariances_[j] *= invNumPoints;
+		}
+	}
+	return output;
 }
 void voxelize(double voxelSize, open3d::geometry::PointCloud *pcl) {
 	if (voxelSize <= 0) {
@@ -133,7 +263,7 @@ std::shared_ptr<open3d::geometry::PointCloud> voxelizeWithinCroppingVolume(doubl
 //	if (voxel_size * std::numeric_limits<int>::max() < (voxelMaxBound - voxelMinBound).maxCoeff()) {
 //		throw std::runtime_error("[VoxelDownSample] voxel_size is too small.");
 //	}
-	std::unordered_map<Eigen::Vector3i, AccumulatedPoint, EigenVec3iHash> voxelindex_to_accpoint;
+	RobinHoodHashMap<Eigen::Vector3i, AccumulatedPoint, EigenVec3iHash> voxelindex_to_accpoint;
 
 	const bool has_normals = cloud.HasNormals();
 	const bool has_colors = cloud.HasColors();
@@ -169,7 +299,7 @@ std::shared_ptr<open3d::geometry::PointCloud> voxelizeWithinCroppingVolume(doubl
 		}
 	}
 
-	for (auto accpoint : voxelindex_to_accpoint) {
+	for (const auto &accpoint : voxelindex_to_accpoint) {
 		output->points_.emplace_back(std::move(accpoint.second.GetAveragePoint()));
 		if (has_normals) {
 			output->normals_.emplace_back(std::move(accpoint.second.GetAverageNormal().normalized()));
@@ -244,39 +374,72 @@ std::vector<size_t> getIdxsOfCarvedPoints(const open3d::geometry::PointCloud &sc
 		const open3d::geometry::PointCloud &cloud, const Eigen::Vector3d &sensorPosition,
 		const std::vector<size_t> &cloudIdxsSubset, const SpaceCarvingParameters &param) {
 
-	const double stepSize = param.voxelSize_;
-	const std::string layer = "layer";
-  VoxelMap voxelMap(Eigen::Vector3d::Constant(param.voxelSize_));
+	const VoxelMap::LayerId layer = 0;
+	// reused between the calls, so that the voxel map does not allocate in the steady state
+	thread_local VoxelMap threadVoxelMap;
+	// the omp workers would each see their own, empty, thread local instance, hence bind it here
+	VoxelMap &voxelMap = threadVoxelMap;
+	const Eigen::Vector3d voxelSize = Eigen::Vector3d::Constant(param.voxelSize_);
+	const InverseVoxelSize inverseVoxelSize = fromVoxelSize(voxelSize);
+	voxelMap.reset(voxelSize);
 	voxelMap.insertCloud(layer, cloud, cloudIdxsSubset);
-	std::unordered_set<size_t> setOfIdsToRemove;
-	setOfIdsToRemove.reserve(scan.points_.size());
+	const bool isCheckNormals = cloud.HasNormals();
+
+	// every thread marks the removed points in its own bitset, they are or-ed at the end
+	constexpr size_t kBitsPerWord = 64;
+	const size_t numWords = (cloud.points_.size() + kBitsPerWord - 1) / kBitsPerWord;
+#ifdef open3d_slam_OPENMP_FOUND
+	const int numThreads = omp_get_max_threads();
+#else
+	const int numThreads = 1;
+#endif
+	std::vector<std::vector<uint64>> isRemoved(numThreads);
+	const int nScanPoints = scan.points_.size();
+#pragma omp parallel num_threads(numThreads)
+	{
+#ifdef open3d_slam_OPENMP_FOUND
+		std::vector<uint64> &isRemovedThread = isRemoved[omp_get_thread_num()];
+#else
+		std::vector<uint64> &isRemovedThread = isRemoved[0];
+#endif
+		isRemovedThread.assign(numWords, 0);
+#pragma omp for schedule(static)
+		for (int i = 0; i < nScanPoints; ++i) {
+			const Eigen::Vector3d &p = scan.points_[i];
+			const double length = (p - sensorPosition).norm();
+			const Eigen::Vector3d direction = (p - sensorPosition) / length;
+			const double maximalPathTraveled = std::max(param.voxelSize_,
+					std::min(length - param.truncationDistance_, param.maxRaytracingLength_));
+			traverseVoxelsAlongRay(sensorPosition, sensorPosition + maximalPathTraveled * direction, voxelSize,
+					inverseVoxelSize, [&](const Eigen::Vector3i &key) {
+						for (const size_t id : voxelMap.getIndicesInVoxel(layer, key)) {
+							uint64 &word = isRemovedThread[id / kBitsPerWord];
+							const uint64 bit = uint64(1) << (id % kBitsPerWord);
+							if ((word & bit) != 0) {
+								continue;
+							}
+							if (!isCheckNormals
+									|| std::abs(direction.dot(cloud.normals_[id].normalized())) > param.minDotProductWithNormal_) {
+								word |= bit;
+							}
+						}
+					});
+		}
+	}
+
+	std::vector<uint64> isRemovedMerged(numWords, 0);
 #pragma omp parallel for schedule(static)
-	for (size_t i = 0; i < scan.points_.size(); ++i) {
-		const Eigen::Vector3d &p = scan.points_[i];
-		const double length = (p - sensorPosition).norm();
-		const Eigen::Vector3d direction = (p - sensorPosition) / length;
-		double distance = 0.0;
-		const double maximalPathTraveled = std::max(param.voxelSize_,
-				std::min(length - param.truncationDistance_, param.maxRaytracingLength_));
-		while (distance < maximalPathTraveled) {
-			const Eigen::Vector3d currentPosition = distance * direction + sensorPosition;
-			auto ids = voxelMap.getIndicesInVoxel(layer, currentPosition);
-			for (const auto id : ids) {
-				bool isRemoveId = true;
-				if (cloud.HasNormals()) {
-					const auto n = cloud.normals_[id].normalized();
-					isRemoveId = std::abs(direction.dot(n)) > param.minDotProductWithNormal_;
-				}
-				if (isRemoveId) {
-#pragma omp critical
-					setOfIdsToRemove.insert(id);
-				}
-			}
-			distance += stepSize;
+	for (size_t w = 0; w < numWords; ++w) {
+		for (const auto &isRemovedThread : isRemoved) {
+			isRemovedMerged[w] |= isRemovedThread[w];
 		}
 	}
 	std::vector<size_t> vecOfIdsToRemove;
-	vecOfIdsToRemove.insert(vecOfIdsToRemove.end(), setOfIdsToRemove.begin(), setOfIdsToRemove.end());
+	for (size_t w = 0; w < numWords; ++w) {
+		for (uint64 word = isRemovedMerged[w]; word != 0; word &= word - 1) {
+			vecOfIdsToRemove.push_back(w * kBitsPerWord + __builtin_ctzll(word));
+		}
+	}
 	return vecOfIdsToRemove;
 }
 
@@ -287,30 +450,37 @@ std::shared_ptr<open3d::geometry::PointCloud> transform(const Eigen::Matrix4d &T
 	const auto isIdentity = (T - Eigen::Matrix4d::Identity()).array().abs().maxCoeff() < 1e-4;
 	if (isIdentity) {
 		*out = cloud;
+		return out;
 	}
 
-	out->points_.reserve(cloud.points_.size());
 	out->colors_ = cloud.colors_;
-	if (cloud.HasNormals()) {
-		out->normals_.reserve(cloud.points_.size());
+	const Eigen::Matrix3d R = T.block<3, 3>(0, 0);
+	const bool isAffine = T.row(3) == Eigen::RowVector4d(0.0, 0.0, 0.0, 1.0);
+	if (isAffine) {
+		kernels::affineTransform(R, T.block<3, 1>(0, 3), cloud.points_, &out->points_);
+		if (cloud.HasNormals()) {
+			kernels::affineTransform(R, Eigen::Vector3d::Zero(), cloud.normals_, &out->normals_);
+		}
+	} else {
+		out->points_.reserve(cloud.points_.size());
+		if (cloud.HasNormals()) {
+			out->normals_.reserve(cloud.points_.size());
+		}
+		for (size_t i = 0; i < cloud.points_.size(); ++i) {
+			const auto &p = cloud.points_[i];
+			Eigen::Vector4d new_point = T * Eigen::Vector4d(p(0), p(1), p(2), 1.0);
+			out->points_.emplace_back(new_point.head<3>() / new_point(3));
+			if (cloud.HasNormals()) {
+				const auto &n = cloud.normals_[i];
+				Eigen::Vector4d new_normal = T * Eigen::Vector4d(n(0), n(1), n(2), 0.0);
+				out->normals_.emplace_back(new_normal.head<3>());
+			}
+		}
 	}
 	if (cloud.HasCovariances()) {
 		out->covariances_.reserve(cloud.points_.size());
-	}
-	for (size_t i = 0; i < cloud.points_.size(); ++i) {
-		const auto &p = cloud.points_[i];
-		Eigen::Vector4d new_point = T * Eigen::Vector4d(p(0), p(1), p(2), 1.0);
-		Eigen::Vector3d xyz = new_point.head<3>() / new_point(3);
-		out->points_.emplace_back(std::move(xyz));
-		if (cloud.HasNormals()) {
-			const auto &n = cloud.normals_[i];
-			Eigen::Vector4d new_normal = T * Eigen::Vector4d(n(0), n(1), n(2), 0.0);
-			out->normals_.emplace_back(std::move(new_normal.head<3>()));
-		}
-		if (cloud.HasCovariances()) {
-			const auto &cov = cloud.covariances_[i];
-			const Eigen::Matrix3d R = T.block<3, 3>(0, 0);
-			out->covariances_.emplace_back(std::move(R * cov * R.transpose()));
+		for (const auto &cov : cloud.covariances_) {
+			out->covariances_.emplace_back(R * cov * R.transpose());
 		}
 	}
 	return out;
@@ -321,9 +491,10 @@ void computeIndicesOfOverlappingPoints(const open3d::geometry::PointCloud &sourc
 		const open3d::geometry::PointCloud &target, const Transform &sourceToTarget, double voxelSize,
 		size_t minNumPointsPerVoxel, std::vector<size_t> *idxsSource, std::vector<size_t> *idxsTarget) {
 	assert_ge<size_t>(minNumPointsPerVoxel, 1);
-	const std::string targetLayer = "target";
-	const std::string sourceLayer = "source";
-	VoxelMap voxelMap(Eigen::Vector3d::Constant(voxelSize));
+	const VoxelMap::LayerId targetLayer = 0;
+	const VoxelMap::LayerId sourceLayer = 1;
+	thread_local VoxelMap voxelMap;
+	voxelMap.reset(Eigen::Vector3d::Constant(voxelSize));
 	voxelMap.insertCloud(targetLayer, target);
 	auto sourceTransformed = source;
 	sourceTransformed.Transform(sourceToTarget.matrix());
@@ -332,11 +503,9 @@ void computeIndicesOfOverlappingPoints(const open3d::geometry::PointCloud &sourc
 	idxsSource->reserve(source.points_.size());
 	idxsTarget->clear();
 	idxsTarget->reserve(target.points_.size());
-	const auto &voxels = voxelMap.voxels_;
-	for (auto it = voxels.cbegin(); it != voxels.cend(); ++it) {
-		const auto voxelKey = it->first;
-		const auto sourceIdxs = voxelMap.getIndicesInVoxel(sourceLayer, voxelKey);
-		const auto targetIdxs = voxelMap.getIndicesInVoxel(targetLayer, voxelKey);
+	for (const auto &voxel : voxelMap.voxels_) {
+		const auto sourceIdxs = voxelMap.getIndicesInVoxel(sourceLayer, voxel.second);
+		const auto targetIdxs = voxelMap.getIndicesInVoxel(targetLayer, voxel.second);
 		if (sourceIdxs.size() >= minNumPointsPerVoxel && targetIdxs.size() >= minNumPointsPerVoxel) {
 			idxsTarget->insert(idxsTarget->end(), targetIdxs.begin(), targetIdxs.end());
 			idxsSource->insert(idxsSource->end(), sourceIdxs.begin(), sourceIdxs.end());
@@ -362,40 +531,6 @@ double getMapVoxelSize(const MapBuilderParameters &p, double valueIfZero) {
 
 
 
-std::vector<Eigen::Vector3i> getKeysOfCarvedPoints(const open3d::geometry::PointCloud &scan,
-    const VoxelizedPointCloud &cloud, const Eigen::Vector3d &sensorPosition, const SpaceCarvingParameters &param) {
-
-  const double stepSize = 2.0 * param.neighborhoodRadiusDenseMap_;
-  std::unordered_set<Eigen::Vector3i, EigenVec3iHash> setOfIdsToRemove;
-  setOfIdsToRemove.reserve(scan.points_.size());
-#pragma omp parallel for schedule(static)
-  for (size_t i = 0; i < scan.points_.size(); ++i) {
-    const Eigen::Vector3d &p = scan.points_[i];
-    const double length = (p - sensorPosition).norm();
-    const Eigen::Vector3d direction = (p - sensorPosition) / length;
-    double distance = 0.0;
-    const double maximalPathTraveled = std::max(stepSize,
-        std::min(length - param.truncationDistance_, param.maxRaytracingLength_));
-    while (distance < maximalPathTraveled) {
-      const Eigen::Vector3d currentPosition = distance * direction + sensorPosition;
-      const auto voxelsToBeFlushed = getVoxelsWithinPointNeighborhood(currentPosition,
-          param.neighborhoodRadiusDenseMap_, cloud.getVoxelSize());
-      //todo also check the dot product
-      for (const auto &key : voxelsToBeFlushed) {
-        if (cloud.hasVoxelWithKey(key)) {
-#pragma omp critical
-          setOfIdsToRemove.insert(key);
-        }
-      }
-
-      distance += stepSize;
-    }
-  }
-  std::vector<Eigen::Vector3i> vecOfIdsToRemove;
-  vecOfIdsToRemove.insert(vecOfIdsToRemove.end(), setOfIdsToRemove.begin(), setOfIdsToRemove.end());
-  return vecOfIdsToRemove;
-}
-
 Eigen::Vector3d computeCenter(const VoxelizedPointCloud &voxels) {
 	Eigen::Vector3d center = Eigen::Vector3d::Zero();
 	int n = 0;
@@ -415,5 +550,25 @@ std::shared_ptr<PointCloud> removePointsWithNonFiniteValues(const PointCloud &cl
 	return filtered;
 }
 
+std::shared_ptr<PointCloud> removePointsWithNonFiniteValues(const PointCloud &cloud,
+		std::vector<float> *pointTimeOffsets) {
+	const bool isHasNormals = cloud.HasNormals();
+	std::vector<size_t> finiteIdxs;
+	finiteIdxs.reserve(cloud.points_.size());
+	for (size_t i = 0; i < cloud.points_.size(); ++i) {
+		if (cloud.points_[i].allFinite() && (!isHasNormals || cloud.normals_[i].allFinite())) {
+			finiteIdxs.push_back(i);
+		}
+	}
+	if (finiteIdxs.size() == cloud.points_.size()) {
+		return std::make_shared<PointCloud>(cloud);
+	}
+	for (size_t i = 0; i < finiteIdxs.size(); ++i) {
+		(*pointTimeOffsets)[i] = (*pointTimeOffsets)[finiteIdxs[i]];
+	}
+	pointTimeOffsets->resize(finiteIdxs.size());
+	return cloud.SelectByIndex(finiteIdxs);
+}
+
 } /* namespace o3d_slam */
 
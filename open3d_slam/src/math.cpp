@@ -72,4 +72,20 @@ double calcStandardDeviation(const std::vector<double> &data) {
 	return std::sqrt(stdDev / (n - 1));
 }
 
+Eigen::Vector3d normalFromCovariance(const Eigen::Matrix3d &covariance) {
+	const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+	return solver.eigenvectors().col(0);
+}
+
+Eigen::Vector3d orientNormalTowardsViewpoint(const Eigen::Vector3d &normal, const Eigen::Vector3d &point,
+		const Eigen::Vector3d &viewpoint) {
+	const Eigen::Vector3d towardsViewpoint = viewpoint - point;
+	const double norm = normal.norm();
+	if (norm == 0.0) {
+		return towardsViewpoint.norm() == 0.0 ? Eigen::Vector3d::UnitZ() : towardsViewpoint.normalized();
+	}
+	const Eigen::Vector3d n = normal / norm;
+	return n.dot(towardsViewpoint) < 0.0 ? Eigen::Vector3d(-n) : n;
+}
+
 } /* namespace o3d_slam */
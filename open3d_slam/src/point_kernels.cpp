@@ -0,0 +1,207 @@
+/*
+ * point_kernels.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/point_kernels.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define open3d_slam_AVX_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace o3d_slam {
+namespace kernels {
+
+namespace {
+
+static_assert(sizeof(Eigen::Vector3d) == 3 * sizeof(double), "points have to be tightly packed");
+
+// keeps the sign, so that comparing squared distances with a negative radius gives the same answer as before squaring
+double signedSquare(double x) {
+	return x * std::abs(x);
+}
+
+void affineTransformScalar(const Eigen::Matrix3d &A, const Eigen::Vector3d &t, const std::vector<Eigen::Vector3d> &in,
+		size_t begin, std::vector<Eigen::Vector3d> *out) {
+	for (size_t i = begin; i < in.size(); ++i) {
+		const double x = in[i].x(), y = in[i].y(), z = in[i].z();
+		(*out)[i] = Eigen::Vector3d(A(0, 0) * x + A(0, 1) * y + A(0, 2) * z + t.x(),
+				A(1, 0) * x + A(1, 1) * y + A(1, 2) * z + t.y(), A(2, 0) * x + A(2, 1) * y + A(2, 2) * z + t.z());
+	}
+}
+
+void computeSphericalShellMaskScalar(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center,
+		double minSquared, double maxSquared, size_t begin, std::vector<uint8> *mask) {
+	for (size_t i = begin; i < points.size(); ++i) {
+		const double dx = points[i].x() - center.x(), dy = points[i].y() - center.y(), dz = points[i].z() - center.z();
+		const double d2 = dx * dx + dy * dy + dz * dz;
+		(*mask)[i] = d2 >= minSquared && d2 <= maxSquared;
+	}
+}
+
+void computeCylinderMaskScalar(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center,
+		double radiusSquared, double minZ, double maxZ, size_t begin, std::vector<uint8> *mask) {
+	for (size_t i = begin; i < points.size(); ++i) {
+		const double dx = points[i].x() - center.x(), dy = points[i].y() - center.y();
+		const double d2 = dx * dx + dy * dy;
+		(*mask)[i] = points[i].z() >= minZ && points[i].z() <= maxZ && d2 <= radiusSquared;
+	}
+}
+
+#ifdef open3d_slam_AVX_KERNELS
+
+// four xyz points are three registers: a = [x0 y0 z0 x1], b = [y1 z1 x2 y2], c = [z2 x3 y3 z3]
+__attribute__((target("avx")))
+inline void load4(const double *p, __m256d *x, __m256d *y, __m256d *z) {
+	const __m256d a = _mm256_loadu_pd(p);
+	const __m256d b = _mm256_loadu_pd(p + 4);
+	const __m256d c = _mm256_loadu_pd(p + 8);
+	const __m256d lo = _mm256_permute2f128_pd(a, c, 0x30); // x0 y0 y3 z3
+	const __m256d mid = _mm256_permute2f128_pd(a, c, 0x21); // z0 x1 z2 x3
+	*x = _mm256_blend_pd(_mm256_blend_pd(lo, mid, 0b1010), b, 0b0100);
+	*y = _mm256_permute_pd(_mm256_blend_pd(lo, b, 0b1001), 0b0101);
+	*z = _mm256_blend_pd(_mm256_blend_pd(mid, b, 0b0010), lo, 0b1000);
+}
+
+__attribute__((target("avx")))
+inline void store4(double *p, __m256d x, __m256d y, __m256d z) {
+	const __m256d ySwapped = _mm256_permute_pd(y, 0b0101); // y1 y0 y3 y2
+	const __m256d lo = _mm256_blend_pd(_mm256_blend_pd(x, ySwapped, 0b0110), z, 0b1000); // x0 y0 y3 z3
+	const __m256d mid = _mm256_blend_pd(z, x, 0b1010); // z0 x1 z2 x3
+	const __m256d b = _mm256_blend_pd(_mm256_blend_pd(ySwapped, z, 0b0010), x, 0b0100); // y1 z1 x2 y2
+	_mm256_storeu_pd(p, _mm256_permute2f128_pd(lo, mid, 0x20));
+	_mm256_storeu_pd(p + 4, b);
+	_mm256_storeu_pd(p + 8, _mm256_permute2f128_pd(mid, lo, 0x31));
+}
+
+__attribute__((target("avx")))
+inline void storeMask4(int bits, uint8 *mask) {
+	mask[0] = bits & 1;
+	mask[1] = (bits >> 1) & 1;
+	mask[2] = (bits >> 2) & 1;
+	mask[3] = (bits >> 3) & 1;
+}
+
+__attribute__((target("avx")))
+size_t affineTransformAvx(const Eigen::Matrix3d &A, const Eigen::Vector3d &t, const std::vector<Eigen::Vector3d> &in,
+		std::vector<Eigen::Vector3d> *out) {
+	const size_t nBlocks = in.size() / 4 * 4;
+	const __m256d a00 = _mm256_set1_pd(A(0, 0)), a01 = _mm256_set1_pd(A(0, 1)), a02 = _mm256_set1_pd(A(0, 2));
+	const __m256d a10 = _mm256_set1_pd(A(1, 0)), a11 = _mm256_set1_pd(A(1, 1)), a12 = _mm256_set1_pd(A(1, 2));
+	const __m256d a20 = _mm256_set1_pd(A(2, 0)), a21 = _mm256_set1_pd(A(2, 1)), a22 = _mm256_set1_pd(A(2, 2));
+	const __m256d tx = _mm256_set1_pd(t.x()), ty = _mm256_set1_pd(t.y()), tz = _mm256_set1_pd(t.z());
+	const double *src = reinterpret_cast<const double*>(in.data());
+	double *dst = reinterpret_cast<double*>(out->data());
+	for (size_t i = 0; i < nBlocks; i += 4) {
+		__m256d x, y, z;
+		load4(src + 3 * i, &x, &y, &z);
+		const __m256d xo = _mm256_add_pd(
+				_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a00, x), _mm256_mul_pd(a01, y)), _mm256_mul_pd(a02, z)), tx);
+		const __m256d yo = _mm256_add_pd(
+				_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a10, x), _mm256_mul_pd(a11, y)), _mm256_mul_pd(a12, z)), ty);
+		const __m256d zo = _mm256_add_pd(
+				_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a20, x), _mm256_mul_pd(a21, y)), _mm256_mul_pd(a22, z)), tz);
+		store4(dst + 3 * i, xo, yo, zo);
+	}
+	return nBlocks;
+}
+
+__attribute__((target("avx")))
+size_t computeSphericalShellMaskAvx(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center,
+		double minSquared, double maxSquared, std::vector<uint8> *mask) {
+	const size_t nBlocks = points.size() / 4 * 4;
+	const __m256d cx = _mm256_set1_pd(center.x()), cy = _mm256_set1_pd(center.y()), cz = _mm256_set1_pd(center.z());
+	const __m256d lower = _mm256_set1_pd(minSquared), upper = _mm256_set1_pd(maxSquared);
+	const double *src = reinterpret_cast<const double*>(points.data());
+	for (size_t i = 0; i < nBlocks; i += 4) {
+		__m256d x, y, z;
+		load4(src + 3 * i, &x, &y, &z);
+		const __m256d dx = _mm256_sub_pd(x, cx), dy = _mm256_sub_pd(y, cy), dz = _mm256_sub_pd(z, cz);
+		const __m256d d2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+				_mm256_mul_pd(dz, dz));
+		const __m256d isInside = _mm256_and_pd(_mm256_cmp_pd(d2, lower, _CMP_GE_OQ),
+				_mm256_cmp_pd(d2, upper, _CMP_LE_OQ));
+		storeMask4(_mm256_movemask_pd(isInside), mask->data() + i);
+	}
+	return nBlocks;
+}
+
+__attribute__((target("avx")))
+size_t computeCylinderMaskAvx(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center,
+		double radiusSquared, double minZ, double maxZ, std::vector<uint8> *mask) {
+	const size_t nBlocks = points.size() / 4 * 4;
+	const __m256d cx = _mm256_set1_pd(center.x()), cy = _mm256_set1_pd(center.y());
+	const __m256d r2 = _mm256_set1_pd(radiusSquared);
+	const __m256d lower = _mm256_set1_pd(minZ), upper = _mm256_set1_pd(maxZ);
+	const double *src = reinterpret_cast<const double*>(points.data());
+	for (size_t i = 0; i < nBlocks; i += 4) {
+		__m256d x, y, z;
+		load4(src + 3 * i, &x, &y, &z);
+		const __m256d dx = _mm256_sub_pd(x, cx), dy = _mm256_sub_pd(y, cy);
+		const __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+		const __m256d isWithinZ = _mm256_and_pd(_mm256_cmp_pd(z, lower, _CMP_GE_OQ), _mm256_cmp_pd(z, upper, _CMP_LE_OQ));
+		const __m256d isInside = _mm256_and_pd(isWithinZ, _mm256_cmp_pd(d2, r2, _CMP_LE_OQ));
+		storeMask4(_mm256_movemask_pd(isInside), mask->data() + i);
+	}
+	return nBlocks;
+}
+
+#endif
+
+} // namespace
+
+bool isAvxEnabled() {
+#ifdef open3d_slam_AVX_KERNELS
+	static const bool isSupported = __builtin_cpu_supports("avx");
+	return isSupported;
+#else
+	return false;
+#endif
+}
+
+void affineTransform(const Eigen::Matrix3d &A, const Eigen::Vector3d &t, const std::vector<Eigen::Vector3d> &in,
+		std::vector<Eigen::Vector3d> *out) {
+	out->resize(in.size());
+	size_t begin = 0;
+#ifdef open3d_slam_AVX_KERNELS
+	if (isAvxEnabled()) {
+		begin = affineTransformAvx(A, t, in, out);
+	}
+#endif
+	affineTransformScalar(A, t, in, begin, out);
+}
+
+void computeSphericalShellMask(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center,
+		double minRadius, double maxRadius, std::vector<uint8> *mask) {
+	mask->resize(points.size());
+	const double minSquared = signedSquare(minRadius);
+	const double maxSquared = signedSquare(maxRadius);
+	size_t begin = 0;
+#ifdef open3d_slam_AVX_KERNELS
+	if (isAvxEnabled()) {
+		begin = computeSphericalShellMaskAvx(points, center, minSquared, maxSquared, mask);
+	}
+#endif
+	computeSphericalShellMaskScalar(points, center, minSquared, maxSquared, begin, mask);
+}
+
+void computeCylinderMask(const std::vector<Eigen::Vector3d> &points, const Eigen::Vector3d &center, double radius,
+		double minZ, double maxZ, std::vector<uint8> *mask) {
+	mask->resize(points.size());
+	const double radiusSquared = signedSquare(radius);
+	size_t begin = 0;
+#ifdef open3d_slam_AVX_KERNELS
+	if (isAvxEnabled()) {
+		begin = computeCylinderMaskAvx(points, center, radiusSquared, minZ, maxZ, mask);
+	}
+#endif
+	computeCylinderMaskScalar(points, center, radiusSquared, minZ, maxZ, begin, mask);
+}
+
+} // namespace kernels
+} // namespace o3d_slam
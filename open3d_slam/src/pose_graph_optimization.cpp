@@ -0,0 +1,297 @@
+/*
+ * pose_graph_optimization.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/pose_graph_optimization.hpp"
+#include "open3d_slam/assert.hpp"
+
+#include <Eigen/Dense>
+#include <Eigen/SparseCholesky>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace o3d_slam {
+
+namespace {
+namespace registration = open3d::pipelines::registration;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using SparseMatrix = Eigen::SparseMatrix<double>;
+
+const int kMaxLambdaIncreases = 20;
+
+// residual of one edge and its jacobians w.r.t. the tangent space increments of the source and
+// target pose. The increments are applied on the right, i.e. T <- T * exp(delta), delta = [omega; v]
+struct EdgeLinearization {
+	Vector6d residual_;
+	Matrix6d jacobianTarget_; // jacobian w.r.t. the source is identity
+};
+
+Eigen::Matrix3d skew(const Eigen::Vector3d &v) {
+	Eigen::Matrix3d m;
+	m << 0.0, -v.z(), v.y(), v.z(), 0.0, -v.x(), -v.y(), v.x(), 0.0;
+	return m;
+}
+
+Matrix6d adjoint(const Eigen::Matrix4d &T) {
+	Matrix6d ad = Matrix6d::Zero();
+	const Eigen::Matrix3d R = T.topLeftCorner<3, 3>();
+	ad.topLeftCorner<3, 3>() = R;
+	ad.bottomLeftCorner<3, 3>() = skew(T.block<3, 1>(0, 3)) * R;
+	ad.bottomRightCorner<3, 3>() = R;
+	return ad;
+}
+
+Eigen::Matrix4d inverseRigid(const Eigen::Matrix4d &T) {
+	Eigen::Matrix4d inv = Eigen::Matrix4d::Identity();
+	inv.topLeftCorner<3, 3>() = T.topLeftCorner<3, 3>().transpose();
+	inv.block<3, 1>(0, 3) = -inv.topLeftCorner<3, 3>() * T.block<3, 1>(0, 3);
+	return inv;
+}
+
+// rotation vector and translation of X^-1 * Tt^-1 * Ts, zero when the edge is satisfied
+Vector6d computeResidual(const registration::PoseGraphEdge &e, const registration::PoseGraph &graph) {
+	const Eigen::Matrix4d &Ts = graph.nodes_[e.source_node_id_].pose_;
+	const Eigen::Matrix4d &Tt = graph.nodes_[e.target_node_id_].pose_;
+	const Eigen::Matrix4d error = inverseRigid(e.transformation_) * inverseRigid(Tt) * Ts;
+	const Eigen::AngleAxisd angleAxis(Eigen::Matrix3d(error.topLeftCorner<3, 3>()));
+	Vector6d r;
+	r.head<3>() = angleAxis.angle() * angleAxis.axis();
+	r.tail<3>() = error.block<3, 1>(0, 3);
+	return r;
+}
+
+void retract(const Vector6d &delta, Eigen::Matrix4d *T) {
+	const double angle = delta.head<3>().norm();
+	const Eigen::Matrix3d R = T->topLeftCorner<3, 3>();
+	if (angle > 1e-12) {
+		T->topLeftCorner<3, 3>() = R * Eigen::AngleAxisd(angle, delta.head<3>() / angle).toRotationMatrix();
+	}
+	T->block<3, 1>(0, 3) += R * delta.tail<3>();
+}
+
+// see ComputeLineProcessWeight in open3d, Section 5 in [Choi et al 2015]
+double computeLineProcessWeight(const registration::PoseGraph &graph,
+		const registration::GlobalOptimizationOption &option) {
+	if (graph.edges_.empty()) {
+		return 0.0;
+	}
+	double averageNumberOfCorrespondences = 0.0;
+	for (const auto &e : graph.edges_) {
+		averageNumberOfCorrespondences += e.information_(5, 5);
+	}
+	averageNumberOfCorrespondences /= static_cast<double>(graph.edges_.size());
+	return option.preference_loop_closure_ * option.max_correspondence_distance_ * option.max_correspondence_distance_
+			* averageNumberOfCorrespondences;
+}
+
+class SparseLevenbergMarquardt {
+
+public:
+	SparseLevenbergMarquardt(const registration::GlobalOptimizationConvergenceCriteria &criteria,
+			int referenceNode, double lineProcessWeight, registration::PoseGraph *graph) :
+			criteria_(criteria), referenceNode_(referenceNode), lineProcessWeight_(lineProcessWeight), graph_(graph) {
+		const int nNodes = static_cast<int>(graph_->nodes_.size());
+		variableIdx_.resize(nNodes, -1);
+		int nVariables = 0;
+		for (int i = 0; i < nNodes; ++i) {
+			if (i != referenceNode_) {
+				variableIdx_[i] = nVariables++;
+			}
+		}
+		dimension_ = 6 * nVariables;
+		for (const auto &e : graph_->edges_) {
+			assert_true(e.source_node_id_ >= 0 && e.source_node_id_ < nNodes && e.target_node_id_ >= 0
+							&& e.target_node_id_ < nNodes && e.source_node_id_ != e.target_node_id_,
+					"Pose graph edge between invalid nodes: " + std::to_string(e.source_node_id_) + " and "
+							+ std::to_string(e.target_node_id_));
+		}
+	}
+
+	void optimize() {
+		if (dimension_ == 0 || graph_->edges_.empty()) {
+			return;
+		}
+		double cost = computeCost(*graph_);
+		double lambda = -1.0;
+		bool isPatternAnalyzed = false;
+		std::vector<registration::PoseGraphNode> candidateNodes;
+		for (int iter = 0; iter < criteria_.max_iteration_; ++iter) {
+			updateConfidences();
+			buildLinearSystem();
+			if (b_.lpNorm<Eigen::Infinity>() < criteria_.min_right_term_ || cost < criteria_.min_residual_) {
+				break;
+			}
+			if (lambda < 0.0) {
+				lambda = 1e-5 * std::max(H_.diagonal().maxCoeff(), 1e-12);
+			}
+			if (!isPatternAnalyzed) {
+				// the structure of H does not change between iterations
+				solver_.analyzePattern(H_);
+				isPatternAnalyzed = true;
+			}
+			bool isStepAccepted = false;
+			double newCost = cost;
+			Eigen::VectorXd delta;
+			for (int j = 0; j < kMaxLambdaIncreases && !isStepAccepted; ++j) {
+				SparseMatrix damped = H_;
+				for (int k = 0; k < dimension_; ++k) {
+					damped.coeffRef(k, k) += lambda * std::max(H_.coeff(k, k), 1e-12);
+				}
+				solver_.factorize(damped);
+				if (solver_.info() == Eigen::Success) {
+					delta = solver_.solve(-b_);
+					candidateNodes = graph_->nodes_;
+					applyIncrement(delta, &candidateNodes);
+					std::swap(candidateNodes, graph_->nodes_);
+					newCost = computeCost(*graph_);
+					isStepAccepted = newCost < cost;
+					if (!isStepAccepted) {
+						std::swap(candidateNodes, graph_->nodes_);
+					}
+				}
+				lambda *= isStepAccepted ? criteria_.lower_scale_factor_ : 1.0 / criteria_.upper_scale_factor_;
+			}
+			if (!isStepAccepted) {
+				break;
+			}
+			const double relativeResidualIncrement = (cost - newCost) / cost;
+			cost = newCost;
+			if (delta.norm() < criteria_.min_relative_increment_ * (stateNorm() + criteria_.min_relative_increment_)
+					|| relativeResidualIncrement < criteria_.min_relative_residual_increment_) {
+				break;
+			}
+		}
+		updateConfidences();
+	}
+
+private:
+
+	// uncertain edges are weighted by the line process, the squared residual of an edge
+	// with the confidence l minimized out is lineProcessWeight * s / (lineProcessWeight + s)
+	double computeCost(const registration::PoseGraph &graph) const {
+		double cost = 0.0;
+		for (const auto &e : graph.edges_) {
+			const Vector6d r = computeResidual(e, graph);
+			const double s = r.dot(e.information_ * r);
+			cost += e.uncertain_ ? lineProcessWeight_ * s / (lineProcessWeight_ + s) : s;
+		}
+		return cost;
+	}
+
+	void updateConfidences() {
+		for (auto &e : graph_->edges_) {
+			if (!e.uncertain_) {
+				continue;
+			}
+			const Vector6d r = computeResidual(e, *graph_);
+			const double s = r.dot(e.information_ * r);
+			const double temp = lineProcessWeight_ / (lineProcessWeight_ + s);
+			e.confidence_ = temp * temp;
+		}
+	}
+
+	void buildLinearSystem() {
+		triplets_.clear();
+		triplets_.reserve(4 * 36 * graph_->edges_.size() + dimension_);
+		b_ = Eigen::VectorXd::Zero(dimension_);
+		for (int k = 0; k < dimension_; ++k) {
+			// keeps the diagonal in the pattern for the damping
+			triplets_.emplace_back(k, k, 0.0);
+		}
+		for (const auto &e : graph_->edges_) {
+			const Vector6d r = computeResidual(e, *graph_);
+			// Gauss-Newton approximation around a satisfied edge
+			const Matrix6d Jt = -adjoint(inverseRigid(e.transformation_));
+			const Matrix6d information = (e.uncertain_ ? e.confidence_ : 1.0) * e.information_;
+			const int s = variableIdx_[e.source_node_id_];
+			const int t = variableIdx_[e.target_node_id_];
+			if (s >= 0) {
+				addBlock(s, s, information);
+				b_.segment<6>(6 * s) += information * r;
+			}
+			if (t >= 0) {
+				const Matrix6d JtTransposeInformation = Jt.transpose() * information;
+				addBlock(t, t, JtTransposeInformation * Jt);
+				b_.segment<6>(6 * t) += JtTransposeInformation * r;
+			}
+			if (s >= 0 && t >= 0) {
+				const Matrix6d offDiagonal = information * Jt;
+				addBlock(s, t, offDiagonal);
+				addBlock(t, s, offDiagonal.transpose());
+			}
+		}
+		H_.resize(dimension_, dimension_);
+		H_.setFromTriplets(triplets_.begin(), triplets_.end());
+	}
+
+	void addBlock(int row, int col, const Matrix6d &block) {
+		for (int i = 0; i < 6; ++i) {
+			for (int j = 0; j < 6; ++j) {
+				triplets_.emplace_back(6 * row + i, 6 * col + j, block(i, j));
+			}
+		}
+	}
+
+	void applyIncrement(const Eigen::VectorXd &delta, std::vector<registration::PoseGraphNode> *nodes) const {
+		for (size_t i = 0; i < nodes->size(); ++i) {
+			const int idx = variableIdx_[i];
+			if (idx >= 0) {
+				retract(delta.segment<6>(6 * idx), &nodes->at(i).pose_);
+			}
+		}
+	}
+
+	double stateNorm() const {
+		double squaredNorm = 0.0;
+		for (const auto &n : graph_->nodes_) {
+			squaredNorm += n.pose_.block<3, 1>(0, 3).squaredNorm();
+		}
+		return std::sqrt(squaredNorm);
+	}
+
+	const registration::GlobalOptimizationConvergenceCriteria &criteria_;
+	const int referenceNode_;
+	const double lineProcessWeight_;
+	registration::PoseGraph *graph_;
+	std::vector<int> variableIdx_;
+	int dimension_ = 0;
+	std::vector<Eigen::Triplet<double>> triplets_;
+	SparseMatrix H_;
+	Eigen::VectorXd b_;
+	Eigen::SimplicialLDLT<SparseMatrix> solver_;
+};
+
+int pruneUncertainEdges(double edgePruneThreshold, registration::PoseGraph *graph) {
+	const size_t nEdgesBefore = graph->edges_.size();
+	graph->edges_.erase(std::remove_if(graph->edges_.begin(), graph->edges_.end(),
+			[edgePruneThreshold](const registration::PoseGraphEdge &e) {
+				return e.uncertain_ && e.confidence_ < edgePruneThreshold;
+			}), graph->edges_.end());
+	return static_cast<int>(nEdgesBefore - graph->edges_.size());
+}
+
+} // namespace
+
+void sparseGlobalOptimization(const registration::GlobalOptimizationConvergenceCriteria &criteria,
+		const registration::GlobalOptimizationOption &option, registration::PoseGraph *graph) {
+	const int nNodes = static_cast<int>(graph->nodes_.size());
+	const int referenceNode = option.reference_node_ >= 0 && option.reference_node_ < nNodes ? option.reference_node_ : 0;
+	const double lineProcessWeight = computeLineProcessWeight(*graph, option);
+	{
+		SparseLevenbergMarquardt lm(criteria, referenceNode, lineProcessWeight, graph);
+		lm.optimize();
+	}
+	// same as open3d, drop the loop closures that got rejected by the line process and optimize once more
+	if (pruneUncertainEdges(option.edge_prune_threshold_, graph) > 0) {
+		SparseLevenbergMarquardt lm(criteria, referenceNode, lineProcessWeight, graph);
+		lm.optimize();
+	}
+}
+
+} // namespace o3d_slam
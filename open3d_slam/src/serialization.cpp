@@ -0,0 +1,136 @@
+/*
+ * serialization.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include "open3d_slam/serialization.hpp"
+
+#include <vector>
+
+namespace o3d_slam {
+
+namespace {
+
+template<typename T>
+void writePod(const T &value, std::ostream *out) {
+	out->write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readPod(std::istream &in, T *value) {
+	in.read(reinterpret_cast<char*>(value), sizeof(T));
+	return static_cast<bool>(in);
+}
+
+void writeVectors(const std::vector<Eigen::Vector3d> &v, std::ostream *out) {
+	writePod<uint64>(v.size(), out);
+	out->write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(Eigen::Vector3d));
+}
+
+bool readVectors(std::istream &in, std::vector<Eigen::Vector3d> *v) {
+	uint64 size = 0;
+	if (!readPod(in, &size)) {
+		return false;
+	}
+	v->resize(size);
+	in.read(reinterpret_cast<char*>(v->data()), size * sizeof(Eigen::Vector3d));
+	return static_cast<bool>(in);
+}
+
+} // namespace
+
+void serialize(const PointCloud &cloud, std::ostream *out) {
+	writeVectors(cloud.points_, out);
+	writeVectors(cloud.normals_, out);
+	writeVectors(cloud.colors_, out);
+}
+
+bool deserialize(std::istream &in, PointCloud *cloud) {
+	cloud->Clear();
+	return readVectors(in, &cloud->points_) && readVectors(in, &cloud->normals_) && readVectors(in, &cloud->colors_);
+}
+
+void serialize(const open3d::pipelines::registration::Feature &feature, std::ostream *out) {
+	writePod<uint64>(feature.data_.rows(), out);
+	writePod<uint64>(feature.data_.cols(), out);
+	out->write(reinterpret_cast<const char*>(feature.data_.data()), feature.data_.size() * sizeof(double));
+}
+
+bool deserialize(std::istream &in, open3d::pipelines::registration::Feature *feature) {
+	uint64 rows = 0, cols = 0;
+	if (!readPod(in, &rows) || !readPod(in, &cols)) {
+		return false;
+	}
+	feature->data_.resize(rows, cols);
+	in.read(reinterpret_cast<char*>(feature->data_.data()), feature->data_.size() * sizeof(double));
+	return static_cast<bool>(in);
+}
+
+void serialize(const VoxelizedPointCloud &voxels, std::ostream *out) {
+	writePod(voxels.getVoxelSize(), out);
+	writePod<uint8>(voxels.isHasNormals_, out);
+	writePod<uint8>(voxels.isHasColors_, out);
+	writePod<uint64>(voxels.size(), out);
+	for (const auto &v : voxels.voxels_) {
+		writePod(v.first, out);
+		writePod(v.second.numAggregatedPoints_, out);
+		writePod(v.second.aggregatedPosition_, out);
+		writePod(v.second.aggregatedNormal_, out);
+		writePod(v.second.aggregatedColor_, out);
+		writePod(v.second.logOdds_, out);
+	}
+}
+
+bool deserialize(std::istream &in, VoxelizedPointCloud *voxels) {
+	Eigen::Vector3d voxelSize;
+	uint8 isHasNormals = 0, isHasColors = 0;
+	uint64 numVoxels = 0;
+	if (!readPod(in, &voxelSize) || !readPod(in, &isHasNormals) || !readPod(in, &isHasColors)
+			|| !readPod(in, &numVoxels)) {
+		return false;
+	}
+	*voxels = VoxelizedPointCloud(voxelSize);
+	voxels->isHasNormals_ = isHasNormals;
+	voxels->isHasColors_ = isHasColors;
+	voxels->reserve(numVoxels);
+	for (uint64 i = 0; i < numVoxels; ++i) {
+		Eigen::Vector3i key;
+		AggregatedVoxel voxel;
+		if (!readPod(in, &key) || !readPod(in, &voxel.numAggregatedPoints_) || !readPod(in, &voxel.aggregatedPosition_)
+				|| !readPod(in, &voxel.aggregatedNormal_) || !readPod(in, &voxel.aggregatedColor_)
+				|| !readPod(in, &voxel.logOdds_)) {
+			return false;
+		}
+		voxels->voxels_[key] = voxel;
+	}
+	return true;
+}
+
+void serialize(const OccupancyVoxelMap &voxels, std::ostream *out) {
+	writePod(voxels.getVoxelSize(), out);
+	writePod<uint64>(voxels.getShards().size(), out);
+	for (const auto &shard : voxels.getShards()) {
+		serialize(shard, out);
+	}
+}
+
+bool deserialize(std::istream &in, OccupancyVoxelMap *voxels) {
+	Eigen::Vector3d voxelSize;
+	uint64 numShards = 0;
+	if (!readPod(in, &voxelSize) || !readPod(in, &numShards) || numShards != OccupancyVoxelMap::kNumShards) {
+		return false;
+	}
+	std::vector<VoxelizedPointCloud> shards(numShards);
+	for (auto &shard : shards) {
+		if (!deserialize(in, &shard)) {
+			return false;
+		}
+	}
+	*voxels = OccupancyVoxelMap(voxelSize);
+	voxels->setShards(std::move(shards));
+	return true;
+}
+
+} // namespace o3d_slam
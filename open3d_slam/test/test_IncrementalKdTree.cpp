@@ -0,0 +1,104 @@
+/*
+ * test_IncrementalKdTree.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include "open3d_slam/IncrementalKdTree.hpp"
+#include "open3d_slam/croppers.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+bool findNearestLinear(const PointCloud &cloud, const Eigen::Vector3d &query, double maxDistance,
+		const CroppingVolume *volume, Eigen::Vector3d *nearest) {
+	double bestSquaredDistance = maxDistance * maxDistance;
+	bool isFound = false;
+	for (const auto &p : cloud.points_) {
+		const double squaredDistance = (p - query).squaredNorm();
+		if (squaredDistance < bestSquaredDistance && (volume == nullptr || volume->isWithinVolume(p))) {
+			bestSquaredDistance = squaredDistance;
+			*nearest = p;
+			isFound = true;
+		}
+	}
+	return isFound;
+}
+
+PointCloud createCloud(size_t numPoints, std::mt19937 *rng) {
+	std::uniform_real_distribution<double> uniform(-10.0, 10.0);
+	PointCloud cloud;
+	for (size_t i = 0; i < numPoints; ++i) {
+		cloud.points_.emplace_back(uniform(*rng), uniform(*rng), 0.2 * uniform(*rng));
+		cloud.normals_.emplace_back(0.0, 0.0, 1.0);
+	}
+	return cloud;
+}
+
+void expectSameAsLinear(const IncrementalKdTree &tree, const PointCloud &cloud, const CroppingVolume *volume,
+		std::mt19937 *rng) {
+	std::uniform_real_distribution<double> uniform(-12.0, 12.0);
+	size_t numFound = 0;
+	for (int i = 0; i < 500; ++i) {
+		const Eigen::Vector3d query(uniform(*rng), uniform(*rng), 0.2 * uniform(*rng));
+		const double maxDistance = 0.5 + std::abs(uniform(*rng)) / 6.0;
+		IncrementalKdTree::Neighbor neighbor;
+		Eigen::Vector3d expected;
+		const bool isFound = tree.findNearest(query, maxDistance, volume, &neighbor);
+		ASSERT_EQ(isFound, findNearestLinear(cloud, query, maxDistance, volume, &expected));
+		if (isFound) {
+			EXPECT_EQ(neighbor.point_, expected);
+			EXPECT_DOUBLE_EQ(neighbor.squaredDistance_, (expected - query).squaredNorm());
+			++numFound;
+		}
+	}
+	EXPECT_GT(numFound, 0);
+}
+} // namespace
+
+TEST(IncrementalKdTree, matchesLinearSearch) {
+	std::mt19937 rng(5);
+	PointCloud cloud = createCloud(5000, &rng);
+	IncrementalKdTree tree;
+	tree.build(cloud);
+	EXPECT_EQ(tree.size(), cloud.points_.size());
+	expectSameAsLinear(tree, cloud, nullptr, &rng);
+
+	// removals and insertions trigger partial rebuilds
+	PointCloud removed, remaining;
+	for (size_t i = 0; i < cloud.points_.size(); ++i) {
+		(i % 3 == 0 ? removed : remaining).points_.push_back(cloud.points_[i]);
+	}
+	tree.remove(removed);
+	const PointCloud inserted = createCloud(2000, &rng);
+	tree.insert(inserted);
+	remaining.points_.insert(remaining.points_.end(), inserted.points_.begin(), inserted.points_.end());
+	EXPECT_EQ(tree.size(), remaining.points_.size());
+	expectSameAsLinear(tree, remaining, nullptr, &rng);
+}
+
+TEST(IncrementalKdTree, filteredSearchMatchesCroppedSearch) {
+	std::mt19937 rng(9);
+	const PointCloud cloud = createCloud(5000, &rng);
+	IncrementalKdTree tree;
+	tree.build(cloud);
+	MaxRadiusCroppingVolume volume(6.0);
+	Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+	pose.translation() = Eigen::Vector3d(1.0, -2.0, 0.0);
+	volume.setPose(pose);
+	expectSameAsLinear(tree, cloud, &volume, &rng);
+
+	// the nearest point outside of the volume is skipped, not the query rejected
+	const Eigen::Vector3d query = pose.translation() + Eigen::Vector3d(6.0, 0.0, 0.0);
+	IncrementalKdTree::Neighbor neighbor;
+	if (tree.findNearest(query, 2.0, &volume, &neighbor)) {
+		EXPECT_TRUE(volume.isWithinVolume(neighbor.point_));
+	}
+	volume.setIsInvertVolume(true);
+	expectSameAsLinear(tree, cloud, &volume, &rng);
+}
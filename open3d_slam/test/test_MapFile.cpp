@@ -0,0 +1,104 @@
+/*
+ * test_MapFile.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "open3d_slam/MapFile.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+const std::string kFilename = "/tmp/open3d_slam_test_map_file.o3dmap";
+
+MapFileContent createContent() {
+	MapFileContent content;
+	content.submaps_.resize(3);
+	for (int k = 0; k < 3; ++k) {
+		MapFileSubmap &submap = content.submaps_[k];
+		submap.id_ = k;
+		submap.parentId_ = k == 0 ? 0 : k - 1;
+		submap.mapToSubmapOrigin_ = Transform::Identity();
+		submap.mapToSubmapOrigin_.translation() = Eigen::Vector3d(k, -k, 0.5 * k);
+		submap.mapToSubmapOrigin_.linear() = Eigen::AngleAxisd(0.1 * k, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+		submap.mapToSubmapCenter_ = Eigen::Vector3d(k, 1.0, 2.0);
+		// the second submap has no covariances and the last one no colors
+		for (int i = 0; i < 100 * k + 1; ++i) {
+			submap.map_.points_.emplace_back(i, k, 0.1 * i);
+			submap.map_.normals_.emplace_back(0.0, 0.0, 1.0);
+			if (k != 2) {
+				submap.map_.colors_.emplace_back(0.1 * k, 0.2, 0.3);
+			}
+			if (k != 1) {
+				submap.map_.covariances_.push_back(Eigen::Matrix3d::Identity() * i);
+			}
+		}
+	}
+	return content;
+}
+} // namespace
+
+TEST(MapFile, writeReadRoundTrip) {
+	const MapFileContent content = createContent();
+	ASSERT_TRUE(writeMapFile(kFilename, content));
+	MapFileView view;
+	ASSERT_TRUE(view.open(kFilename));
+	ASSERT_EQ(view.getNumSubmaps(), content.submaps_.size());
+	for (size_t k = 0; k < content.submaps_.size(); ++k) {
+		const MapFileSubmap &expected = content.submaps_[k];
+		const MapFileView::SubmapView &submap = view.getSubmap(k);
+		EXPECT_EQ(submap.id_, expected.id_);
+		EXPECT_EQ(submap.parentId_, expected.parentId_);
+		EXPECT_TRUE(submap.mapToSubmapOrigin_.isApprox(expected.mapToSubmapOrigin_));
+		EXPECT_EQ(submap.mapToSubmapCenter_, expected.mapToSubmapCenter_);
+		const PointCloud cloud = view.toPointCloud(k);
+		EXPECT_EQ(cloud.points_, expected.map_.points_);
+		EXPECT_EQ(cloud.normals_, expected.map_.normals_);
+		EXPECT_EQ(cloud.colors_, expected.map_.colors_);
+		EXPECT_EQ(cloud.covariances_, expected.map_.covariances_);
+	}
+	view.close();
+	EXPECT_FALSE(view.isOpen());
+	std::remove(kFilename.c_str());
+}
+
+TEST(MapFile, assembledCloudKeepsOnlyCommonFields) {
+	const MapFileContent content = createContent();
+	ASSERT_TRUE(writeMapFile(kFilename, content));
+	MapFileView view;
+	ASSERT_TRUE(view.open(kFilename));
+	const PointCloud assembled = view.toAssembledPointCloud();
+	size_t numPoints = 0;
+	for (const auto &submap : content.submaps_) {
+		numPoints += submap.map_.points_.size();
+	}
+	EXPECT_EQ(assembled.points_.size(), numPoints);
+	EXPECT_EQ(assembled.normals_.size(), numPoints);
+	EXPECT_TRUE(assembled.covariances_.empty());
+	std::remove(kFilename.c_str());
+}
+
+TEST(MapFile, rejectsTruncatedAndMissingFiles) {
+	MapFileView view;
+	EXPECT_FALSE(view.open("/tmp/open3d_slam_test_does_not_exist.o3dmap"));
+	ASSERT_TRUE(writeMapFile(kFilename, createContent()));
+	std::string bytes;
+	{
+		std::ifstream in(kFilename, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	ASSERT_GT(bytes.size(), 100);
+	{
+		std::ofstream out(kFilename, std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), bytes.size() - 100);
+	}
+	EXPECT_FALSE(view.open(kFilename));
+	EXPECT_FALSE(view.isOpen());
+	std::remove(kFilename.c_str());
+}
@@ -0,0 +1,73 @@
+/*
+ * test_OdometryConstraintCache.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include "open3d_slam/OdometryConstraintCache.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+Constraint createConstraint(size_t sourceIdx, size_t targetIdx, double x) {
+	Constraint c;
+	c.sourceSubmapIdx_ = sourceIdx;
+	c.targetSubmapIdx_ = targetIdx;
+	c.sourceToTarget_.translation() = Eigen::Vector3d(x, 0.0, 0.0);
+	return c;
+}
+
+OdometryConstraintCache::Revisions createRevisions(size_t source, size_t target) {
+	OdometryConstraintCache::Revisions revisions;
+	revisions.source_ = source;
+	revisions.target_ = target;
+	return revisions;
+}
+} // namespace
+
+TEST(OdometryConstraintCache, invalidatedByMapRevision) {
+	OdometryConstraintCache cache;
+	EXPECT_FALSE(cache.hasConstraint(0, 1));
+	EXPECT_FALSE(cache.isUpToDate(0, 1, createRevisions(0, 0)));
+
+	cache.insert(createConstraint(0, 1, 1.0), createRevisions(3, 5));
+	EXPECT_TRUE(cache.hasConstraint(0, 1));
+	EXPECT_FALSE(cache.hasConstraint(1, 0));
+	EXPECT_TRUE(cache.isUpToDate(0, 1, createRevisions(3, 5)));
+
+	// scans merged into either submap make the constraint stale, the entry stays until it is rebuilt
+	EXPECT_FALSE(cache.isUpToDate(0, 1, createRevisions(4, 5)));
+	EXPECT_FALSE(cache.isUpToDate(0, 1, createRevisions(3, 6)));
+	EXPECT_TRUE(cache.hasConstraint(0, 1));
+
+	// rebuilding overwrites the entry
+	cache.insert(createConstraint(0, 1, 2.0), createRevisions(4, 6));
+	EXPECT_EQ(cache.size(), 1);
+	EXPECT_TRUE(cache.isUpToDate(0, 1, createRevisions(4, 6)));
+	EXPECT_FALSE(cache.isUpToDate(0, 1, createRevisions(3, 5)));
+	const Constraints constraints = cache.getConstraints();
+	ASSERT_EQ(constraints.size(), 1);
+	EXPECT_DOUBLE_EQ(constraints.front().sourceToTarget_.translation().x(), 2.0);
+}
+
+TEST(OdometryConstraintCache, constraintsSortedByTarget) {
+	OdometryConstraintCache cache;
+	cache.insert(createConstraint(2, 3, 0.0), createRevisions(0, 0));
+	cache.insert(createConstraint(0, 1, 0.0), createRevisions(0, 0));
+	cache.insert(createConstraint(1, 3, 0.0), createRevisions(0, 0));
+	cache.insert(createConstraint(1, 2, 0.0), createRevisions(0, 0));
+	const Constraints constraints = cache.getConstraints();
+	ASSERT_EQ(constraints.size(), 4);
+	for (size_t i = 1; i < constraints.size(); ++i) {
+		const Constraint &prev = constraints[i - 1];
+		const Constraint &c = constraints[i];
+		EXPECT_TRUE(prev.targetSubmapIdx_ < c.targetSubmapIdx_
+				|| (prev.targetSubmapIdx_ == c.targetSubmapIdx_ && prev.sourceSubmapIdx_ < c.sourceSubmapIdx_));
+	}
+	cache.clear();
+	EXPECT_EQ(cache.size(), 0);
+	EXPECT_FALSE(cache.hasConstraint(0, 1));
+}
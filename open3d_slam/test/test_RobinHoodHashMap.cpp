@@ -0,0 +1,119 @@
+/*
+ * test_RobinHoodHashMap.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include "open3d_slam/RobinHoodHashMap.hpp"
+#include "open3d_slam/VoxelHashMap.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+template<typename Map, typename Reference>
+void expectSameContent(const Map &map, const Reference &reference) {
+	ASSERT_EQ(map.size(), reference.size());
+	size_t numIterated = 0;
+	for (const auto &keyValue : map) {
+		const auto search = reference.find(keyValue.first);
+		ASSERT_NE(search, reference.end());
+		EXPECT_EQ(keyValue.second, search->second);
+		++numIterated;
+	}
+	EXPECT_EQ(numIterated, reference.size());
+	for (const auto &keyValue : reference) {
+		const auto search = map.find(keyValue.first);
+		ASSERT_NE(search, map.end());
+		EXPECT_EQ(search->second, keyValue.second);
+	}
+}
+} // namespace
+
+TEST(RobinHoodHashMap, insertFindErase) {
+	RobinHoodHashMap<int, int> map;
+	EXPECT_TRUE(map.empty());
+	EXPECT_EQ(map.find(1), map.end());
+	EXPECT_TRUE(map.insert(std::make_pair(1, 10)).second);
+	EXPECT_FALSE(map.insert(std::make_pair(1, 20)).second);
+	EXPECT_EQ(map.at(1), 10);
+	map[2] = 30;
+	EXPECT_EQ(map.size(), 2);
+	EXPECT_EQ(map.count(2), 1);
+	EXPECT_EQ(map.erase(1), 1);
+	EXPECT_EQ(map.erase(1), 0);
+	EXPECT_EQ(map.count(1), 0);
+	EXPECT_THROW(map.at(1), std::out_of_range);
+	EXPECT_EQ(map.size(), 1);
+	map.clear();
+	EXPECT_TRUE(map.empty());
+	EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(RobinHoodHashMap, rehashKeepsElements) {
+	RobinHoodHashMap<int, int> map;
+	std::unordered_map<int, int> reference;
+	size_t numRehashes = 0;
+	for (int i = 0; i < 10000; ++i) {
+		const size_t capacity = map.capacity();
+		map[i * 7919] = i;
+		reference[i * 7919] = i;
+		numRehashes += map.capacity() != capacity ? 1 : 0;
+		ASSERT_LE(map.load_factor(), 1.0);
+	}
+	EXPECT_GT(numRehashes, 1);
+	expectSameContent(map, reference);
+
+	// reserving more does not lose anything either
+	map.reserve(4 * map.capacity());
+	expectSameContent(map, reference);
+}
+
+TEST(RobinHoodHashMap, randomOperationsMatchUnorderedMap) {
+	// small key range, so that erase hits existing keys and the backward shift runs over long probe chains
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> keyDistribution(0, 2000);
+	std::uniform_int_distribution<int> operationDistribution(0, 9);
+	RobinHoodHashMap<int, int> map;
+	std::unordered_map<int, int> reference;
+	for (int i = 0; i < 100000; ++i) {
+		const int key = keyDistribution(rng);
+		const int operation = operationDistribution(rng);
+		if (operation < 5) {
+			const bool isInserted = map.insert(std::make_pair(key, i)).second;
+			EXPECT_EQ(isInserted, reference.insert(std::make_pair(key, i)).second);
+		} else if (operation < 9) {
+			EXPECT_EQ(map.erase(key), reference.erase(key));
+		} else {
+			map[key] = -i;
+			reference[key] = -i;
+		}
+		if (i % 10000 == 0) {
+			expectSameContent(map, reference);
+		}
+	}
+	expectSameContent(map, reference);
+}
+
+TEST(RobinHoodHashMap, voxelKeys) {
+	RobinHoodHashMap<Eigen::Vector3i, size_t, EigenVec3iHash> map;
+	std::unordered_map<Eigen::Vector3i, size_t, EigenVec3iHash> reference;
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> coordinateDistribution(-50, 50);
+	for (size_t i = 0; i < 20000; ++i) {
+		const Eigen::Vector3i key(coordinateDistribution(rng), coordinateDistribution(rng),
+				coordinateDistribution(rng));
+		if (i % 3 == 0) {
+			EXPECT_EQ(map.erase(key), reference.erase(key));
+		} else {
+			map[key] = i;
+			reference[key] = i;
+		}
+	}
+	expectSameContent(map, reference);
+}
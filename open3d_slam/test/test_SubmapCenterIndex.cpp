@@ -0,0 +1,108 @@
+/*
+ * test_SubmapCenterIndex.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "open3d_slam/SubmapCenterIndex.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+// same tie breaking as the index, the lower submap index wins
+void findNearestLinear(const std::vector<Eigen::Vector3d> &centers, const Eigen::Vector3d &query, size_t *submapIdx,
+		double *distance) {
+	double bestSquaredDistance = std::numeric_limits<double>::max();
+	for (size_t i = 0; i < centers.size(); ++i) {
+		const double squaredDistance = (centers[i] - query).squaredNorm();
+		if (squaredDistance < bestSquaredDistance) {
+			bestSquaredDistance = squaredDistance;
+			*submapIdx = i;
+		}
+	}
+	*distance = std::sqrt(bestSquaredDistance);
+}
+
+std::vector<size_t> findWithinRadiusLinear(const std::vector<Eigen::Vector3d> &centers, const Eigen::Vector3d &query,
+		double radius) {
+	std::vector<size_t> idxs;
+	for (size_t i = 0; i < centers.size(); ++i) {
+		if ((centers[i] - query).norm() <= radius) {
+			idxs.push_back(i);
+		}
+	}
+	return idxs;
+}
+
+void expectSameAsLinear(const SubmapCenterIndex &index, const std::vector<Eigen::Vector3d> &centers,
+		std::mt19937 *rng) {
+	std::uniform_real_distribution<double> queryDistribution(-300.0, 300.0);
+	for (int i = 0; i < 200; ++i) {
+		const Eigen::Vector3d query(queryDistribution(*rng), queryDistribution(*rng), 0.1 * queryDistribution(*rng));
+		size_t idx = 0, expectedIdx = 0;
+		double distance = 0.0, expectedDistance = 0.0;
+		ASSERT_TRUE(index.findNearest(query, &idx, &distance));
+		findNearestLinear(centers, query, &expectedIdx, &expectedDistance);
+		EXPECT_EQ(idx, expectedIdx);
+		EXPECT_NEAR(distance, expectedDistance, 1e-9);
+		const double radius = 5.0 + std::abs(queryDistribution(*rng)) / 5.0;
+		EXPECT_EQ(index.findWithinRadius(query, radius), findWithinRadiusLinear(centers, query, radius));
+	}
+}
+} // namespace
+
+TEST(SubmapCenterIndex, emptyIndex) {
+	SubmapCenterIndex index;
+	size_t idx = 0;
+	double distance = 0.0;
+	EXPECT_FALSE(index.findNearest(Eigen::Vector3d::Zero(), &idx, &distance));
+	EXPECT_TRUE(index.findWithinRadius(Eigen::Vector3d::Zero(), 100.0).empty());
+}
+
+TEST(SubmapCenterIndex, matchesLinearSearch) {
+	std::mt19937 rng(3);
+	// submaps along a random walk like a trajectory, plus a few far away outliers
+	std::normal_distribution<double> stepDistribution(0.0, 10.0);
+	std::vector<Eigen::Vector3d> centers;
+	Eigen::Vector3d position = Eigen::Vector3d::Zero();
+	for (int i = 0; i < 500; ++i) {
+		position += Eigen::Vector3d(stepDistribution(rng), stepDistribution(rng), 0.1 * stepDistribution(rng));
+		centers.push_back(position);
+	}
+	centers.push_back(Eigen::Vector3d(1e4, -1e4, 0.0));
+	centers.push_back(centers[10]); // duplicate, the tie goes to the lower index
+
+	SubmapCenterIndex index(20.0);
+	for (size_t i = 0; i < centers.size(); ++i) {
+		index.update(i, centers[i]);
+	}
+	EXPECT_EQ(index.size(), centers.size());
+	expectSameAsLinear(index, centers, &rng);
+
+	// the loop closure moves the submaps around
+	for (size_t i = 0; i < centers.size(); i += 3) {
+		centers[i] += Eigen::Vector3d(stepDistribution(rng), stepDistribution(rng), 0.0);
+		index.update(i, centers[i]);
+	}
+	EXPECT_EQ(index.size(), centers.size());
+	expectSameAsLinear(index, centers, &rng);
+
+	// the result does not depend on the cell size
+	for (const double cellSize : { 1.0, 7.5, 1000.0 }) {
+		index.setCellSize(cellSize);
+		expectSameAsLinear(index, centers, &rng);
+	}
+
+	index.clear();
+	EXPECT_EQ(index.size(), 0);
+	size_t idx = 0;
+	double distance = 0.0;
+	EXPECT_FALSE(index.findNearest(Eigen::Vector3d::Zero(), &idx, &distance));
+}
@@ -0,0 +1,114 @@
+/*
+ * test_TransformInterpolationBuffer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include "open3d_slam/TransformInterpolationBuffer.hpp"
+#include "open3d_slam/time.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+const Time kStartTime = fromUniversal(1000000);
+
+Time timeAt(double seconds) {
+	return kStartTime + fromSeconds(seconds);
+}
+
+// translation along x equal to the time in seconds, rotation about z proportional to it
+Transform transformAt(double seconds) {
+	Transform transform = Transform::Identity();
+	transform.translation() = Eigen::Vector3d(seconds, 0.0, 0.0);
+	transform.linear() = Eigen::AngleAxisd(0.01 * seconds, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+	return transform;
+}
+} // namespace
+
+TEST(TransformInterpolationBuffer, lookup) {
+	TransformInterpolationBuffer buffer(100);
+	EXPECT_TRUE(buffer.empty());
+	EXPECT_FALSE(buffer.has(timeAt(0.0)));
+	EXPECT_THROW(buffer.lookup(timeAt(0.0)), std::runtime_error);
+	for (int i = 0; i < 10; ++i) {
+		buffer.push(timeAt(i), transformAt(i));
+	}
+	EXPECT_EQ(buffer.size(), 10);
+	EXPECT_EQ(buffer.earliest_time(), timeAt(0.0));
+	EXPECT_EQ(buffer.latest_time(), timeAt(9.0));
+
+	// exact hits, the ends included
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_TRUE(buffer.has(timeAt(i)));
+		EXPECT_TRUE(buffer.lookup(timeAt(i)).isApprox(transformAt(i)));
+	}
+	// in between
+	for (const double t : { 0.25, 3.5, 8.99 }) {
+		ASSERT_TRUE(buffer.has(timeAt(t)));
+		EXPECT_TRUE(buffer.lookup(timeAt(t)).isApprox(transformAt(t), 1e-6));
+	}
+	// outside
+	EXPECT_FALSE(buffer.has(timeAt(-0.5)));
+	EXPECT_FALSE(buffer.has(timeAt(9.5)));
+	EXPECT_THROW(buffer.lookup(timeAt(9.5)), std::runtime_error);
+	EXPECT_TRUE(buffer.lookupClamped(timeAt(-0.5)).isApprox(transformAt(0.0)));
+	EXPECT_TRUE(buffer.lookupClamped(timeAt(9.5)).isApprox(transformAt(9.0)));
+
+	EXPECT_EQ(buffer.latest_measurement().time_, timeAt(9.0));
+	EXPECT_EQ(buffer.latest_measurement(3).time_, timeAt(6.0));
+	EXPECT_TRUE(buffer.latest_measurement(3).transform_.isApprox(transformAt(6.0)));
+
+	buffer.clear();
+	EXPECT_TRUE(buffer.empty());
+	EXPECT_FALSE(buffer.has(timeAt(5.0)));
+}
+
+TEST(TransformInterpolationBuffer, wraparound) {
+	const size_t sizeLimit = 16;
+	TransformInterpolationBuffer buffer(sizeLimit);
+	EXPECT_EQ(buffer.size_limit(), sizeLimit);
+	// several times around the ring, the checks also run while the ring is not full yet
+	for (int i = 0; i < 5 * static_cast<int>(sizeLimit) + 3; ++i) {
+		buffer.push(timeAt(i), transformAt(i));
+		const int numKept = std::min<int>(i + 1, sizeLimit);
+		const int earliest = i + 1 - numKept;
+		ASSERT_EQ(buffer.size(), numKept);
+		EXPECT_EQ(buffer.earliest_time(), timeAt(earliest));
+		EXPECT_EQ(buffer.latest_time(), timeAt(i));
+		EXPECT_FALSE(buffer.has(timeAt(earliest - 0.5)));
+		for (int j = earliest; j <= i; ++j) {
+			EXPECT_TRUE(buffer.lookup(timeAt(j)).isApprox(transformAt(j)));
+			EXPECT_EQ(buffer.latest_measurement(i - j).time_, timeAt(j));
+			if (j < i) {
+				EXPECT_TRUE(buffer.lookup(timeAt(j + 0.5)).isApprox(transformAt(j + 0.5), 1e-6));
+			}
+		}
+	}
+
+	// shrinking keeps the latest transforms
+	buffer.setSizeLimit(4);
+	const int latest = 5 * sizeLimit + 2;
+	EXPECT_EQ(buffer.size(), 4);
+	EXPECT_EQ(buffer.earliest_time(), timeAt(latest - 3));
+	EXPECT_EQ(buffer.latest_time(), timeAt(latest));
+	EXPECT_TRUE(buffer.lookup(timeAt(latest - 2.5)).isApprox(transformAt(latest - 2.5), 1e-6));
+}
+
+TEST(TransformInterpolationBuffer, applyToElementsInTimeInterval) {
+	TransformInterpolationBuffer buffer(8);
+	for (int i = 0; i < 12; ++i) {
+		buffer.push(timeAt(i), transformAt(i));
+	}
+	Transform correction = Transform::Identity();
+	correction.translation() = Eigen::Vector3d(0.0, 1.0, 0.0);
+	buffer.applyToAllElementsInTimeInterval(correction, timeAt(6.0), timeAt(9.0));
+	for (int i = 4; i < 12; ++i) {
+		const bool isCorrected = i >= 6 && i <= 9;
+		const Transform expected = isCorrected ? transformAt(i) * correction : transformAt(i);
+		EXPECT_TRUE(buffer.lookup(timeAt(i)).isApprox(expected)) << "at " << i;
+	}
+}
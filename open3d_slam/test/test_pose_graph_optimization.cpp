@@ -0,0 +1,120 @@
+/*
+ * test_pose_graph_optimization.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Geometry>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "open3d_slam/pose_graph_optimization.hpp"
+
+using namespace o3d_slam;
+
+namespace {
+namespace registration = open3d::pipelines::registration;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+Eigen::Matrix4d createPose(double x, double y, double yaw) {
+	Eigen::Matrix4d pose = Eigen::Matrix4d::Identity();
+	pose.topLeftCorner<3, 3>() = Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+	pose.block<3, 1>(0, 3) = Eigen::Vector3d(x, y, 0.0);
+	return pose;
+}
+
+// same convention as open3d, the edge maps the source frame to the target frame
+registration::PoseGraphEdge createEdge(const std::vector<Eigen::Matrix4d> &poses, int source, int target,
+		bool isUncertain) {
+	const Eigen::Matrix4d sourceToTarget = poses[target].inverse() * poses[source];
+	return registration::PoseGraphEdge(source, target, sourceToTarget, 1000.0 * Matrix6d::Identity(), isUncertain);
+}
+
+// submaps around a circle, odometry between consecutive ones, loop closures at the end
+struct Problem {
+	std::vector<Eigen::Matrix4d> groundTruth_;
+	registration::PoseGraph graph_;
+};
+
+Problem createProblem() {
+	Problem problem;
+	const int nNodes = 12;
+	for (int i = 0; i < nNodes; ++i) {
+		const double angle = 2.0 * M_PI * i / nNodes;
+		problem.groundTruth_.push_back(createPose(10.0 * std::cos(angle), 10.0 * std::sin(angle), angle + 0.5 * M_PI));
+	}
+	// the initial guess has drifted, the reference node is exact
+	std::mt19937 rng(17);
+	std::normal_distribution<double> noise(0.0, 0.05);
+	for (int i = 0; i < nNodes; ++i) {
+		const Eigen::Matrix4d drift = i == 0 ? Eigen::Matrix4d::Identity() : createPose(noise(rng), noise(rng), noise(rng));
+		problem.graph_.nodes_.emplace_back(problem.groundTruth_[i] * drift);
+	}
+	for (int i = 0; i + 1 < nNodes; ++i) {
+		problem.graph_.edges_.push_back(createEdge(problem.groundTruth_, i, i + 1, false));
+	}
+	problem.graph_.edges_.push_back(createEdge(problem.groundTruth_, 0, nNodes - 1, true));
+	problem.graph_.edges_.push_back(createEdge(problem.groundTruth_, 1, nNodes - 2, true));
+	return problem;
+}
+
+// the solver stops on the relative cost decrease, an outlier left in the graph is off by decimeters
+void expectSolved(const Problem &problem) {
+	ASSERT_EQ(problem.graph_.nodes_.size(), problem.groundTruth_.size());
+	for (size_t i = 0; i < problem.groundTruth_.size(); ++i) {
+		EXPECT_LT((problem.graph_.nodes_[i].pose_ - problem.groundTruth_[i]).norm(), 1e-3) << "node " << i;
+	}
+}
+} // namespace
+
+TEST(PoseGraphOptimization, convergesToTheGroundTruth) {
+	Problem problem = createProblem();
+	const size_t nEdges = problem.graph_.edges_.size();
+	sparseGlobalOptimization(registration::GlobalOptimizationConvergenceCriteria(),
+			registration::GlobalOptimizationOption(), &problem.graph_);
+	expectSolved(problem);
+	EXPECT_EQ(problem.graph_.edges_.size(), nEdges);
+	for (const auto &e : problem.graph_.edges_) {
+		EXPECT_GT(e.confidence_, 0.99);
+	}
+}
+
+TEST(PoseGraphOptimization, rejectsTheOutlierLoopClosure) {
+	Problem problem = createProblem();
+	// a wrong loop closure, two meters and a quarter turn off
+	auto outlier = createEdge(problem.groundTruth_, 2, 9, true);
+	outlier.transformation_ = outlier.transformation_ * createPose(2.0, 0.0, 0.5 * M_PI);
+	problem.graph_.edges_.push_back(outlier);
+	const size_t nEdges = problem.graph_.edges_.size();
+
+	sparseGlobalOptimization(registration::GlobalOptimizationConvergenceCriteria(),
+			registration::GlobalOptimizationOption(), &problem.graph_);
+	expectSolved(problem);
+	// the line process pruned the outlier and kept the consistent loop closures
+	ASSERT_EQ(problem.graph_.edges_.size(), nEdges - 1);
+	int nLoopClosures = 0;
+	for (const auto &e : problem.graph_.edges_) {
+		EXPECT_FALSE(e.source_node_id_ == 2 && e.target_node_id_ == 9);
+		nLoopClosures += e.uncertain_ ? 1 : 0;
+	}
+	EXPECT_EQ(nLoopClosures, 2);
+}
+
+TEST(PoseGraphOptimization, warmStartKeepsTheSolution) {
+	Problem problem = createProblem();
+	sparseGlobalOptimization(registration::GlobalOptimizationConvergenceCriteria(),
+			registration::GlobalOptimizationOption(), &problem.graph_);
+	expectSolved(problem);
+
+	// optimizing the solved graph again does not move it, neither does a new consistent node
+	const int newNode = static_cast<int>(problem.graph_.nodes_.size());
+	problem.groundTruth_.push_back(problem.groundTruth_.back() * createPose(1.0, 0.0, 0.1));
+	problem.graph_.nodes_.emplace_back(problem.groundTruth_.back());
+	problem.graph_.edges_.push_back(createEdge(problem.groundTruth_, newNode - 1, newNode, false));
+	sparseGlobalOptimization(registration::GlobalOptimizationConvergenceCriteria(),
+			registration::GlobalOptimizationOption(), &problem.graph_);
+	expectSolved(problem);
+}
@@ -0,0 +1,187 @@
+/*
+ * test_space_carving.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: jelavice
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+#include "open3d_slam/helpers.hpp"
+#include "open3d_slam/Parameters.hpp"
+#include "open3d_slam/Voxel.hpp"
+
+#ifdef open3d_slam_OPENMP_FOUND
+#include <omp.h>
+#endif
+
+using namespace o3d_slam;
+
+namespace {
+// the implementation before the voxel traversal, it samples every ray at voxel size steps
+std::set<size_t> getIdxsOfCarvedPointsBySampling(const PointCloud &scan, const PointCloud &cloud,
+		const Eigen::Vector3d &sensorPosition, const std::vector<size_t> &cloudIdxsSubset,
+		const SpaceCarvingParameters &param) {
+	const VoxelMap::LayerId layer = 0;
+	VoxelMap voxelMap(Eigen::Vector3d::Constant(param.voxelSize_));
+	voxelMap.insertCloud(layer, cloud, cloudIdxsSubset);
+	std::set<size_t> idxs;
+	for (const Eigen::Vector3d &p : scan.points_) {
+		const double length = (p - sensorPosition).norm();
+		const Eigen::Vector3d direction = (p - sensorPosition) / length;
+		const double maximalPathTraveled = std::max(param.voxelSize_,
+				std::min(length - param.truncationDistance_, param.maxRaytracingLength_));
+		for (double distance = 0.0; distance < maximalPathTraveled; distance += param.voxelSize_) {
+			const Eigen::Vector3d currentPosition = distance * direction + sensorPosition;
+			for (const size_t id : voxelMap.getIndicesInVoxel(layer, currentPosition)) {
+				if (!cloud.HasNormals()
+						|| std::abs(direction.dot(cloud.normals_[id].normalized())) > param.minDotProductWithNormal_) {
+					idxs.insert(id);
+				}
+			}
+		}
+	}
+	return idxs;
+}
+
+// slab test of the segment against the voxel of p
+bool isSegmentThroughVoxelOf(const Eigen::Vector3d &begin, const Eigen::Vector3d &end, const Eigen::Vector3d &p,
+		double voxelSize) {
+	const Eigen::Vector3i key = getVoxelIdx(p, Eigen::Vector3d::Constant(voxelSize));
+	const Eigen::Vector3d lower = key.cast<double>() * voxelSize;
+	const Eigen::Vector3d upper = lower + Eigen::Vector3d::Constant(voxelSize);
+	const double eps = 1e-9;
+	double tMin = 0.0, tMax = 1.0;
+	for (int axis = 0; axis < 3; ++axis) {
+		const double d = end(axis) - begin(axis);
+		if (std::abs(d) < eps) {
+			if (begin(axis) < lower(axis) - eps || begin(axis) > upper(axis) + eps) {
+				return false;
+			}
+			continue;
+		}
+		double t0 = (lower(axis) - begin(axis)) / d;
+		double t1 = (upper(axis) - begin(axis)) / d;
+		if (t0 > t1) {
+			std::swap(t0, t1);
+		}
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+	}
+	return tMin <= tMax + eps;
+}
+
+struct Scene {
+	PointCloud scan, cloud;
+	Eigen::Vector3d sensorPosition = Eigen::Vector3d(0.05, -0.02, 0.3);
+	SpaceCarvingParameters param;
+};
+
+// a wall the scan hits and map points scattered in front of it and behind it
+Scene createScene(bool isWithNormals) {
+	Scene scene;
+	scene.param.voxelSize_ = 0.2;
+	scene.param.truncationDistance_ = 0.1;
+	scene.param.maxRaytracingLength_ = 8.0;
+	scene.param.minDotProductWithNormal_ = 0.5;
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+	for (int i = 0; i < 400; ++i) {
+		scene.scan.points_.emplace_back(6.0, 4.0 * uniform(rng), 1.5 * uniform(rng));
+	}
+	for (int i = 0; i < 5000; ++i) {
+		scene.cloud.points_.emplace_back(3.5 + 4.0 * uniform(rng), 5.0 * uniform(rng), 2.0 * uniform(rng));
+		if (isWithNormals) {
+			scene.cloud.normals_.emplace_back(uniform(rng), uniform(rng), uniform(rng));
+		}
+	}
+	return scene;
+}
+
+void expectMatchesSampling(const Scene &scene, const std::vector<size_t> &subset) {
+	const std::vector<size_t> carved = getIdxsOfCarvedPoints(scene.scan, scene.cloud, scene.sensorPosition, subset,
+			scene.param);
+	const std::set<size_t> sampled = getIdxsOfCarvedPointsBySampling(scene.scan, scene.cloud, scene.sensorPosition,
+			subset, scene.param);
+	ASSERT_FALSE(sampled.empty());
+	EXPECT_TRUE(std::is_sorted(carved.begin(), carved.end()));
+	EXPECT_TRUE(std::adjacent_find(carved.begin(), carved.end()) == carved.end());
+
+	// the traversal visits every voxel the sampling visits
+	const std::set<size_t> carvedSet(carved.begin(), carved.end());
+	for (const size_t id : sampled) {
+		EXPECT_EQ(carvedSet.count(id), 1) << "point " << id << " is not carved";
+	}
+
+	// and the additional ones are in voxels some ray passes through (corners the sampling stepped over)
+	const std::set<size_t> subsetSet(subset.begin(), subset.end());
+	for (const size_t id : carved) {
+		ASSERT_EQ(subsetSet.count(id), 1);
+		if (sampled.count(id) > 0) {
+			continue;
+		}
+		bool isOnRay = false;
+		for (const Eigen::Vector3d &p : scene.scan.points_) {
+			const double length = (p - scene.sensorPosition).norm();
+			const Eigen::Vector3d direction = (p - scene.sensorPosition) / length;
+			const double maximalPathTraveled = std::max(scene.param.voxelSize_,
+					std::min(length - scene.param.truncationDistance_, scene.param.maxRaytracingLength_));
+			const Eigen::Vector3d end = scene.sensorPosition + maximalPathTraveled * direction;
+			if (isSegmentThroughVoxelOf(scene.sensorPosition, end, scene.cloud.points_[id], scene.param.voxelSize_)
+					&& (!scene.cloud.HasNormals()
+							|| std::abs(direction.dot(scene.cloud.normals_[id].normalized()))
+									> scene.param.minDotProductWithNormal_)) {
+				isOnRay = true;
+				break;
+			}
+		}
+		EXPECT_TRUE(isOnRay) << "point " << id << " is carved but no ray passes through its voxel";
+	}
+	// the extra ones are few, the two differ only at the voxel corners
+	EXPECT_LT(carved.size() - sampled.size(), sampled.size() / 2);
+}
+} // namespace
+
+TEST(SpaceCarving, matchesSamplingWithoutNormals) {
+	const Scene scene = createScene(false);
+	std::vector<size_t> all(scene.cloud.points_.size());
+	std::iota(all.begin(), all.end(), 0);
+	expectMatchesSampling(scene, all);
+}
+
+TEST(SpaceCarving, matchesSamplingWithNormals) {
+	const Scene scene = createScene(true);
+	std::vector<size_t> all(scene.cloud.points_.size());
+	std::iota(all.begin(), all.end(), 0);
+	expectMatchesSampling(scene, all);
+}
+
+TEST(SpaceCarving, onlyCarvesTheSubset) {
+	const Scene scene = createScene(false);
+	std::vector<size_t> subset;
+	for (size_t i = 0; i < scene.cloud.points_.size(); i += 3) {
+		subset.push_back(i);
+	}
+	expectMatchesSampling(scene, subset);
+}
+
+#ifdef open3d_slam_OPENMP_FOUND
+TEST(SpaceCarving, independentOfTheNumberOfThreads) {
+	const Scene scene = createScene(true);
+	const int maxThreads = omp_get_max_threads();
+	omp_set_num_threads(1);
+	const std::vector<size_t> singleThreaded = getIdxsOfCarvedPoints(scene.scan, scene.cloud, scene.sensorPosition,
+			scene.param);
+	omp_set_num_threads(4);
+	const std::vector<size_t> multiThreaded = getIdxsOfCarvedPoints(scene.scan, scene.cloud, scene.sensorPosition,
+			scene.param);
+	omp_set_num_threads(maxThreads);
+	EXPECT_FALSE(singleThreaded.empty());
+	EXPECT_EQ(singleThreaded, multiThreaded);
+}
+#endif
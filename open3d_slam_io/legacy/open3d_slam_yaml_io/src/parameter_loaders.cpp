@@ -95,6 +95,7 @@ void loadParameters(const YAML::Node &n, IcpParameters *p) {
 	p->maxCorrespondenceDistance_ = n["max_correspondence_dist"].as<double>();
 	p->maxNumIter_ = n["max_n_iter"].as<int>();
 	loadIfKeyDefined<double>(n, "max_distance_knn", &p->maxDistanceKnn_);
+	loadIfKeyDefined<double>(n, "min_increment_norm", &p->minIncrementNorm_);
 }
 
 void loadParameters(const YAML::Node &node, CloudRegistrationParameters *p){
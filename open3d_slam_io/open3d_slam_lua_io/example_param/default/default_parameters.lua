@@ -10,6 +10,7 @@ DEFAULT_PARAMETERS = {
   saving = deepcopy(SAVING_PARAMETERS),
   visualization = deepcopy(VISUALIZATION_PARAMETERS),
   motion_compensation = deepcopy(MOTION_COMPENSATION_PARAMETERS),
+  range_image = deepcopy(RANGE_IMAGE_PARAMETERS),
   global_optimization = deepcopy(GLOBAL_OPTIMIZATION_PARAMETERS),
   map_initializer = deepcopy(MAP_INITIALIZER_PARAMETERS),
   place_recognition = deepcopy(PLACE_RECOGNITION_PARAMETERS),
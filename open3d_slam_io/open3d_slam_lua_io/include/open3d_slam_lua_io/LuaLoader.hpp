@@ -42,9 +42,11 @@ private:
 
 
 	void loadParameters(const DictPtr dict, ConstantVelocityMotionCompensationParameters *p);
+	void loadParameters(const DictPtr dict, RangeImageParameters *p);
 	void loadParameters(const DictPtr dict, SavingParameters *p);
 	void loadParameters(const DictPtr dict, PlaceRecognitionConsistencyCheckParameters *p);
 	void loadParameters(const DictPtr dict, PlaceRecognitionParameters *p);
+	void loadParameters(const DictPtr dict, GlobalDescriptorParameters *p);
 	void loadParameters(const DictPtr dict, GlobalOptimizationParameters *p);
 	void loadParameters(const DictPtr dict, VisualizationParameters *p);
 	void loadParameters(const DictPtr dict, SubmapParameters *p);
@@ -206,6 +206,7 @@ void LuaLoader::loadParameters(const std::string &folderpath, const std::string
 	loadIfDictionaryDefined(dict,"visualization", &p->visualization_);
 	loadIfDictionaryDefined(dict,"odometry", &p->odometry_);
 	loadIfDictionaryDefined(dict,"motion_compensation", &p->motionCompensation_);
+	loadIfDictionaryDefined(dict,"range_image", &p->rangeImage_);
 	loadIfDictionaryDefined(dict,"global_optimization", &p->mapper_.globalOptimization_);
 	loadIfDictionaryDefined(dict,"submap", &p->mapper_.submaps_);
 	loadIfDictionaryDefined(dict,"map_builder", &p->mapper_.mapBuilder_);
@@ -260,6 +261,16 @@ void LuaLoader::loadParameters(const DictPtr dict, PlaceRecognitionParameters *p
 	loadBoolIfKeyDefined(dict, "dump_aligned_place_recognitions_to_file", &p->isDumpPlaceRecognitionAlignmentsToFile_);
 
 	loadIfDictionaryDefined(dict,"consistency_check", &p->consistencyCheck_);
+	loadIfDictionaryDefined(dict,"global_descriptor", &p->globalDescriptor_);
+}
+
+void LuaLoader::loadParameters(const DictPtr dict, GlobalDescriptorParameters *p){
+	loadBoolIfKeyDefined(dict, "is_use_global_descriptor", &p->isUseGlobalDescriptor_);
+	loadIntIfKeyDefined(dict, "num_rings", &p->numRings_);
+	loadIntIfKeyDefined(dict, "num_sectors", &p->numSectors_);
+	loadDoubleIfKeyDefined(dict, "max_radius", &p->maxRadius_);
+	loadIntIfKeyDefined(dict, "num_candidates", &p->numCandidates_);
+	loadDoubleIfKeyDefined(dict, "max_descriptor_distance", &p->maxDescriptorDistance_);
 }
 
 void LuaLoader::loadParameters(const DictPtr dict, MapInitializingParameters* p) {
@@ -274,6 +285,7 @@ void LuaLoader::loadParameters(const DictPtr dict, ScanToMapRegistrationParamete
 	loadStringIfKeyDefined(dict, "scan_to_map_refinement_type", &regTypeName);
 	p->scanToMapRegType_ = ScanToMapRegistrationStringToEnumMap.at(regTypeName);
 	loadDoubleIfKeyDefined(dict, "min_refinement_fitness", &p->minRefinementFitness_);
+	loadBoolIfKeyDefined(dict, "is_reuse_odometry_normals", &p->isReuseOdometryNormals_);
 	loadIfDictionaryDefined(dict,"icp", &p->icp_);
 }
 
@@ -289,6 +301,10 @@ void LuaLoader::loadParameters(const DictPtr dict, SubmapParameters *p){
 	loadDoubleIfKeyDefined(dict, "adjacency_based_revisiting_min_fitness", &p->adjacencyBasedRevisitingMinFitness_);
 	loadIntIfKeyDefined(dict, "submaps_num_scan_overlap", &p->numScansOverlap_);
 	loadIntIfKeyDefined(dict, "min_num_range_data", &p->minNumRangeData_);
+	loadBoolIfKeyDefined(dict, "is_page_out_to_disk", &p->isPageOutToDisk_);
+	loadDoubleIfKeyDefined(dict, "page_out_memory_budget_mb", &p->pageOutMemoryBudgetMb_);
+	loadDoubleIfKeyDefined(dict, "page_out_min_distance", &p->pageOutMinDistance_);
+	loadStringIfKeyDefined(dict, "page_out_folder", &p->pageOutFolder_);
 
 }
 
@@ -316,6 +332,7 @@ void LuaLoader::loadParameters(const DictPtr dict, SavingParameters *p){
 	loadBoolIfKeyDefined(dict, "save_map", &p->isSaveMap_);
 	loadBoolIfKeyDefined(dict, "save_submaps", &p->isSaveSubmaps_);
 	loadBoolIfKeyDefined(dict, "save_dense_submaps", &p->isSaveDenseSubmaps_);
+	loadBoolIfKeyDefined(dict, "save_binary_map", &p->isSaveBinaryMap_);
 }
 
 void LuaLoader::loadParameters(const DictPtr dict, VisualizationParameters *p){
@@ -332,17 +349,33 @@ void LuaLoader::loadParameters(const DictPtr dict, ConstantVelocityMotionCompens
 	loadIntIfKeyDefined(dict, "num_poses_vel_estimation", &p->numPosesVelocityEstimation_);
 }
 
+void LuaLoader::loadParameters(const DictPtr dict, RangeImageParameters *p){
+	loadBoolIfKeyDefined(dict, "is_use_range_image", &p->isUseRangeImage_);
+	loadIntIfKeyDefined(dict, "num_columns", &p->numColumns_);
+	loadIntIfKeyDefined(dict, "normal_estimation_half_window_rows", &p->normalEstimationHalfWindowRows_);
+	loadIntIfKeyDefined(dict, "normal_estimation_half_window_columns", &p->normalEstimationHalfWindowColumns_);
+	loadDoubleIfKeyDefined(dict, "normal_estimation_max_neighbour_distance", &p->normalEstimationMaxNeighbourDistance_);
+	loadBoolIfKeyDefined(dict, "is_keep_only_feature_points", &p->isKeepOnlyFeaturePoints_);
+	loadIntIfKeyDefined(dict, "feature_curvature_half_window", &p->features_.curvatureHalfWindow_);
+	loadDoubleIfKeyDefined(dict, "feature_edge_min_curvature", &p->features_.edgeMinCurvature_);
+	loadDoubleIfKeyDefined(dict, "feature_planar_max_curvature", &p->features_.planarMaxCurvature_);
+	loadDoubleIfKeyDefined(dict, "feature_ground_max_slope", &p->features_.groundMaxSlope_);
+	loadDoubleIfKeyDefined(dict, "feature_ground_max_z", &p->features_.groundMaxZ_);
+}
+
 void LuaLoader::loadParameters(const DictPtr dict, IcpParameters *p){
 	loadIntIfKeyDefined(dict, "max_n_iter", &p->maxNumIter_);
 	loadIntIfKeyDefined(dict, "knn", &p->knn_);
 	loadDoubleIfKeyDefined(dict, "max_correspondence_dist", &p->maxCorrespondenceDistance_);
 	loadDoubleIfKeyDefined(dict, "max_distance_knn", &p->maxDistanceKnn_);
+	loadDoubleIfKeyDefined(dict, "min_increment_norm", &p->minIncrementNorm_);
 }
 void LuaLoader::loadParameters(const DictPtr dict, GlobalOptimizationParameters *p){
 	loadDoubleIfKeyDefined(dict, "edge_prune_threshold", &p->edgePruneThreshold_);
 	loadDoubleIfKeyDefined(dict, "max_correspondence_distance", &p->maxCorrespondenceDistance_);
 	loadIntIfKeyDefined(dict, "reference_node", &p->referenceNode_);
 	loadDoubleIfKeyDefined(dict, "loop_closure_preference", &p->loopClosurePreference_);
+	loadBoolIfKeyDefined(dict, "use_sparse_solver", &p->isUseSparseSolver_);
 }
 
 void LuaLoader::loadParameters(const DictPtr dict, PlaceRecognitionConsistencyCheckParameters *p){
@@ -370,6 +403,9 @@ void LuaLoader::loadParameters(const DictPtr dict, SpaceCarvingParameters *p){
 	loadDoubleIfKeyDefined(dict, "max_raytracing_length", &p->maxRaytracingLength_);
 	loadDoubleIfKeyDefined(dict, "truncation_distance", &p->truncationDistance_);
 	loadIntIfKeyDefined(dict, "carve_space_every_n_scans", &p->carveSpaceEveryNscans_);
+	loadDoubleIfKeyDefined(dict, "hit_log_odds", &p->hitLogOdds_);
+	loadDoubleIfKeyDefined(dict, "miss_log_odds", &p->missLogOdds_);
+	loadDoubleIfKeyDefined(dict, "max_log_odds", &p->maxLogOdds_);
 }
 
 void LuaLoader::loadParameters(const DictPtr dict, Eigen::Isometry3d *T) {
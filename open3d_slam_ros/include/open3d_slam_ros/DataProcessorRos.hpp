@@ -7,6 +7,7 @@
 
 #pragma once
 #include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
 
 #include "open3d_slam/time.hpp"
 #include "open3d_slam/typedefs.hpp"
@@ -23,8 +24,14 @@ public:
 
 	virtual void initialize() = 0;
 	virtual void startProcessing() = 0;
-	virtual void processMeasurement(const PointCloud &cloud, const Time &timestamp);
-	void accumulateAndProcessRangeData(const PointCloud &cloud, const Time &timestamp);
+	// pointTimeOffsets are in sec relative to the timestamp, empty if the sensor does not provide them
+	virtual void processMeasurement(const PointCloud &cloud, const Time &timestamp,
+			const std::vector<float> &pointTimeOffsets);
+	void accumulateAndProcessRangeData(const PointCloud &cloud, const Time &timestamp,
+			const std::vector<float> &pointTimeOffsets);
+	// goes through the range image if enabled, then the cloud has normals already
+	void toOpen3dCloud(const sensor_msgs::PointCloud2ConstPtr &msg, PointCloud *cloud,
+			std::vector<float> *pointTimeOffsets) const;
 	void initCommonRosStuff();
 	std::shared_ptr<SlamWrapper> getSlamPtr();
 
@@ -34,6 +41,9 @@ protected:
 	size_t numPointCloudsReceived_ = 0;
 	size_t numAccumulatedRangeDataDesired_ = 1;
 	PointCloud accumulatedCloud_;
+	std::vector<float> accumulatedPointTimeOffsets_; // relative to accumulationBeginTime_
+	bool isAccumulatedPointTimesValid_ = true;
+	Time accumulationBeginTime_;
 	ros::Publisher rawCloudPub_;
 	std::string cloudTopic_;
 	std::shared_ptr<SlamWrapper> slam_;
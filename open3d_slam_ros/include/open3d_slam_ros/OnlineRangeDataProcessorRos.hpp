@@ -25,7 +25,8 @@ public:
 
 	 void initialize() override;
 	 void startProcessing() override;
-	 void processMeasurement(const PointCloud &cloud, const Time &timestamp) override;
+	 void processMeasurement(const PointCloud &cloud, const Time &timestamp,
+			 const std::vector<float> &pointTimeOffsets) override;
 
 private:
 	 void cloudCallback(const sensor_msgs::PointCloud2ConstPtr &msg);
@@ -18,6 +18,8 @@
 #include <visualization_msgs/MarkerArray.h>
 #include <ros/time.h>
 #include "open3d_slam/time.hpp"
+#include "open3d_slam/Parameters.hpp"
+#include "open3d_slam/RangeImage.hpp"
 
 
 namespace o3d_slam {
@@ -43,6 +45,13 @@ void publishTfTransform(const Eigen::Matrix4d &Mat, const ros::Time &time, const
 bool lookupTransform(const std::string &target_frame, const std::string &source_frame, const ros::Time &time,const tf2_ros::Buffer &tfBuffer,
 		Eigen::Isometry3d *transform);
 
+// organized clouds keep their grid, unorganized ones need a "ring" field and are binned by azimuth
+// into params.numColumns_ columns. False if the cloud is neither.
+bool rosToRangeImage(const sensor_msgs::PointCloud2 &msg, const RangeImageParameters &params, RangeImage *image);
+// time of every point in sec relative to the stamp, in the order of the cloud. False if the cloud has no time field.
+bool readPointTimeOffsets(const sensor_msgs::PointCloud2 &msg, std::vector<float> *pointTimeOffsets);
+bool hasPointTimeField(const sensor_msgs::PointCloud2 &msg);
+
 ros::Time toRos(Time time);
 
 Time fromRos(const ::ros::Time& time);
@@ -27,6 +27,7 @@ SAVING_PARAMETERS = {
   save_map = false,
   save_submaps = false,
   save_dense_submaps = false,
+  save_binary_map = false,
 }
 
 MOTION_COMPENSATION_PARAMETERS = {
@@ -36,6 +37,20 @@ MOTION_COMPENSATION_PARAMETERS = {
   num_poses_vel_estimation = 3,
 }
 
+RANGE_IMAGE_PARAMETERS = {
+  is_use_range_image = false,
+  num_columns = 1024,
+  normal_estimation_half_window_rows = 1,
+  normal_estimation_half_window_columns = 2,
+  normal_estimation_max_neighbour_distance = 1.0,
+  is_keep_only_feature_points = false,
+  feature_curvature_half_window = 5,
+  feature_edge_min_curvature = 0.1,
+  feature_planar_max_curvature = 0.01,
+  feature_ground_max_slope = 0.17,
+  feature_ground_max_z = -0.3,
+}
+
 VISUALIZATION_PARAMETERS = {
   assembled_map_voxel_size = 0.3,
   submaps_voxel_size = 0.3,
@@ -47,6 +62,7 @@ GLOBAL_OPTIMIZATION_PARAMETERS = {
   loop_closure_preference = 2.0,
   max_correspondence_distance = 1000.0,
   reference_node = 0,
+  use_sparse_solver = false,
 }
 
 SCAN_CROPPING_PARAMETERS = {
@@ -68,11 +84,12 @@ ICP_PARAMETERS = {
   knn= 20,
   max_distance_knn= 3.0,
   max_n_iter= 50,
+  min_increment_norm= 1e-6, -- VoxelHashPointToPlaneIcp only
 }
 
 SCAN_MATCHING_PARAMETERS = {
   icp = deepcopy(ICP_PARAMETERS),
-  cloud_registration_type = "GeneralizedIcp", -- options GeneralizedIcp, PointToPointIcp, PointToPlaneIcp
+  cloud_registration_type = "GeneralizedIcp", -- options GeneralizedIcp, PointToPointIcp, PointToPlaneIcp, VoxelHashPointToPlaneIcp
 }
 
 ODOMETRY_PARAMETERS = {
@@ -86,6 +103,10 @@ SUBMAP_PARAMETERS = {
   min_num_range_data = 10,
   adjacency_based_revisiting_min_fitness = 0.5,
   submaps_num_scan_overlap = 10,
+  is_page_out_to_disk = false,
+  page_out_memory_budget_mb = 4096.0,
+  page_out_min_distance = 60.0, -- meters
+  page_out_folder = "/tmp/open3d_slam_submaps",
 }
 
 SPACE_CARVING_PARAMETERS = {
@@ -93,6 +114,9 @@ SPACE_CARVING_PARAMETERS = {
   max_raytracing_length = 20.0,
   truncation_distance = 0.3,
   carve_space_every_n_scans= 10.0,
+  hit_log_odds = 0.85, --dense map only
+  miss_log_odds = -0.4, --dense map only
+  max_log_odds = 3.5, --dense map only
 }
 
 
@@ -104,6 +128,7 @@ MAP_BUILDER_PARAMETERS = {
 
 SCAN_TO_MAP_REGISTRATION_PARAMETERS = {
   min_refinement_fitness = 0.7,
+  is_reuse_odometry_normals = false,
   scan_to_map_refinement_type = "GeneralizedIcp", -- options GeneralizedIcp, PointToPointIcp, PointToPlaneIcp
   icp = deepcopy(ICP_PARAMETERS),
   scan_processing = deepcopy(SCAN_PROCESSING_PARAMETERS),
@@ -147,6 +172,15 @@ LOOP_CLOSURE_CONSISTENCY_CHECK_PARAMETERS = {
   max_drift_z = 40.0, --meters
 }
 
+GLOBAL_DESCRIPTOR_PARAMETERS = {
+  is_use_global_descriptor = false, --rank loop closure candidates with a scan context descriptor before RANSAC
+  num_rings = 20,
+  num_sectors = 60,
+  max_radius = 40.0, --meters
+  num_candidates = 5, --max number of candidate submaps per finished submap
+  max_descriptor_distance = 0.4, -- 0 is identical, 1 is completely different
+}
+
 PLACE_RECOGNITION_PARAMETERS = {
   feature_map_normal_estimation_radius = 2.0,
   feature_voxel_size = 0.5,
@@ -166,5 +200,6 @@ PLACE_RECOGNITION_PARAMETERS = {
   min_submaps_between_loop_closures = 2,
   loop_closure_search_radius = 20.0,
   consistency_check = deepcopy(LOOP_CLOSURE_CONSISTENCY_CHECK_PARAMETERS),
+  global_descriptor = deepcopy(GLOBAL_DESCRIPTOR_PARAMETERS),
 }
 
@@ -16,6 +16,7 @@ params.mapper_localizer.scan_to_map_registration.scan_processing.voxel_size = 0.
 params.mapper_localizer.scan_to_map_registration.scan_processing.downsampling_ratio = 0.5
 params.mapper_localizer.scan_to_map_registration.scan_processing.scan_cropping.cropping_radius_max = 30.0
 params.mapper_localizer.scan_to_map_registration.icp.max_correspondence_dist = 0.8
+params.mapper_localizer.scan_to_map_registration.is_reuse_odometry_normals = true
 
 --MAP_INITIALIZER
 params.map_initializer.pcd_file_path = ""
@@ -8,6 +8,8 @@
 #include "open3d_slam/typedefs.hpp"
 #include "open3d_slam/magic.hpp"
 #include "open3d_slam_ros/DataProcessorRos.hpp"
+#include "open3d_slam_ros/helpers_ros.hpp"
+#include "open3d_conversions/open3d_conversions.h"
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
 
@@ -27,7 +29,8 @@ void DataProcessorRos::initCommonRosStuff() {
 	std::cout << "Num accumulated range data: " << numAccumulatedRangeDataDesired_ << std::endl;
 }
 
-void DataProcessorRos::processMeasurement(const PointCloud &cloud, const Time &timestamp) {
+void DataProcessorRos::processMeasurement(const PointCloud &cloud, const Time &timestamp,
+		const std::vector<float> &pointTimeOffsets) {
 	std::cout << "Warning you have not implemented processMeasurement!!! \n";
 }
 
@@ -35,7 +38,41 @@ std::shared_ptr<SlamWrapper> DataProcessorRos::getSlamPtr() {
 	return slam_;
 }
 
-void DataProcessorRos::accumulateAndProcessRangeData(const PointCloud &cloud, const Time &timestamp) {
+void DataProcessorRos::toOpen3dCloud(const sensor_msgs::PointCloud2ConstPtr &msg, PointCloud *cloud,
+		std::vector<float> *pointTimeOffsets) const {
+	const RangeImageParameters &params = slam_->getRangeImageParameters();
+	if (params.isUseRangeImage_) {
+		RangeImage image;
+		if (rosToRangeImage(*msg, params, &image)) {
+			image.estimateNormals(params.normalEstimationHalfWindowRows_, params.normalEstimationHalfWindowColumns_,
+					params.normalEstimationMaxNeighbourDistance_);
+			// the points get the time of their column, without column times the motion compensation uses the azimuth
+			std::vector<double> columnTimeOffsets;
+			if (hasPointTimeField(*msg)) {
+				columnTimeOffsets = image.getColumnTimeOffsets();
+			} else if (msg->height > 1) {
+				columnTimeOffsets = image.getColumnTimeOffsetsFromFiringOrder(
+						slam_->getMotionCompensationParameters().scanDuration_);
+			}
+			if (params.isKeepOnlyFeaturePoints_) {
+				image.keepOnlyFeaturePoints(params.features_);
+			}
+			*cloud = image.toPointCloud();
+			if (columnTimeOffsets.empty()) {
+				pointTimeOffsets->clear();
+			} else {
+				*pointTimeOffsets = image.getPointTimeOffsets(columnTimeOffsets);
+			}
+			return;
+		}
+		std::cout << "Cloud is neither organized nor has a ring field, cannot build a range image. \n";
+	}
+	open3d_conversions::rosToOpen3d(msg, *cloud, false);
+	readPointTimeOffsets(*msg, pointTimeOffsets);
+}
+
+void DataProcessorRos::accumulateAndProcessRangeData(const PointCloud &cloud, const Time &timestamp,
+		const std::vector<float> &pointTimeOffsets) {
 	const size_t minNumCloudsReceived = magic::skipFirstNPointClouds;
 	if (numPointCloudsReceived_ < minNumCloudsReceived) {
 		++numPointCloudsReceived_;
@@ -45,6 +82,18 @@ void DataProcessorRos::accumulateAndProcessRangeData(const PointCloud &cloud, co
 		// we skip first five, just to be extra safe
 	}
 
+	if (numAccumulatedRangeDataCount_ == 0) {
+		accumulationBeginTime_ = timestamp;
+		isAccumulatedPointTimesValid_ = true;
+	}
+	// point times are kept only if every accumulated cloud has them
+	isAccumulatedPointTimesValid_ = isAccumulatedPointTimesValid_ && pointTimeOffsets.size() == cloud.points_.size();
+	if (isAccumulatedPointTimesValid_) {
+		const float shift = toSeconds(timestamp - accumulationBeginTime_);
+		for (const float t : pointTimeOffsets) {
+			accumulatedPointTimeOffsets_.push_back(t + shift);
+		}
+	}
 	accumulatedCloud_ += cloud;
 	++numAccumulatedRangeDataCount_;
 	if (numAccumulatedRangeDataCount_ < numAccumulatedRangeDataDesired_) {
@@ -56,10 +105,19 @@ void DataProcessorRos::accumulateAndProcessRangeData(const PointCloud &cloud, co
 		return;
 	}
 
-	processMeasurement(accumulatedCloud_, timestamp);
+	if (isAccumulatedPointTimesValid_) {
+		const float shift = toSeconds(timestamp - accumulationBeginTime_);
+		for (float &t : accumulatedPointTimeOffsets_) {
+			t -= shift;
+		}
+	} else {
+		accumulatedPointTimeOffsets_.clear();
+	}
+	processMeasurement(accumulatedCloud_, timestamp, accumulatedPointTimeOffsets_);
 
 	numAccumulatedRangeDataCount_ = 0;
 	accumulatedCloud_.Clear();
+	accumulatedPointTimeOffsets_.clear();
 }
 
 } // namespace o3d_slam
@@ -34,18 +34,20 @@ void OnlineRangeDataProcessorRos::startProcessing() {
 	slam_->stopWorkers();
 }
 
-void OnlineRangeDataProcessorRos::processMeasurement(const PointCloud &cloud, const Time &timestamp) {
+void OnlineRangeDataProcessorRos::processMeasurement(const PointCloud &cloud, const Time &timestamp,
+		const std::vector<float> &pointTimeOffsets) {
 
-	slam_->addRangeScan(cloud, timestamp);
+	slam_->addRangeScan(cloud, timestamp, pointTimeOffsets);
   o3d_slam::publishCloud(cloud, o3d_slam::frames::rangeSensorFrame, toRos(timestamp), rawCloudPub_);
 
 }
 
 void OnlineRangeDataProcessorRos::cloudCallback(const sensor_msgs::PointCloud2ConstPtr &msg) {
 	open3d::geometry::PointCloud cloud;
-	open3d_conversions::rosToOpen3d(msg, cloud, false);
+	std::vector<float> pointTimeOffsets;
+	toOpen3dCloud(msg, &cloud, &pointTimeOffsets);
 	const Time timestamp = fromRos(msg->header.stamp);
-	accumulateAndProcessRangeData(cloud, timestamp);
+	accumulateAndProcessRangeData(cloud, timestamp, pointTimeOffsets);
 }
 
 
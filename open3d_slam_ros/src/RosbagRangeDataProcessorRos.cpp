@@ -46,9 +46,10 @@ void RosbagRangeDataProcessorRos::startProcessing() {
 	slam_->stopWorkers();
 }
 
-void RosbagRangeDataProcessorRos::processMeasurement(const PointCloud &cloud, const Time &timestamp) {
+void RosbagRangeDataProcessorRos::processMeasurement(const PointCloud &cloud, const Time &timestamp,
+		const std::vector<float> &pointTimeOffsets) {
 
-	slam_->addRangeScan(cloud, timestamp);
+	slam_->addRangeScan(cloud, timestamp, pointTimeOffsets);
 	std::pair<PointCloud, Time> cloudTimePair = slam_->getLatestRegisteredCloudTimestampPair();
 	const bool isCloudEmpty = cloudTimePair.first.IsEmpty();
 	if (isTimeValid(cloudTimePair.second) && !isCloudEmpty) {
@@ -75,24 +76,14 @@ void RosbagRangeDataProcessorRos::readRosbag(const rosbag::Bag &bag) {
 					lastTimestamp = cloud->header.stamp;
 				}
 				//      	std::cout << "reading cloud msg with seq: " << cloud->header.seq << std::endl;
-				while (true) {
-					const bool isOdomBufferFull = slam_->getOdometryBufferSize() + 1
-							>= slam_->getOdometryBufferSizeLimit();
-					const bool isMappingBufferFull = slam_->getMappingBufferSize() + 1
-							>= slam_->getMappingBufferSizeLimit();
-
-					if (!isOdomBufferFull && !isMappingBufferFull) {
-						cloudCallback(cloud);
-						break;
-					} else {
-						std::this_thread::sleep_for(std::chrono::milliseconds(20));
-					}
+				while (!slam_->waitUntilBuffersHaveSpace(std::chrono::milliseconds(20))) {
 					ros::spinOnce();
 					if (!ros::ok()) {
 						slam_->stopWorkers();
 						return;
 					}
 				} // end while
+				cloudCallback(cloud);
 				const double elapsedWallTime = rosbagProcessingTimer.elapsedSec();
 				if (elapsedWallTime > 15.0) {
 					const double elapsedRosbagTime = (cloud->header.stamp - lastTimestamp).toSec();
@@ -137,9 +128,10 @@ void RosbagRangeDataProcessorRos::readRosbag(const rosbag::Bag &bag) {
 
 void RosbagRangeDataProcessorRos::cloudCallback(const sensor_msgs::PointCloud2ConstPtr &msg) {
 	open3d::geometry::PointCloud cloud;
-	open3d_conversions::rosToOpen3d(msg, cloud, false);
+	std::vector<float> pointTimeOffsets;
+	toOpen3dCloud(msg, &cloud, &pointTimeOffsets);
 	const Time timestamp = fromRos(msg->header.stamp);
-	accumulateAndProcessRangeData(cloud, timestamp);
+	accumulateAndProcessRangeData(cloud, timestamp, pointTimeOffsets);
 }
 
 
@@ -54,17 +54,16 @@ bool SlamMapInitializer::initSlamCallback(std_srvs::Trigger::Request &req, std_s
 
 void SlamMapInitializer::initialize(const MapInitializingParameters &params) {
   mapInitializerParams_ = params;
-  PointCloud raw_map;
   initialized_.store(false);
 
   std::cout << "Loading pointloud from: " << mapInitializerParams_.pcdFilePath_ << "\n";
-  if (!open3d::io::ReadPointCloud(mapInitializerParams_.pcdFilePath_, raw_map))
+  if (!slamPtr_->loadInitialMap(mapInitializerParams_.pcdFilePath_))
 	{
-		std::cerr << "[Error] Initialization pointcloud not loaded" << std::endl;
+		std::cerr << "[Error] Initialization map not loaded, continuing with an empty initial map" << std::endl;
+		slamPtr_->setInitialMap(PointCloud());
   }
 
   Transform initPose = params.initialPose_;
-  slamPtr_->setInitialMap(raw_map);
   slamPtr_->setInitialTransform(initPose.matrix());
   std::cout << "init pose: " << asString(initPose) << std::endl;
   if (params.isInitializeInteractively_){
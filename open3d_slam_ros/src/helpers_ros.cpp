@@ -8,6 +8,7 @@
 #include "open3d_slam_ros/helpers_ros.hpp"
 #include "open3d_slam/SubmapCollection.hpp"
 #include <random>
+#include <cstring>
 // ros stuff
 #include "open3d_conversions/open3d_conversions.h"
 #include <eigen_conversions/eigen_msg.h>
@@ -82,6 +83,152 @@ void publishCloud(const open3d::geometry::PointCloud &cloud, const std::string &
 	}
 }
 
+namespace {
+const sensor_msgs::PointField* findField(const sensor_msgs::PointCloud2 &msg, const std::string &name) {
+	for (const auto &field : msg.fields) {
+		if (field.name == name) {
+			return &field;
+		}
+	}
+	return nullptr;
+}
+
+double readField(const uint8_t *data, const sensor_msgs::PointField &field) {
+	const uint8_t *ptr = data + field.offset;
+	switch (field.datatype) {
+		case sensor_msgs::PointField::INT8:
+			return *reinterpret_cast<const int8_t*>(ptr);
+		case sensor_msgs::PointField::UINT8:
+			return *ptr;
+		case sensor_msgs::PointField::INT16: {
+			int16_t v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return v;
+		}
+		case sensor_msgs::PointField::UINT16: {
+			uint16_t v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return v;
+		}
+		case sensor_msgs::PointField::INT32: {
+			int32_t v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return v;
+		}
+		case sensor_msgs::PointField::UINT32: {
+			uint32_t v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return v;
+		}
+		case sensor_msgs::PointField::FLOAT32: {
+			float v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return v;
+		}
+		case sensor_msgs::PointField::FLOAT64: {
+			double v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return v;
+		}
+		default:
+			return 0.0;
+	}
+}
+struct TimeField {
+	const sensor_msgs::PointField *field_ = nullptr;
+	double scale_ = 1.0;
+	double shift_ = 0.0;
+	double toOffset(const uint8_t *data) const {
+		return field_ == nullptr ? 0.0 : readField(data, *field_) * scale_ + shift_;
+	}
+};
+
+// ouster gives "t" in ns, velodyne "time" in sec, both relative to the stamp. hesai gives absolute "timestamp"
+TimeField findTimeField(const sensor_msgs::PointCloud2 &msg) {
+	TimeField time;
+	if ((time.field_ = findField(msg, "t")) != nullptr) {
+		time.scale_ = 1e-9;
+	} else if ((time.field_ = findField(msg, "time")) == nullptr
+			&& (time.field_ = findField(msg, "timestamp")) != nullptr) {
+		time.shift_ = -msg.header.stamp.toSec();
+	}
+	return time;
+}
+} // namespace
+
+bool hasPointTimeField(const sensor_msgs::PointCloud2 &msg) {
+	return findTimeField(msg).field_ != nullptr;
+}
+
+bool readPointTimeOffsets(const sensor_msgs::PointCloud2 &msg, std::vector<float> *pointTimeOffsets) {
+	const TimeField time = findTimeField(msg);
+	if (time.field_ == nullptr) {
+		pointTimeOffsets->clear();
+		return false;
+	}
+	pointTimeOffsets->resize(static_cast<size_t>(msg.width) * msg.height);
+	for (uint32_t v = 0; v < msg.height; ++v) {
+		const uint8_t *rowData = &msg.data[v * msg.row_step];
+		for (uint32_t u = 0; u < msg.width; ++u) {
+			(*pointTimeOffsets)[v * msg.width + u] = time.toOffset(rowData + u * msg.point_step);
+		}
+	}
+	return true;
+}
+
+bool rosToRangeImage(const sensor_msgs::PointCloud2 &msg, const RangeImageParameters &params, RangeImage *image) {
+	const auto *x = findField(msg, "x");
+	const auto *y = findField(msg, "y");
+	const auto *z = findField(msg, "z");
+	const auto *ring = findField(msg, "ring");
+	if (x == nullptr || y == nullptr || z == nullptr) {
+		return false;
+	}
+	const bool isOrganized = msg.height > 1;
+	if (!isOrganized && ring == nullptr) {
+		return false;
+	}
+
+	const TimeField time = findTimeField(msg);
+
+	const size_t numPoints = static_cast<size_t>(msg.width) * msg.height;
+	int numRows = msg.height;
+	int numCols = msg.width;
+	if (!isOrganized) {
+		int maxRing = -1;
+		for (size_t i = 0; i < numPoints; ++i) {
+			maxRing = std::max(maxRing, static_cast<int>(readField(&msg.data[i * msg.point_step], *ring)));
+		}
+		numRows = maxRing + 1;
+		numCols = params.numColumns_;
+	}
+	if (numRows <= 0 || numCols <= 0) {
+		return false;
+	}
+
+	image->resize(numRows, numCols);
+	for (uint32_t v = 0; v < msg.height; ++v) {
+		const uint8_t *rowData = &msg.data[v * msg.row_step];
+		for (uint32_t u = 0; u < msg.width; ++u) {
+			const uint8_t *data = rowData + u * msg.point_step;
+			const Eigen::Vector3d p(readField(data, *x), readField(data, *y), readField(data, *z));
+			if (!p.allFinite() || p.isZero()) {
+				continue;
+			}
+			const double timeOffset = time.toOffset(data);
+			if (isOrganized) {
+				image->setPoint(v, u, p, timeOffset);
+			} else {
+				const int row = static_cast<int>(readField(data, *ring));
+				if (row >= 0 && row < numRows) {
+					image->setPoint(row, image->getColumnFromAzimuth(p), p, timeOffset);
+				}
+			}
+		}
+	}
+	return true;
+}
+
 void publishTfTransform(const Eigen::Matrix4d &Mat, const ros::Time &time, const std::string &frame,
 		const std::string &childFrame, tf2_ros::TransformBroadcaster *broadcaster) {
 	geometry_msgs::TransformStamped transformStamped = o3d_slam::toRos(Mat, time, frame, childFrame);